@@ -2,13 +2,17 @@
 set(APP_SOURCES
     ${CMAKE_CURRENT_SOURCE_DIR}/src/app/SIDBlasterApp.cpp
     ${CMAKE_CURRENT_SOURCE_DIR}/src/app/CommandProcessor.cpp
+    ${CMAKE_CURRENT_SOURCE_DIR}/src/app/JobServer.cpp
     ${CMAKE_CURRENT_SOURCE_DIR}/src/app/MusicBuilder.cpp
-    ${CMAKE_CURRENT_SOURCE_DIR}/src/app/TraceLogger.cpp
+    ${CMAKE_CURRENT_SOURCE_DIR}/src/app/FileWatcher.cpp
+    ${CMAKE_CURRENT_SOURCE_DIR}/src/app/PlayerWatcher.cpp
 )
 
 set(APP_HEADERS
     ${CMAKE_CURRENT_SOURCE_DIR}/src/app/SIDBlasterApp.h
     ${CMAKE_CURRENT_SOURCE_DIR}/src/app/CommandProcessor.h
+    ${CMAKE_CURRENT_SOURCE_DIR}/src/app/JobServer.h
     ${CMAKE_CURRENT_SOURCE_DIR}/src/app/MusicBuilder.h
-    ${CMAKE_CURRENT_SOURCE_DIR}/src/app/TraceLogger.h
+    ${CMAKE_CURRENT_SOURCE_DIR}/src/app/FileWatcher.h
+    ${CMAKE_CURRENT_SOURCE_DIR}/src/app/PlayerWatcher.h
 )
\ No newline at end of file
@@ -0,0 +1,521 @@
+// ==================================
+//             SIDBlaster
+//
+//  Raistlin / Genesis Project (G*P)
+// ==================================
+#include "Common.h"
+#include "cpu6510.h"
+#include "Disassembler.h"
+#include "SIDBlasterUtils.h"
+#include "SIDEmulator.h"
+#include "SIDLoader.h"
+#include "app/TraceLogger.h"
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <optional>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+/**
+ * @file SIDBlasterBench.cpp
+ * @brief Benchmark runner for the emulator and disassembly pipeline
+ *
+ * Runs every SID file in a corpus directory through a fixed set of
+ * workloads, repeats each one several times and reports the median and
+ * median absolute deviation of the wall-clock time as JSON:
+ *
+ *   execute           Raw play-routine calls through CPU6510::executeFunction
+ *   emulate           SIDEmulator::runEmulation without register tracking
+ *   emulate_tracking  SIDEmulator::runEmulation with register tracking
+ *   disassemble       Disassembler::generateAsmFile after an emulation run
+ *   trace_encode      SIDEmulator::runEmulation writing a binary trace
+ *   trace_compare     TraceLogger::compareTraceLogs on that trace
+ */
+
+namespace fs = std::filesystem;
+using namespace sidblaster;
+
+namespace {
+
+    /**
+     * @brief Benchmark settings from the command line
+     */
+    struct BenchOptions {
+        fs::path corpus = "SID";                          // Directory of SID files
+        fs::path output;                                  // JSON output file (stdout if empty)
+        std::string filter;                               // Only files whose name contains this
+        std::vector<std::string> workloads;               // Workloads to run (all if empty)
+        int repetitions = 5;                              // Timed runs per workload
+        int executeFrames = 30000;                        // Play calls for the execute workload
+        int emulationFrames = DEFAULT_SID_EMULATION_FRAMES; // Frames for runEmulation workloads
+    };
+
+    /**
+     * @brief Timings and counters collected for one workload on one file
+     */
+    struct WorkloadResult {
+        std::vector<double> seconds;                      // Wall-clock time of each repetition
+        u64 instructions = 0;                             // Instructions executed per repetition (0 = not measured)
+        u64 cycles = 0;                                   // Emulated cycles per repetition (0 = not measured)
+    };
+
+    /**
+     * @brief A freshly loaded tune with its own CPU
+     */
+    struct LoadedTune {
+        std::unique_ptr<CPU6510> cpu;
+        std::unique_ptr<SIDLoader> sid;
+    };
+
+    using Clock = std::chrono::steady_clock;
+
+    /**
+     * @brief Seconds elapsed since a start point
+     */
+    double secondsSince(Clock::time_point start) {
+        return std::chrono::duration<double>(Clock::now() - start).count();
+    }
+
+    /**
+     * @brief Median of a set of samples
+     * @param samples Samples (taken by value, reordered)
+     * @return Median, or 0 if there are no samples
+     */
+    double median(std::vector<double> samples) {
+        if (samples.empty()) {
+            return 0.0;
+        }
+        const size_t mid = samples.size() / 2;
+        std::nth_element(samples.begin(), samples.begin() + mid, samples.end());
+        if (samples.size() % 2 != 0) {
+            return samples[mid];
+        }
+        const double upper = samples[mid];
+        const double lower = *std::max_element(samples.begin(), samples.begin() + mid);
+        return (lower + upper) / 2.0;
+    }
+
+    /**
+     * @brief Median absolute deviation of a set of samples
+     * @param samples Samples
+     * @return MAD, or 0 if there are no samples
+     */
+    double medianAbsoluteDeviation(const std::vector<double>& samples) {
+        const double center = median(samples);
+        std::vector<double> deviations;
+        deviations.reserve(samples.size());
+        for (double sample : samples) {
+            deviations.push_back(std::fabs(sample - center));
+        }
+        return median(std::move(deviations));
+    }
+
+    /**
+     * @brief Escape a string for inclusion in JSON
+     */
+    std::string jsonString(const std::string& text) {
+        std::string escaped = "\"";
+        for (char c : text) {
+            switch (c) {
+            case '"':  escaped += "\\\""; break;
+            case '\\': escaped += "\\\\"; break;
+            case '\n': escaped += "\\n"; break;
+            case '\t': escaped += "\\t"; break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20) {
+                    std::ostringstream code;
+                    code << "\\u" << std::hex << std::setw(4) << std::setfill('0') << static_cast<int>(c);
+                    escaped += code.str();
+                }
+                else {
+                    escaped += c;
+                }
+            }
+        }
+        return escaped + "\"";
+    }
+
+    /**
+     * @brief Load a SID file into a new CPU
+     * @param file SID file path
+     * @return Loaded tune, or nullopt if loading failed
+     */
+    std::optional<LoadedTune> loadTune(const fs::path& file) {
+        LoadedTune tune;
+        tune.cpu = std::make_unique<CPU6510>();
+        tune.cpu->reset();
+        tune.sid = std::make_unique<SIDLoader>();
+        tune.sid->setCPU(tune.cpu.get());
+        if (!tune.sid->loadSID(file.string())) {
+            return std::nullopt;
+        }
+        return tune;
+    }
+
+    /**
+     * @brief Time raw play-routine calls
+     *
+     * The init routine runs once and the resulting state is snapshotted, so
+     * every repetition executes exactly the same instructions. The
+     * instruction count comes from one extra run with the heat map enabled,
+     * outside the timed repetitions.
+     */
+    bool benchExecute(const fs::path& file, const BenchOptions& options, WorkloadResult& result) {
+        auto tune = loadTune(file);
+        if (!tune) {
+            return false;
+        }
+
+        CPU6510& cpu = *tune->cpu;
+        const u16 playAddr = tune->sid->getPlayAddress();
+        cpu.resetRegistersAndFlags();
+        cpu.executeFunction(tune->sid->getInitAddress());
+
+        auto start = std::make_unique<CPUSnapshot>();
+        cpu.captureSnapshot(*start);
+
+        const auto runPlayCalls = [&]() {
+            cpu.restoreSnapshot(*start);
+            for (int frame = 0; frame < options.executeFrames; ++frame) {
+                cpu.resetRegistersAndFlags();
+                if (!cpu.executeFunction(playAddr)) {
+                    return false;
+                }
+            }
+            return true;
+        };
+
+        for (int rep = 0; rep < options.repetitions; ++rep) {
+            const auto begin = Clock::now();
+            if (!runPlayCalls()) {
+                return false;
+            }
+            result.seconds.push_back(secondsSince(begin));
+        }
+        result.cycles = cpu.getCycles() - start->cycles;
+
+        cpu.setHeatMapEnabled(true);
+        runPlayCalls();
+        cpu.setHeatMapEnabled(false);
+        for (u32 count : cpu.getHeatMap()->executions) {
+            result.instructions += count;
+        }
+        return true;
+    }
+
+    /**
+     * @brief Time full emulation runs, optionally followed by disassembly
+     * @param tracking Whether to enable SID register tracking
+     * @param disassembly Receives disassembly timings (nullptr to skip)
+     */
+    bool benchEmulate(const fs::path& file, const BenchOptions& options, const fs::path& tempDir,
+        bool tracking, WorkloadResult& result, WorkloadResult* disassembly) {
+        for (int rep = 0; rep < options.repetitions; ++rep) {
+            auto tune = loadTune(file);
+            if (!tune) {
+                return false;
+            }
+
+            // As in CommandProcessor, the disassembler exists before the emulation
+            // so its callback records the indirect accesses the relocation needs
+            std::optional<Disassembler> disassembler;
+            if (disassembly) {
+                disassembler.emplace(*tune->cpu, *tune->sid);
+            }
+
+            SIDEmulator emulator(tune->cpu.get(), tune->sid.get());
+            SIDEmulator::EmulationOptions emulationOptions;
+            emulationOptions.frames = options.emulationFrames;
+            emulationOptions.registerTrackingEnabled = tracking;
+
+            const auto begin = Clock::now();
+            if (!emulator.runEmulation(emulationOptions)) {
+                return false;
+            }
+            result.seconds.push_back(secondsSince(begin));
+
+            if (disassembler) {
+                SIDLoader& sid = *tune->sid;
+                sid.restoreMemory();
+
+                const auto disassemblyBegin = Clock::now();
+                if (disassembler->generateAsmFile((tempDir / "bench.asm").string(),
+                    sid.getLoadAddress(), sid.getInitAddress(), sid.getPlayAddress()) < 0) {
+                    return false;
+                }
+                disassembly->seconds.push_back(secondsSince(disassemblyBegin));
+            }
+        }
+        return true;
+    }
+
+    /**
+     * @brief Time emulation with binary trace output, then comparison of that trace
+     */
+    bool benchTrace(const fs::path& file, const BenchOptions& options, const fs::path& tempDir,
+        WorkloadResult& encode, WorkloadResult& compare) {
+        const fs::path tracePath = tempDir / "bench.trace";
+        const fs::path reportPath = tempDir / "bench-compare.txt";
+
+        for (int rep = 0; rep < options.repetitions; ++rep) {
+            auto tune = loadTune(file);
+            if (!tune) {
+                return false;
+            }
+
+            {
+                SIDEmulator emulator(tune->cpu.get(), tune->sid.get());
+                SIDEmulator::EmulationOptions emulationOptions;
+                emulationOptions.frames = options.emulationFrames;
+                emulationOptions.traceEnabled = true;
+                emulationOptions.traceFormat = TraceFormat::Binary;
+                emulationOptions.traceLogPath = tracePath.string();
+
+                // The trace is flushed when the emulator goes out of scope
+                const auto begin = Clock::now();
+                if (!emulator.runEmulation(emulationOptions)) {
+                    return false;
+                }
+                encode.seconds.push_back(secondsSince(begin));
+            }
+
+            const auto compareBegin = Clock::now();
+            if (!TraceLogger::compareTraceLogs(tracePath.string(), tracePath.string(), reportPath.string())) {
+                return false;
+            }
+            compare.seconds.push_back(secondsSince(compareBegin));
+        }
+        return true;
+    }
+
+    /**
+     * @brief Parse command line arguments
+     * @return True if the arguments were valid
+     */
+    bool parseArguments(int argc, char** argv, BenchOptions& options) {
+        for (int i = 1; i < argc; ++i) {
+            const std::string arg = argv[i];
+            const size_t equals = arg.find('=');
+            const std::string name = arg.substr(0, equals);
+            const std::string value = equals == std::string::npos ? "" : arg.substr(equals + 1);
+
+            try {
+                if (name == "-corpus") {
+                    options.corpus = value;
+                }
+                else if (name == "-out") {
+                    options.output = value;
+                }
+                else if (name == "-filter") {
+                    options.filter = value;
+                }
+                else if (name == "-workloads") {
+                    std::stringstream list(value);
+                    std::string workload;
+                    while (std::getline(list, workload, ',')) {
+                        options.workloads.push_back(workload);
+                    }
+                }
+                else if (name == "-reps") {
+                    options.repetitions = std::max(1, std::stoi(value));
+                }
+                else if (name == "-executeframes") {
+                    options.executeFrames = std::max(1, std::stoi(value));
+                }
+                else if (name == "-frames") {
+                    options.emulationFrames = std::max(1, std::stoi(value));
+                }
+                else {
+                    return false;
+                }
+            }
+            catch (const std::exception&) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /**
+     * @brief Print usage information
+     */
+    void printUsage(const char* programName) {
+        std::cerr << "Usage: " << programName << " [options]\n\n"
+            << "  -corpus=<dir>          Directory of SID files (default: SID)\n"
+            << "  -out=<file>            Write JSON results to a file (default: stdout)\n"
+            << "  -filter=<text>         Only benchmark files whose name contains <text>\n"
+            << "  -workloads=<a,b,...>   Workloads to run (default: all)\n"
+            << "                         execute, emulate, emulate_tracking, disassemble,\n"
+            << "                         trace_encode, trace_compare\n"
+            << "  -reps=<n>              Timed repetitions per workload (default: 5)\n"
+            << "  -executeframes=<n>     Play calls for the execute workload (default: 30000)\n"
+            << "  -frames=<n>            Frames for the emulation workloads (default: "
+            << DEFAULT_SID_EMULATION_FRAMES << ")\n";
+    }
+
+    /**
+     * @brief Write one workload result as a JSON object
+     */
+    void writeResult(std::ostream& out, const std::string& file, const std::string& workload,
+        const WorkloadResult& result) {
+        const double med = median(result.seconds);
+
+        out << "    { \"file\": " << jsonString(file)
+            << ", \"workload\": " << jsonString(workload)
+            << ", \"repetitions\": " << result.seconds.size()
+            << ", \"median_seconds\": " << med
+            << ", \"mad_seconds\": " << medianAbsoluteDeviation(result.seconds);
+
+        if (result.instructions > 0) {
+            out << ", \"instructions\": " << result.instructions;
+            if (med > 0.0) {
+                out << ", \"instructions_per_second\": " << static_cast<double>(result.instructions) / med;
+            }
+        }
+        if (result.cycles > 0) {
+            out << ", \"cycles\": " << result.cycles;
+            if (med > 0.0) {
+                out << ", \"cycles_per_second\": " << static_cast<double>(result.cycles) / med;
+            }
+        }
+
+        out << ", \"samples\": [";
+        for (size_t i = 0; i < result.seconds.size(); ++i) {
+            out << (i > 0 ? ", " : "") << result.seconds[i];
+        }
+        out << "] }";
+    }
+
+} // namespace
+
+/**
+ * @brief Benchmark entry point
+ *
+ * @param argc Number of command line arguments
+ * @param argv Array of command line argument strings
+ * @return Exit code (0 on success, 1 on error)
+ */
+int main(int argc, char** argv) {
+    BenchOptions options;
+    if (!parseArguments(argc, argv, options)) {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    // Keep the emulator quiet; failures are reported per file below
+    util::Logger::setLogLevel(util::Logger::Level::Error);
+
+    const auto wants = [&options](const std::string& workload) {
+        return options.workloads.empty() ||
+            std::find(options.workloads.begin(), options.workloads.end(), workload) != options.workloads.end();
+    };
+
+    std::vector<fs::path> files;
+    std::error_code ec;
+    for (const auto& entry : fs::directory_iterator(options.corpus, ec)) {
+        const fs::path& path = entry.path();
+        std::string extension = path.extension().string();
+        std::transform(extension.begin(), extension.end(), extension.begin(),
+            [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+        if (extension == ".sid" &&
+            path.filename().string().find(options.filter) != std::string::npos) {
+            files.push_back(path);
+        }
+    }
+    if (ec || files.empty()) {
+        std::cerr << "No SID files found in " << options.corpus.string() << std::endl;
+        return 1;
+    }
+    std::sort(files.begin(), files.end());
+
+    // A directory of its own, so concurrent runs do not delete each other's files
+    fs::path tempDir;
+    std::random_device random;
+    do {
+        tempDir = fs::temp_directory_path() / ("sidblaster_bench-" + std::to_string(random()));
+    } while (!fs::create_directory(tempDir, ec) && !ec);
+    if (ec) {
+        std::cerr << "Cannot create a temporary directory: " << ec.message() << std::endl;
+        return 1;
+    }
+
+    std::ostringstream results;
+    results << std::setprecision(9);
+    bool first = true;
+    int failures = 0;
+
+    for (const auto& file : files) {
+        const std::string name = file.filename().string();
+        std::cerr << name << std::endl;
+
+        std::map<std::string, WorkloadResult> workloads;
+        bool ok = true;
+
+        if (wants("execute")) {
+            ok = ok && benchExecute(file, options, workloads["execute"]);
+        }
+        if (wants("emulate") || wants("disassemble")) {
+            ok = ok && benchEmulate(file, options, tempDir, false, workloads["emulate"],
+                wants("disassemble") ? &workloads["disassemble"] : nullptr);
+        }
+        if (wants("emulate_tracking")) {
+            ok = ok && benchEmulate(file, options, tempDir, true, workloads["emulate_tracking"], nullptr);
+        }
+        if (wants("trace_encode") || wants("trace_compare")) {
+            ok = ok && benchTrace(file, options, tempDir, workloads["trace_encode"], workloads["trace_compare"]);
+        }
+
+        if (!ok) {
+            std::cerr << "  failed, skipping" << std::endl;
+            ++failures;
+            continue;
+        }
+
+        for (const auto& [workload, result] : workloads) {
+            if (!wants(workload)) {
+                continue;
+            }
+            results << (first ? "" : ",\n");
+            writeResult(results, name, workload, result);
+            first = false;
+        }
+    }
+
+    fs::remove_all(tempDir, ec);
+
+    std::ostringstream json;
+    json << "{\n"
+        << "  \"version\": " << jsonString(SIDBLASTER_VERSION) << ",\n"
+        << "  \"timestamp\": " << std::time(nullptr) << ",\n"
+        << "  \"repetitions\": " << options.repetitions << ",\n"
+        << "  \"execute_frames\": " << options.executeFrames << ",\n"
+        << "  \"emulation_frames\": " << options.emulationFrames << ",\n"
+        << "  \"results\": [\n" << results.str() << "\n  ]\n"
+        << "}\n";
+
+    if (options.output.empty()) {
+        std::cout << json.str();
+    }
+    else {
+        std::ofstream out(options.output);
+        if (!out || !(out << json.str())) {
+            std::cerr << "Failed to write " << options.output.string() << std::endl;
+            return 1;
+        }
+    }
+
+    return failures == 0 ? 0 : 1;
+}
@@ -5,7 +5,6 @@
 #include <fstream>
 #include <iomanip>
 #include <iostream>
-#include <set>
 #include <sstream>
 
 /**
@@ -17,7 +16,9 @@ CPU6510Impl::CPU6510Impl()
     : cpuState_(*this),
     memory_(*this),
     instructionExecutor_(*this),
-    addressingModes_(*this)
+    addressingModes_(*this),
+    indexMin_(65536, 0),
+    indexMax_(65536, 0)
 {
     reset();
 }
@@ -44,6 +45,8 @@ void CPU6510Impl::reset() {
     onCIAWriteCallback_ = nullptr;
     onSIDWriteCallback_ = nullptr;
     onVICWriteCallback_ = nullptr;
+    onSubroutineCallCallback_ = nullptr;
+    onSubroutineReturnCallback_ = nullptr;
 }
 
 void CPU6510Impl::resetRegistersAndFlags() {
@@ -70,10 +73,17 @@ void CPU6510Impl::step() {
     cpuState_.incrementPC();
 
     const OpcodeInfo& info = opcodeTable_[opcode];
+    const u64 startCycles = cpuState_.getCycles();
 
     instructionExecutor_.execute(info.instruction, info.mode);
 
     cpuState_.addCycles(info.cycles);
+    instructionCount_++;
+
+    if (heatMapEnabled_) {
+        heatMap_.executions[originalPc_]++;
+        heatMap_.cycles[originalPc_] += cpuState_.getCycles() - startCycles;
+    }
 }
 
 /**
@@ -95,9 +105,8 @@ bool CPU6510Impl::executeFunction(u16 address) {
     u16 pcHistory[HISTORY_SIZE] = { 0 };
     int historyIndex = 0;
 
-    // Track potentially dangerous jump targets
-    bool jumpToZeroPageTracked = false;
-    std::set<u16> reportedProblematicJumps;
+    // Zero page execution is counted once per call
+    bool zeroPageExecutionCounted = false;
 
     // Simulate JSR manually
     const u16 returnAddress = cpuState_.getPC() - 1; // What JSR would have pushed (the address of the last byte of JSR instruction)
@@ -108,91 +117,74 @@ bool CPU6510Impl::executeFunction(u16 address) {
     cpuState_.setPC(address);
 
     const u8 targetSP = cpuState_.getSP(); // After pushing return address (so after manual JSR)
-    sidblaster::util::Logger::debug("Executing function at $" + sidblaster::util::wordToHex(address) +
-        ", initial SP: $" + sidblaster::util::byteToHex(cpuState_.getSP()));
+
+    // Debug messages are only built when they will be logged; this runs for every play call
+    const bool debugLogging = sidblaster::util::Logger::isEnabled(sidblaster::util::Logger::Level::Debug);
+    if (debugLogging) {
+        sidblaster::util::Logger::debug("Executing function at $" + sidblaster::util::wordToHex(address) +
+            ", initial SP: $" + sidblaster::util::byteToHex(cpuState_.getSP()));
+    }
 
     while (stepCount < MAX_STEPS) {
         const u16 currentPC = cpuState_.getPC();
+        const u8 sp = cpuState_.getSP();
 
         // Track PC history for loop detection
         pcHistory[historyIndex] = currentPC;
         historyIndex = (historyIndex + 1) % HISTORY_SIZE;
 
-        // Check for problematic PC values
-        if (currentPC < 0x0002) {  // $00 or $01 is definitely a problem
-            sidblaster::util::Logger::error("CRITICAL: Execution at $" +
-                sidblaster::util::wordToHex(currentPC) +
-                " detected - illegal jump target");
-            // Break to avoid immediate crash
-            return false;
-        }
-        else if (currentPC < 0x0100 && !jumpToZeroPageTracked) {  // Any zero page execution
-            sidblaster::util::Logger::warning("Zero page execution detected at $" +
-                sidblaster::util::wordToHex(currentPC));
-            jumpToZeroPageTracked = true; // Only log once to avoid spam
+        // Unusual conditions are counted in diagnostics_ and summarized by the
+        // caller; normally each check below is a single branch that is not taken
+        if (currentPC < 0x0100) {
+            if (currentPC < 0x0002) {  // $00 or $01 is definitely a problem
+                sidblaster::util::Logger::error("CRITICAL: Execution at $" +
+                    sidblaster::util::wordToHex(currentPC) +
+                    " detected - illegal jump target");
+                // Break to avoid immediate crash
+                return false;
+            }
+            if (!zeroPageExecutionCounted) {
+                diagnostics_.record(ExecutionDiagnostics::Event::ZeroPageExecution, currentPC, sp);
+                zeroPageExecutionCounted = true;
+            }
         }
 
-        // Check for stack issues
-        if (cpuState_.getSP() < 0xA0) {  // Potential stack overflow
-            sidblaster::util::Logger::warning("Low stack pointer: $" +
-                sidblaster::util::byteToHex(cpuState_.getSP()) +
-                " at PC: $" + sidblaster::util::wordToHex(currentPC));
+        if (sp < 0xA0) {  // Potential stack overflow
+            diagnostics_.record(ExecutionDiagnostics::Event::LowStack, currentPC, sp);
         }
 
         // Fetch the opcode
         const u8 opcode = fetchOpcode(currentPC);
 
-        // Special handling for key instructions even when tracing is disabled
-        const auto mode = getAddressingMode(opcode);
-        const int size = getInstructionSize(opcode);
-
-        // Track JMP and JSR instructions to potentially problematic addresses
-        if (size == 3 && (opcode == 0x4C || opcode == 0x20)) { // JMP or JSR
+        if (opcode == 0x4C || opcode == 0x20) { // JMP or JSR (absolute)
             const u16 operand = memory_.getMemoryAt(currentPC + 1) |
                 (memory_.getMemoryAt(currentPC + 2) << 8);
 
-            // Check for jumps to very low addresses
-            if (operand < 0x0002 &&
-                reportedProblematicJumps.find(operand) == reportedProblematicJumps.end()) {
-
-                sidblaster::util::Logger::error("CRITICAL: " + std::string(getMnemonic(opcode)) +
-                    " at $" + sidblaster::util::wordToHex(currentPC) +
-                    " to illegal address $" +
-                    sidblaster::util::wordToHex(operand));
-                reportedProblematicJumps.insert(operand);
-                return false;
-            }
-            else if (operand < 0x0100 &&
-                reportedProblematicJumps.find(operand) == reportedProblematicJumps.end()) {
-
-                sidblaster::util::Logger::warning("Suspicious " + std::string(getMnemonic(opcode)) +
-                    " at $" + sidblaster::util::wordToHex(currentPC) +
-                    " to zero page $" +
-                    sidblaster::util::wordToHex(operand));
-                reportedProblematicJumps.insert(operand);
+            if (operand < 0x0100) {
+                if (operand < 0x0002) {
+                    sidblaster::util::Logger::error("CRITICAL: " + std::string(getMnemonic(opcode)) +
+                        " at $" + sidblaster::util::wordToHex(currentPC) +
+                        " to illegal address $" +
+                        sidblaster::util::wordToHex(operand));
+                    return false;
+                }
+                diagnostics_.record(ExecutionDiagnostics::Event::SuspiciousJump, currentPC, sp, operand);
             }
         }
+        else if (opcode == 0x60 && sp < 0xFC) { // RTS, if the return address can be read safely
+            const u8 lo = memory_.getMemoryAt(0x0100 + sp + 1);
+            const u8 hi = memory_.getMemoryAt(0x0100 + sp + 2);
+            const u16 returnAddr = (hi << 8) | lo;
 
-        // Track RTS instructions to check return addresses
-        if (opcode == 0x60) { // RTS
-            if (cpuState_.getSP() < 0xFC) { // Make sure we can safely read from stack
-                const u8 lo = memory_.getMemoryAt(0x0100 + cpuState_.getSP() + 1);
-                const u8 hi = memory_.getMemoryAt(0x0100 + cpuState_.getSP() + 2);
-                const u16 returnAddr = (hi << 8) | lo;
-
-                // Log suspicious return addresses
-                if (returnAddr < 0x0100) {
-                    sidblaster::util::Logger::warning("RTS with suspicious return address: $" +
-                        sidblaster::util::wordToHex(returnAddr) +
-                        ", SP: $" + sidblaster::util::byteToHex(cpuState_.getSP()));
-                }
+            if (returnAddr < 0x0100) {
+                diagnostics_.record(ExecutionDiagnostics::Event::SuspiciousReturn, currentPC, sp, returnAddr);
+            }
 
-                // Check if this is our function's return
-                if (cpuState_.getSP() == targetSP) {
-                    sidblaster::util::Logger::debug("Function returning to $" +
-                        sidblaster::util::wordToHex(returnAddr + 1) +
-                        " after " + std::to_string(stepCount) + " steps");
-                }
+            // Check if this is our function's return
+            if (debugLogging && sp == targetSP) {
+                sidblaster::util::Logger::debug("Function returning to $" +
+                    sidblaster::util::wordToHex(returnAddr + 1) +
+                    " after " + std::to_string(stepCount) + " steps");
             }
         }
 
@@ -200,10 +192,20 @@ bool CPU6510Impl::executeFunction(u16 address) {
         step();
         stepCount++;
 
+        // Report subroutine entry/exit (only costs a branch when nobody is listening)
+        if (opcode == 0x20 && onSubroutineCallCallback_) { // JSR
+            onSubroutineCallCallback_(cpuState_.getPC(), cpuState_.getSP(), cpuState_.getCycles());
+        }
+        else if (opcode == 0x60 && onSubroutineReturnCallback_) { // RTS
+            onSubroutineReturnCallback_(cpuState_.getSP(), cpuState_.getCycles());
+        }
+
         // Check if we've returned from the function
         if (opcode == 0x60) { // RTS
             if (cpuState_.getSP() == targetSP + 2) { // Stack unwound
-                sidblaster::util::Logger::debug("Function returned after " + std::to_string(stepCount) + " steps");
+                if (debugLogging) {
+                    sidblaster::util::Logger::debug("Function returned after " + std::to_string(stepCount) + " steps");
+                }
                 break;
             }
         }
@@ -240,6 +242,61 @@ void CPU6510Impl::jumpTo(u16 address) {
     cpuState_.setPC(address);
 }
 
+/**
+ * @brief Get the recorded occurrences of an event
+ *
+ * @param event Event type
+ * @return Up to MaxRecorded occurrences, oldest first
+ */
+std::span<const ExecutionDiagnostics::Occurrence> ExecutionDiagnostics::occurrences(Event event) const {
+    const size_t index = static_cast<size_t>(event);
+    return std::span<const Occurrence>(recorded_[index].data(),
+        static_cast<size_t>(std::min<u64>(counts_[index], MaxRecorded)));
+}
+
+/**
+ * @brief Check whether no events were recorded
+ *
+ * @return True if every count is zero
+ */
+bool ExecutionDiagnostics::empty() const {
+    return std::all_of(counts_.begin(), counts_.end(), [](u64 count) { return count == 0; });
+}
+
+/**
+ * @brief Log one warning per event type that occurred
+ *
+ * Each warning gives the total count and the context of the first few
+ * occurrences.
+ */
+void ExecutionDiagnostics::logSummary() const {
+    static constexpr const char* descriptions[EventCount] = {
+        "instructions executed with a low stack pointer",
+        "calls executed code in zero page",
+        "JMP/JSR instructions targeted zero page",
+        "RTS instructions returned below $0100"
+    };
+
+    for (size_t index = 0; index < EventCount; ++index) {
+        if (counts_[index] == 0) {
+            continue;
+        }
+
+        const Event event = static_cast<Event>(index);
+        std::string message = std::to_string(counts_[index]) + " " + descriptions[index] + " (first at";
+        for (const auto& occurrence : occurrences(event)) {
+            message += " PC $" + sidblaster::util::wordToHex(occurrence.pc) +
+                " SP $" + sidblaster::util::byteToHex(occurrence.sp);
+            if (event == Event::SuspiciousJump || event == Event::SuspiciousReturn) {
+                message += " -> $" + sidblaster::util::wordToHex(occurrence.target);
+            }
+            message += ",";
+        }
+        message.back() = ')';
+        sidblaster::util::Logger::warning(message);
+    }
+}
+
 /**
  * @brief Read a byte from memory
  *
@@ -394,6 +451,18 @@ void CPU6510Impl::setCycles(u64 newCycles) {
     cpuState_.setCycles(newCycles);
 }
 
+/**
+ * @brief Get the number of instructions executed
+ *
+ * Unlike the cycle counter this is not cleared by reset(), so it can be
+ * sampled around any piece of work.
+ *
+ * @return Instructions executed since construction
+ */
+u64 CPU6510Impl::getInstructionCount() const {
+    return instructionCount_;
+}
+
 /**
  * @brief Reset the CPU cycle counter to zero
  *
@@ -461,6 +530,7 @@ u8 CPU6510Impl::readByAddressingMode(u16 addr, AddressingMode mode) {
  */
 void CPU6510Impl::push(u8 value) {
     memory_.writeByte(0x0100 + cpuState_.getSP(), value);
+    memory_.setTaint(0x0100 + cpuState_.getSP(), TaintTag{});
     cpuState_.decrementSP();
 }
 
@@ -579,7 +649,26 @@ bool CPU6510Impl::isIllegalInstruction(u8 opcode) const {
  * @param offset Index offset value (X or Y register)
  */
 void CPU6510Impl::recordIndexOffset(u16 pc, u8 offset) {
-    pcIndexRanges_[pc].update(offset);
+    if (!indexSeen_.test(pc)) {
+        indexSeen_.set(pc);
+        indexMin_[pc] = offset;
+        indexMax_[pc] = offset;
+    }
+    else if (offset < indexMin_[pc]) {
+        indexMin_[pc] = offset;
+    }
+    else if (offset > indexMax_[pc]) {
+        indexMax_[pc] = offset;
+    }
+
+    if (indexHistogramEnabled_) {
+        u32& slot = indexHistogramSlot_[pc];
+        if (slot == NoHistogram) {
+            slot = static_cast<u32>(indexHistograms_.size());
+            indexHistograms_.emplace_back();
+        }
+        ++indexHistograms_[slot][offset];
+    }
 }
 
 /**
@@ -589,11 +678,97 @@ void CPU6510Impl::recordIndexOffset(u16 pc, u8 offset) {
  * @return A pair containing the minimum and maximum index offsets used
  */
 std::pair<u8, u8> CPU6510Impl::getIndexRange(u16 pc) const {
-    auto it = pcIndexRanges_.find(pc);
-    if (it == pcIndexRanges_.end()) {
+    if (!indexSeen_.test(pc)) {
         return { 0, 0 };
     }
-    return it->second.getRange();
+    return { indexMin_[pc], indexMax_[pc] };
+}
+
+/**
+ * @brief Enable or disable per-instruction index histograms
+ *
+ * Histograms are only collected for accesses made while enabled.
+ *
+ * @param enabled Whether to count every index value used by each instruction
+ */
+void CPU6510Impl::setIndexHistogramEnabled(bool enabled) {
+    indexHistogramEnabled_ = enabled;
+    if (enabled && indexHistogramSlot_.empty()) {
+        indexHistogramSlot_.assign(65536, NoHistogram);
+    }
+}
+
+/**
+ * @brief Get how often each index value was used by an instruction
+ *
+ * @param pc Program counter of the instruction
+ * @return 256 counts, or an empty span if no histogram was recorded
+ */
+std::span<const u32> CPU6510Impl::getIndexHistogram(u16 pc) const {
+    if (indexHistogramSlot_.empty() || indexHistogramSlot_[pc] == NoHistogram) {
+        return {};
+    }
+    return indexHistograms_[indexHistogramSlot_[pc]];
+}
+
+/**
+ * @brief Capture registers and memory
+ *
+ * @param snapshot Snapshot to fill in
+ */
+void CPU6510Impl::captureSnapshot(CPUSnapshot& snapshot) const {
+    snapshot.pc = cpuState_.getPC();
+    snapshot.sp = cpuState_.getSP();
+    snapshot.a = cpuState_.getA();
+    snapshot.x = cpuState_.getX();
+    snapshot.y = cpuState_.getY();
+    snapshot.status = cpuState_.getStatus();
+    snapshot.cycles = cpuState_.getCycles();
+
+    const auto memory = memory_.getMemory();
+    std::copy(memory.begin(), memory.end(), snapshot.memory.begin());
+}
+
+/**
+ * @brief Restore registers and memory from a snapshot
+ *
+ * Access tracking, data flow and heat map counters are left untouched.
+ *
+ * @param snapshot Snapshot to restore
+ */
+void CPU6510Impl::restoreSnapshot(const CPUSnapshot& snapshot) {
+    cpuState_.setPC(snapshot.pc);
+    cpuState_.setSP(snapshot.sp);
+    cpuState_.setA(snapshot.a);
+    cpuState_.setX(snapshot.x);
+    cpuState_.setY(snapshot.y);
+    cpuState_.setStatus(snapshot.status);
+    cpuState_.setCycles(snapshot.cycles);
+    memory_.copyMemoryBlock(0, snapshot.memory);
+}
+
+/**
+ * @brief Start or stop collecting per-address execution and access counts
+ *
+ * The counters are allocated the first time the heat map is enabled.
+ *
+ * @param enabled Whether to update the heat map
+ */
+void CPU6510Impl::setHeatMapEnabled(bool enabled) {
+    if (enabled && !heatMap_.isAllocated()) {
+        heatMap_.allocate();
+    }
+    heatMapEnabled_ = enabled;
+    memory_.setHeatMap(enabled ? &heatMap_ : nullptr);
+}
+
+/**
+ * @brief Get the collected heat map
+ *
+ * @return Heat map, or nullptr if it was never enabled
+ */
+const HeatMap* CPU6510Impl::getHeatMap() const {
+    return heatMap_.isAllocated() ? &heatMap_ : nullptr;
 }
 
 /**
@@ -646,40 +821,13 @@ const std::vector<u16>& CPU6510Impl::getLastWriteToAddr() const {
 }
 
 /**
- * @brief Get the source information for the A register
- *
- * @return Register source information for the accumulator
- */
-RegisterSourceInfo CPU6510Impl::getRegSourceA() const {
-    return cpuState_.getRegSourceA();
-}
-
-/**
- * @brief Get the source information for the X register
+ * @brief Get the taint tag of a memory byte
  *
- * @return Register source information for the X index register
+ * @param addr Memory address
+ * @return Origin of the value last stored there by the program
  */
-RegisterSourceInfo CPU6510Impl::getRegSourceX() const {
-    return cpuState_.getRegSourceX();
-}
-
-/**
- * @brief Get the source information for the Y register
- *
- * @return Register source information for the Y index register
- */
-RegisterSourceInfo CPU6510Impl::getRegSourceY() const {
-    return cpuState_.getRegSourceY();
-}
-
-/**
- * @brief Get the source information for a memory write
- *
- * @param addr Memory address to check
- * @return Register source information for the last write to the address
- */
-RegisterSourceInfo CPU6510Impl::getWriteSourceInfo(u16 addr) const {
-    return memory_.getWriteSourceInfo(addr);
+TaintTag CPU6510Impl::getTaint(u16 addr) const {
+    return memory_.getTaint(addr);
 }
 
 /**
@@ -727,6 +875,24 @@ void CPU6510Impl::setOnVICWriteCallback(MemoryWriteCallback callback) {
     onVICWriteCallback_ = std::move(callback);
 }
 
-const MemoryDataFlow& CPU6510Impl::getMemoryDataFlow() const {
-    return memory_.getMemoryDataFlow();
-}
\ No newline at end of file
+/**
+ * @brief Set the callback for subroutine calls
+ *
+ * Only JSRs executed inside executeFunction are reported.
+ *
+ * @param callback Function to be called after a JSR, with the target, SP and cycle count
+ */
+void CPU6510Impl::setOnSubroutineCallCallback(SubroutineCallCallback callback) {
+    onSubroutineCallCallback_ = std::move(callback);
+}
+
+/**
+ * @brief Set the callback for subroutine returns
+ *
+ * Only RTSs executed inside executeFunction are reported.
+ *
+ * @param callback Function to be called after an RTS, with the SP and cycle count
+ */
+void CPU6510Impl::setOnSubroutineReturnCallback(SubroutineReturnCallback callback) {
+    onSubroutineReturnCallback_ = std::move(callback);
+}
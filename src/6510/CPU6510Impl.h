@@ -6,7 +6,7 @@
 #include "AddressingModes.h"
 #include "CPUState.h"
 
-struct MemoryDataFlow;  // Forward declaration
+#include <bitset>
 
 /**
  * @brief Implementation class for CPU6510
@@ -49,6 +49,7 @@ public:
     u64 getCycles() const;
     void setCycles(u64 newCycles);
     void resetCycles();
+    u64 getInstructionCount() const;
 
     // Instruction information
     std::string_view getMnemonic(u8 opcode) const;
@@ -59,6 +60,14 @@ public:
     // Memory access tracking
     void dumpMemoryAccess(const std::string& filename);
     std::pair<u8, u8> getIndexRange(u16 pc) const;
+    void setIndexHistogramEnabled(bool enabled);
+    std::span<const u32> getIndexHistogram(u16 pc) const;
+    void captureSnapshot(CPUSnapshot& snapshot) const;
+    void restoreSnapshot(const CPUSnapshot& snapshot);
+    void setHeatMapEnabled(bool enabled);
+    const HeatMap* getHeatMap() const;
+    const ExecutionDiagnostics& getDiagnostics() const { return diagnostics_; }
+    void clearDiagnostics() { diagnostics_.clear(); }
 
     // Memory access
     std::span<const u8> getMemory() const;
@@ -67,26 +76,21 @@ public:
     // Accessors
     u16 getLastWriteTo(u16 addr) const;
     const std::vector<u16>& getLastWriteToAddr() const;
-    RegisterSourceInfo getRegSourceA() const;
-    RegisterSourceInfo getRegSourceX() const;
-    RegisterSourceInfo getRegSourceY() const;
-    RegisterSourceInfo getWriteSourceInfo(u16 addr) const;
-
-    /**
-     * @brief Get the memory data flow tracking information
-     * @return Reference to the memory data flow tracking
-     */
-    const MemoryDataFlow& getMemoryDataFlow() const;
+    TaintTag getTaint(u16 addr) const;
 
     // Callbacks
     using IndirectReadCallback = CPU6510::IndirectReadCallback;
     using MemoryWriteCallback = CPU6510::MemoryWriteCallback;
+    using SubroutineCallCallback = CPU6510::SubroutineCallCallback;
+    using SubroutineReturnCallback = CPU6510::SubroutineReturnCallback;
 
     void setOnIndirectReadCallback(IndirectReadCallback callback);
     void setOnWriteMemoryCallback(MemoryWriteCallback callback);
     void setOnCIAWriteCallback(MemoryWriteCallback callback);
     void setOnSIDWriteCallback(MemoryWriteCallback callback);
     void setOnVICWriteCallback(MemoryWriteCallback callback);
+    void setOnSubroutineCallCallback(SubroutineCallCallback callback);
+    void setOnSubroutineReturnCallback(SubroutineReturnCallback callback);
 
 private:
     // CPU state components
@@ -104,8 +108,26 @@ private:
     // Original PC tracking for current instruction
     u16 originalPc_ = 0;
 
-    // Index range tracking
-    std::unordered_map<u16, IndexRange> pcIndexRanges_;
+    // Index range tracking, indexed directly by instruction operand address
+    std::vector<u8> indexMin_;
+    std::vector<u8> indexMax_;
+    std::bitset<65536> indexSeen_;
+
+    // Optional per-instruction index histograms
+    static constexpr u32 NoHistogram = 0xFFFFFFFF;
+    bool indexHistogramEnabled_ = false;
+    std::vector<u32> indexHistogramSlot_;                 // Per-PC slot in indexHistograms_
+    std::vector<std::array<u32, 256>> indexHistograms_;   // One histogram per indexed instruction
+
+    // Instructions executed since construction
+    u64 instructionCount_ = 0;
+
+    // Optional execution/access counters (reads and writes are counted by memory_)
+    HeatMap heatMap_;
+    bool heatMapEnabled_ = false;
+
+    // Conditions counted by executeFunction
+    ExecutionDiagnostics diagnostics_;
 
     // Callbacks
     IndirectReadCallback onIndirectReadCallback_;
@@ -113,6 +135,8 @@ private:
     MemoryWriteCallback onCIAWriteCallback_;
     MemoryWriteCallback onSIDWriteCallback_;
     MemoryWriteCallback onVICWriteCallback_;
+    SubroutineCallCallback onSubroutineCallCallback_;
+    SubroutineReturnCallback onSubroutineReturnCallback_;
 
     // Record the index offset used for a memory access
     void recordIndexOffset(u16 pc, u8 offset);
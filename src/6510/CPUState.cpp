@@ -22,8 +22,8 @@ void CPUState::reset() {
     statusReg_ = static_cast<u8>(StatusFlag::Interrupt) | static_cast<u8>(StatusFlag::Unused);
     cycles_ = 0;
 
-    // Reset register source info
-    regSourceA_ = regSourceX_ = regSourceY_ = RegisterSourceInfo{};
+    // Reset shadow registers
+    taintA_ = taintX_ = taintY_ = TaintTag{};
 }
 
 /**
@@ -225,55 +225,55 @@ void CPUState::resetCycles() {
 }
 
 /**
- * @brief Get the source information for the A register
+ * @brief Get the taint tag of the A register
  *
- * @return Register source information for the accumulator
+ * @return Origin of the accumulator's value
  */
-RegisterSourceInfo CPUState::getRegSourceA() const {
-    return regSourceA_;
+TaintTag CPUState::getTaintA() const {
+    return taintA_;
 }
 
 /**
- * @brief Set the source information for the A register
+ * @brief Set the taint tag of the A register
  *
- * @param info Register source information
+ * @param tag Origin of the accumulator's value
  */
-void CPUState::setRegSourceA(const RegisterSourceInfo& info) {
-    regSourceA_ = info;
+void CPUState::setTaintA(TaintTag tag) {
+    taintA_ = tag;
 }
 
 /**
- * @brief Get the source information for the X register
+ * @brief Get the taint tag of the X register
  *
- * @return Register source information for the X register
+ * @return Origin of the X register's value
  */
-RegisterSourceInfo CPUState::getRegSourceX() const {
-    return regSourceX_;
+TaintTag CPUState::getTaintX() const {
+    return taintX_;
 }
 
 /**
- * @brief Set the source information for the X register
+ * @brief Set the taint tag of the X register
  *
- * @param info Register source information
+ * @param tag Origin of the X register's value
  */
-void CPUState::setRegSourceX(const RegisterSourceInfo& info) {
-    regSourceX_ = info;
+void CPUState::setTaintX(TaintTag tag) {
+    taintX_ = tag;
 }
 
 /**
- * @brief Get the source information for the Y register
+ * @brief Get the taint tag of the Y register
  *
- * @return Register source information for the Y register
+ * @return Origin of the Y register's value
  */
-RegisterSourceInfo CPUState::getRegSourceY() const {
-    return regSourceY_;
+TaintTag CPUState::getTaintY() const {
+    return taintY_;
 }
 
 /**
- * @brief Set the source information for the Y register
+ * @brief Set the taint tag of the Y register
  *
- * @param info Register source information
+ * @param tag Origin of the Y register's value
  */
-void CPUState::setRegSourceY(const RegisterSourceInfo& info) {
-    regSourceY_ = info;
+void CPUState::setTaintY(TaintTag tag) {
+    taintY_ = tag;
 }
\ No newline at end of file
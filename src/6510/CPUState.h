@@ -173,46 +173,46 @@ public:
     void resetCycles();
 
     /**
-     * @brief Get the source information for the A register
+     * @brief Get the taint tag of the A register
      *
-     * @return Register source information for the accumulator
+     * @return Origin of the accumulator's value
      */
-    RegisterSourceInfo getRegSourceA() const;
+    TaintTag getTaintA() const;
 
     /**
-     * @brief Set the source information for the A register
+     * @brief Set the taint tag of the A register
      *
-     * @param info Register source information
+     * @param tag Origin of the accumulator's value
      */
-    void setRegSourceA(const RegisterSourceInfo& info);
+    void setTaintA(TaintTag tag);
 
     /**
-     * @brief Get the source information for the X register
+     * @brief Get the taint tag of the X register
      *
-     * @return Register source information for the X register
+     * @return Origin of the X register's value
      */
-    RegisterSourceInfo getRegSourceX() const;
+    TaintTag getTaintX() const;
 
     /**
-     * @brief Set the source information for the X register
+     * @brief Set the taint tag of the X register
      *
-     * @param info Register source information
+     * @param tag Origin of the X register's value
      */
-    void setRegSourceX(const RegisterSourceInfo& info);
+    void setTaintX(TaintTag tag);
 
     /**
-     * @brief Get the source information for the Y register
+     * @brief Get the taint tag of the Y register
      *
-     * @return Register source information for the Y register
+     * @return Origin of the Y register's value
      */
-    RegisterSourceInfo getRegSourceY() const;
+    TaintTag getTaintY() const;
 
     /**
-     * @brief Set the source information for the Y register
+     * @brief Set the taint tag of the Y register
      *
-     * @param info Register source information
+     * @param tag Origin of the Y register's value
      */
-    void setRegSourceY(const RegisterSourceInfo& info);
+    void setTaintY(TaintTag tag);
 
 private:
     // Reference to CPU implementation
@@ -229,8 +229,8 @@ private:
     // Cycle count
     u64 cycles_ = 0;
 
-    // Register source tracking
-    RegisterSourceInfo regSourceA_;
-    RegisterSourceInfo regSourceX_;
-    RegisterSourceInfo regSourceY_;
+    // Shadow registers (taint tags)
+    TaintTag taintA_;
+    TaintTag taintX_;
+    TaintTag taintY_;
 };
\ No newline at end of file
@@ -183,46 +183,32 @@ void InstructionExecutor::executeLoad(Instruction instr, AddressingMode mode) {
     // Read the value using the appropriate method
     const u8 value = cpu_.readByAddressingMode(addr, mode);
 
-    // Get index register value if applicable
-    u8 index = 0;
-    if (mode == AddressingMode::AbsoluteY || mode == AddressingMode::ZeroPageY || mode == AddressingMode::IndirectY) {
-        index = cpu_.cpuState_.getY();
-    }
-    else if (mode == AddressingMode::AbsoluteX || mode == AddressingMode::ZeroPageX || mode == AddressingMode::IndirectX) {
-        index = cpu_.cpuState_.getX();
-    }
-
-    // Create register source info
-    RegisterSourceInfo sourceInfo = {
-        RegisterSourceInfo::SourceType::Memory,
-        addr,
-        value,
-        index
-    };
+    // The register takes the origin of the byte it was loaded from
+    const TaintTag taint = operandTaint(addr);
 
     // Update appropriate register based on instruction
     switch (instr) {
     case Instruction::LDA:
         cpu_.cpuState_.setA(value);
-        cpu_.cpuState_.setRegSourceA(sourceInfo);
+        cpu_.cpuState_.setTaintA(taint);
         break;
 
     case Instruction::LDX:
         cpu_.cpuState_.setX(value);
-        cpu_.cpuState_.setRegSourceX(sourceInfo);
+        cpu_.cpuState_.setTaintX(indexTaint(taint));
         break;
 
     case Instruction::LDY:
         cpu_.cpuState_.setY(value);
-        cpu_.cpuState_.setRegSourceY(sourceInfo);
+        cpu_.cpuState_.setTaintY(indexTaint(taint));
         break;
 
     case Instruction::LAX:
         // LAX = LDA + LDX combined (illegal opcode)
         cpu_.cpuState_.setA(value);
         cpu_.cpuState_.setX(value);
-        cpu_.cpuState_.setRegSourceA(sourceInfo);
-        cpu_.cpuState_.setRegSourceX(sourceInfo);
+        cpu_.cpuState_.setTaintA(taint);
+        cpu_.cpuState_.setTaintX(indexTaint(taint));
         break;
 
     default:
@@ -256,22 +242,23 @@ void InstructionExecutor::executeStore(Instruction instr, AddressingMode mode) {
     switch (instr) {
     case Instruction::STA:
         cpu_.writeMemory(addr, cpu_.cpuState_.getA());
-        cpu_.memory_.setWriteSourceInfo(addr, cpu_.cpuState_.getRegSourceA());
+        cpu_.memory_.setTaint(addr, cpu_.cpuState_.getTaintA());
         break;
 
     case Instruction::STX:
         cpu_.writeMemory(addr, cpu_.cpuState_.getX());
-        cpu_.memory_.setWriteSourceInfo(addr, cpu_.cpuState_.getRegSourceX());
+        cpu_.memory_.setTaint(addr, cpu_.cpuState_.getTaintX());
         break;
 
     case Instruction::STY:
         cpu_.writeMemory(addr, cpu_.cpuState_.getY());
-        cpu_.memory_.setWriteSourceInfo(addr, cpu_.cpuState_.getRegSourceY());
+        cpu_.memory_.setTaint(addr, cpu_.cpuState_.getTaintY());
         break;
 
     case Instruction::SAX:
         // SAX = Store A AND X (illegal opcode)
         cpu_.writeMemory(addr, cpu_.cpuState_.getA() & cpu_.cpuState_.getX());
+        cpu_.memory_.setTaint(addr, combineTaint(cpu_.cpuState_.getTaintA(), cpu_.cpuState_.getTaintX()));
         break;
 
     default:
@@ -330,6 +317,7 @@ void InstructionExecutor::executeArithmetic(Instruction instr, AddressingMode mo
 
             cpu_.cpuState_.setA(static_cast<u8>(sum & 0xFF));
         }
+        cpu_.cpuState_.setTaintA(combineTaint(cpu_.cpuState_.getTaintA(), operandTaint(addr)));
         break;
     }
 
@@ -377,6 +365,7 @@ void InstructionExecutor::executeArithmetic(Instruction instr, AddressingMode mo
 
             cpu_.cpuState_.setA(static_cast<u8>(diff & 0xFF));
         }
+        cpu_.cpuState_.setTaintA(combineTaint(cpu_.cpuState_.getTaintA(), operandTaint(addr)));
         break;
     }
 
@@ -440,16 +429,19 @@ void InstructionExecutor::executeLogical(Instruction instr, AddressingMode mode)
     case Instruction::AND:
         cpu_.cpuState_.setA(cpu_.cpuState_.getA() & value);
         cpu_.cpuState_.setZN(cpu_.cpuState_.getA());
+        cpu_.cpuState_.setTaintA(combineTaint(cpu_.cpuState_.getTaintA(), operandTaint(addr)));
         break;
 
     case Instruction::ORA:
         cpu_.cpuState_.setA(cpu_.cpuState_.getA() | value);
         cpu_.cpuState_.setZN(cpu_.cpuState_.getA());
+        cpu_.cpuState_.setTaintA(combineTaint(cpu_.cpuState_.getTaintA(), operandTaint(addr)));
         break;
 
     case Instruction::EOR:
         cpu_.cpuState_.setA(cpu_.cpuState_.getA() ^ value);
         cpu_.cpuState_.setZN(cpu_.cpuState_.getA());
+        cpu_.cpuState_.setTaintA(combineTaint(cpu_.cpuState_.getTaintA(), operandTaint(addr)));
         break;
 
     case Instruction::BIT:
@@ -627,6 +619,7 @@ void InstructionExecutor::executeStack(Instruction instr, AddressingMode mode) {
     switch (instr) {
     case Instruction::PHA:
         cpu_.push(cpu_.cpuState_.getA());
+        cpu_.memory_.setTaint(0x0100 + static_cast<u8>(cpu_.cpuState_.getSP() + 1), cpu_.cpuState_.getTaintA());
         break;
 
     case Instruction::PHP:
@@ -638,6 +631,7 @@ void InstructionExecutor::executeStack(Instruction instr, AddressingMode mode) {
     case Instruction::PLA:
         cpu_.cpuState_.setA(cpu_.pop());
         cpu_.cpuState_.setZN(cpu_.cpuState_.getA());
+        cpu_.cpuState_.setTaintA(cpu_.memory_.getTaint(0x0100 + cpu_.cpuState_.getSP()));
         break;
 
     case Instruction::PLP:
@@ -663,26 +657,31 @@ void InstructionExecutor::executeRegister(Instruction instr, AddressingMode mode
     case Instruction::TAX:
         cpu_.cpuState_.setX(cpu_.cpuState_.getA());
         cpu_.cpuState_.setZN(cpu_.cpuState_.getX());
+        cpu_.cpuState_.setTaintX(indexTaint(cpu_.cpuState_.getTaintA()));
         break;
 
     case Instruction::TAY:
         cpu_.cpuState_.setY(cpu_.cpuState_.getA());
         cpu_.cpuState_.setZN(cpu_.cpuState_.getY());
+        cpu_.cpuState_.setTaintY(indexTaint(cpu_.cpuState_.getTaintA()));
         break;
 
     case Instruction::TXA:
         cpu_.cpuState_.setA(cpu_.cpuState_.getX());
         cpu_.cpuState_.setZN(cpu_.cpuState_.getA());
+        cpu_.cpuState_.setTaintA(cpu_.cpuState_.getTaintX());
         break;
 
     case Instruction::TYA:
         cpu_.cpuState_.setA(cpu_.cpuState_.getY());
         cpu_.cpuState_.setZN(cpu_.cpuState_.getA());
+        cpu_.cpuState_.setTaintA(cpu_.cpuState_.getTaintY());
         break;
 
     case Instruction::TSX:
         cpu_.cpuState_.setX(cpu_.cpuState_.getSP());
         cpu_.cpuState_.setZN(cpu_.cpuState_.getX());
+        cpu_.cpuState_.setTaintX(TaintTag{});
         break;
 
     case Instruction::TXS:
@@ -871,6 +870,7 @@ void InstructionExecutor::executeIllegal(Instruction instr, AddressingMode mode)
         // ORA part
         cpu_.cpuState_.setA(cpu_.cpuState_.getA() | value);
         cpu_.cpuState_.setZN(cpu_.cpuState_.getA());
+        cpu_.cpuState_.setTaintA(combineTaint(cpu_.cpuState_.getTaintA(), operandTaint(addr)));
         break;
     }
 
@@ -888,6 +888,7 @@ void InstructionExecutor::executeIllegal(Instruction instr, AddressingMode mode)
         // AND part
         cpu_.cpuState_.setA(cpu_.cpuState_.getA() & value);
         cpu_.cpuState_.setZN(cpu_.cpuState_.getA());
+        cpu_.cpuState_.setTaintA(combineTaint(cpu_.cpuState_.getTaintA(), operandTaint(addr)));
         break;
     }
 
@@ -904,6 +905,7 @@ void InstructionExecutor::executeIllegal(Instruction instr, AddressingMode mode)
         // EOR part
         cpu_.cpuState_.setA(cpu_.cpuState_.getA() ^ value);
         cpu_.cpuState_.setZN(cpu_.cpuState_.getA());
+        cpu_.cpuState_.setTaintA(combineTaint(cpu_.cpuState_.getTaintA(), operandTaint(addr)));
         break;
     }
 
@@ -930,6 +932,7 @@ void InstructionExecutor::executeIllegal(Instruction instr, AddressingMode mode)
         cpu_.cpuState_.setFlag(StatusFlag::Negative, (sum & 0x80) != 0);
 
         cpu_.cpuState_.setA(static_cast<u8>(sum & 0xFF));
+        cpu_.cpuState_.setTaintA(combineTaint(cpu_.cpuState_.getTaintA(), operandTaint(addr)));
         break;
     }
 
@@ -972,6 +975,7 @@ void InstructionExecutor::executeIllegal(Instruction instr, AddressingMode mode)
         cpu_.cpuState_.setFlag(StatusFlag::Negative, (diff & 0x80) != 0);
 
         cpu_.cpuState_.setA(static_cast<u8>(diff & 0xFF));
+        cpu_.cpuState_.setTaintA(combineTaint(cpu_.cpuState_.getTaintA(), operandTaint(addr)));
         break;
     }
 
@@ -983,6 +987,7 @@ void InstructionExecutor::executeIllegal(Instruction instr, AddressingMode mode)
         cpu_.cpuState_.setA(cpu_.cpuState_.getA() & value);
         cpu_.cpuState_.setZN(cpu_.cpuState_.getA());
         cpu_.cpuState_.setFlag(StatusFlag::Carry, (cpu_.cpuState_.getA() & 0x80) != 0);
+        cpu_.cpuState_.setTaintA(combineTaint(cpu_.cpuState_.getTaintA(), operandTaint(addr)));
         break;
     }
 
@@ -998,6 +1003,7 @@ void InstructionExecutor::executeIllegal(Instruction instr, AddressingMode mode)
         cpu_.cpuState_.setFlag(StatusFlag::Carry, (cpu_.cpuState_.getA() & 0x01) != 0);
         cpu_.cpuState_.setA(cpu_.cpuState_.getA() >> 1);
         cpu_.cpuState_.setZN(cpu_.cpuState_.getA());
+        cpu_.cpuState_.setTaintA(combineTaint(cpu_.cpuState_.getTaintA(), operandTaint(addr)));
         break;
     }
 
@@ -1019,6 +1025,7 @@ void InstructionExecutor::executeIllegal(Instruction instr, AddressingMode mode)
         cpu_.cpuState_.setFlag(StatusFlag::Carry, (cpu_.cpuState_.getA() & 0x40) != 0);
         cpu_.cpuState_.setFlag(StatusFlag::Overflow,
             ((cpu_.cpuState_.getA() & 0x40) ^ ((cpu_.cpuState_.getA() & 0x20) << 1)) != 0);
+        cpu_.cpuState_.setTaintA(combineTaint(cpu_.cpuState_.getTaintA(), operandTaint(addr)));
         break;
     }
 
@@ -1035,6 +1042,7 @@ void InstructionExecutor::executeIllegal(Instruction instr, AddressingMode mode)
         cpu_.cpuState_.setFlag(StatusFlag::Negative, (result & 0x80) != 0);
 
         cpu_.cpuState_.setX(static_cast<u8>(result & 0xFF));
+        cpu_.cpuState_.setTaintX(indexTaint(combineTaint(cpu_.cpuState_.getTaintX(), cpu_.cpuState_.getTaintA())));
         break;
     }
 
@@ -1048,6 +1056,9 @@ void InstructionExecutor::executeIllegal(Instruction instr, AddressingMode mode)
         cpu_.cpuState_.setX(result);
         cpu_.cpuState_.setSP(result);
         cpu_.cpuState_.setZN(result);
+        const TaintTag taint = operandTaint(addr);
+        cpu_.cpuState_.setTaintA(taint);
+        cpu_.cpuState_.setTaintX(indexTaint(taint));
         break;
     }
 
@@ -1070,6 +1081,7 @@ void InstructionExecutor::executeIllegal(Instruction instr, AddressingMode mode)
         // Simplified model: X -> A, then AND with value
         cpu_.cpuState_.setA(cpu_.cpuState_.getX() & value);
         cpu_.cpuState_.setZN(cpu_.cpuState_.getA());
+        cpu_.cpuState_.setTaintA(combineTaint(cpu_.cpuState_.getTaintX(), operandTaint(addr)));
         break;
     }
 
@@ -1081,6 +1093,7 @@ void InstructionExecutor::executeIllegal(Instruction instr, AddressingMode mode)
         const u8 result = cpu_.cpuState_.getA() & cpu_.cpuState_.getX() & (high + 1);
 
         cpu_.writeMemory(addr, result);
+        cpu_.memory_.setTaint(addr, combineTaint(cpu_.cpuState_.getTaintA(), cpu_.cpuState_.getTaintX()));
         break;
     }
 
@@ -1091,6 +1104,7 @@ void InstructionExecutor::executeIllegal(Instruction instr, AddressingMode mode)
         const u8 result = cpu_.cpuState_.getX() & (high + 1);
 
         cpu_.writeMemory(addr, result);
+        cpu_.memory_.setTaint(addr, cpu_.cpuState_.getTaintX());
         break;
     }
 
@@ -1101,6 +1115,7 @@ void InstructionExecutor::executeIllegal(Instruction instr, AddressingMode mode)
         const u8 result = cpu_.cpuState_.getY() & (high + 1);
 
         cpu_.writeMemory(addr, result);
+        cpu_.memory_.setTaint(addr, cpu_.cpuState_.getTaintY());
         break;
     }
 
@@ -1113,10 +1128,62 @@ void InstructionExecutor::executeIllegal(Instruction instr, AddressingMode mode)
         const u8 result = cpu_.cpuState_.getSP() & (high + 1);
 
         cpu_.writeMemory(addr, result);
+        cpu_.memory_.setTaint(addr, TaintTag{});
         break;
     }
 
     default:
         break;
     }
+}
+
+/**
+ * @brief Get the taint of an operand byte
+ *
+ * A byte that holds a copied value keeps the origin of that value; any
+ * other byte is its own origin.
+ *
+ * @param addr Address of the operand
+ * @return Taint for a register loaded from the operand
+ */
+TaintTag InstructionExecutor::operandTaint(u16 addr) const {
+    const TaintTag tag = cpu_.memory_.getTaint(addr);
+    return TaintTag{ tag.isValid() ? tag.origin : addr, TaintTag::Valid };
+}
+
+/**
+ * @brief Combine the taints of the two inputs of an ALU operation
+ *
+ * The result follows one input only. Pointer arithmetic such as
+ * LDA lo,x / CLC / ADC offset keeps the table byte the pointer came from, so
+ * an input last loaded into an index register loses to one that was not.
+ * Otherwise the destination register wins.
+ *
+ * @param dest Taint of the register being updated
+ * @param operand Taint of the other input
+ * @return Taint of the result
+ */
+TaintTag InstructionExecutor::combineTaint(TaintTag dest, TaintTag operand) {
+    if (!operand.isValid()) {
+        return dest;
+    }
+    if (!dest.isValid()) {
+        return operand;
+    }
+    if ((dest.flags & TaintTag::Index) != 0 && (operand.flags & TaintTag::Index) == 0) {
+        return operand;
+    }
+    return dest;
+}
+
+/**
+ * @brief Mark a taint as held by an index register
+ * @param tag Taint being moved into X or Y
+ * @return The taint with the Index flag set
+ */
+TaintTag InstructionExecutor::indexTaint(TaintTag tag) {
+    if (tag.isValid()) {
+        tag.flags |= TaintTag::Index;
+    }
+    return tag;
 }
\ No newline at end of file
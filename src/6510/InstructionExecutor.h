@@ -49,4 +49,9 @@ private:
     void executeShift(Instruction instr, AddressingMode mode);
     void executeCompare(Instruction instr, AddressingMode mode);
     void executeIllegal(Instruction instr, AddressingMode mode);
+
+    // Taint propagation
+    TaintTag operandTaint(u16 addr) const;
+    static TaintTag combineTaint(TaintTag dest, TaintTag operand);
+    static TaintTag indexTaint(TaintTag tag);
 };
\ No newline at end of file
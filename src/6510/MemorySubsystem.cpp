@@ -20,10 +20,10 @@ MemorySubsystem::MemorySubsystem(CPU6510Impl& cpu) : cpu_(cpu) {
  */
 void MemorySubsystem::reset() {
     lastWriteToAddr_.resize(65536, 0);
-    writeSourceInfo_.resize(65536);
 
-    // Reset memory access tracking
+    // Reset memory access and taint tracking
     std::fill(memoryAccess_.begin(), memoryAccess_.end(), 0);
+    taint_.fill(TaintTag{});
 
     // Memory contents are not reset to allow loading programs
 }
@@ -36,6 +36,9 @@ void MemorySubsystem::reset() {
  */
 u8 MemorySubsystem::readMemory(u16 addr) {
     markMemoryAccess(addr, MemoryAccessFlag::Read);
+    if (heatMap_) {
+        heatMap_->reads[addr]++;
+    }
     return memory_[addr];
 }
 
@@ -58,6 +61,9 @@ void MemorySubsystem::writeByte(u16 addr, u8 value) {
  */
 void MemorySubsystem::writeMemory(u16 addr, u8 value, u16 sourcePC) {
     markMemoryAccess(addr, MemoryAccessFlag::Write);
+    if (heatMap_) {
+        heatMap_->writes[addr]++;
+    }
     memory_[addr] = value;
     lastWriteToAddr_[addr] = sourcePC;
 }
@@ -161,46 +167,78 @@ const std::vector<u16>& MemorySubsystem::getLastWriteToAddr() const {
 }
 
 /**
- * @brief Get the source information for a memory write
- *
- * @param addr Memory address to check
- * @return Register source information for the last write to the address
+ * @brief Allocate (and zero) all heat map counter arrays
  */
-RegisterSourceInfo MemorySubsystem::getWriteSourceInfo(u16 addr) const {
-    return writeSourceInfo_[addr];
+void HeatMap::allocate() {
+    executions.assign(65536, 0);
+    cycles.assign(65536, 0);
+    reads.assign(65536, 0);
+    writes.assign(65536, 0);
 }
 
 /**
- * @brief Set write source info
+ * @brief Write all non-zero heat map entries in a compact binary format
  *
- * @param addr Memory address
- * @param info Register source info
+ * @param filename Output filename
+ * @return True if the file was written successfully
  */
-void MemorySubsystem::setWriteSourceInfo(u16 addr, const RegisterSourceInfo& info) {
-    writeSourceInfo_[addr] = info;
-
-    // Update data flow if this is a memory-to-memory copy and not a self-reference
-    if (info.type == RegisterSourceInfo::SourceType::Memory && info.address != addr) {
-        u16 sourceAddr = info.address;
+bool HeatMap::writeBinary(const std::string& filename) const {
+    std::ofstream file(filename, std::ios::binary);
+    if (!file) {
+        return false;
+    }
 
-        // Check if this source is already recorded
-        auto& sources = dataFlow_.memoryWriteSources[addr];
-        bool alreadyExists = false;
+    // Explicit little-endian packing, independent of host layout
+    const auto putLE = [&file](u64 value, int bytes) {
+        for (int i = 0; i < bytes; ++i) {
+            file.put(static_cast<char>((value >> (i * 8)) & 0xFF));
+        }
+    };
 
-        for (const auto& existingSource : sources) {
-            if (existingSource == sourceAddr) {
-                alreadyExists = true;
-                break;
-            }
+    u32 count = 0;
+    for (u32 addr = 0; addr < 65536; ++addr) {
+        if (executions[addr] || reads[addr] || writes[addr]) {
+            ++count;
         }
+    }
+
+    file.write("SBHM", 4);
+    putLE(1, 2);
+    putLE(count, 4);
 
-        // Only add if it's not already in the list
-        if (!alreadyExists) {
-            sources.push_back(sourceAddr);
+    for (u32 addr = 0; addr < 65536; ++addr) {
+        if (executions[addr] || reads[addr] || writes[addr]) {
+            putLE(addr, 2);
+            putLE(executions[addr], 4);
+            putLE(cycles[addr], 8);
+            putLE(reads[addr], 4);
+            putLE(writes[addr], 4);
         }
     }
+
+    return static_cast<bool>(file);
 }
 
-const MemoryDataFlow& MemorySubsystem::getMemoryDataFlow() const {
-    return dataFlow_;
+/**
+ * @brief Write all non-zero heat map entries as CSV
+ *
+ * @param filename Output filename
+ * @return True if the file was written successfully
+ */
+bool HeatMap::writeCsv(const std::string& filename) const {
+    std::ofstream file(filename);
+    if (!file) {
+        return false;
+    }
+
+    file << "address,executions,cycles,reads,writes\n";
+    for (u32 addr = 0; addr < 65536; ++addr) {
+        if (executions[addr] || reads[addr] || writes[addr]) {
+            file << "$" << std::hex << std::uppercase << std::setw(4) << std::setfill('0') << addr
+                << std::dec << "," << executions[addr] << "," << cycles[addr]
+                << "," << reads[addr] << "," << writes[addr] << "\n";
+        }
+    }
+
+    return static_cast<bool>(file);
 }
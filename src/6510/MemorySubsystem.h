@@ -114,26 +114,26 @@ public:
     const std::vector<u16>& getLastWriteToAddr() const;
 
     /**
-     * @brief Get the source information for a memory write
+     * @brief Get the taint tag of a memory byte
      *
-     * @param addr Memory address to check
-     * @return Register source information for the last write to the address
+     * @param addr Memory address
+     * @return Origin of the value last stored there by the program
      */
-    RegisterSourceInfo getWriteSourceInfo(u16 addr) const;
+    TaintTag getTaint(u16 addr) const { return taint_[addr]; }
 
     /**
-     * @brief Set write source info
+     * @brief Set the taint tag of a memory byte
      *
      * @param addr Memory address
-     * @param info Register source info
+     * @param tag Origin of the stored value
      */
-    void setWriteSourceInfo(u16 addr, const RegisterSourceInfo& info);
+    void setTaint(u16 addr, TaintTag tag) { taint_[addr] = tag; }
 
     /**
-     * @brief Get the memory data flow tracking information
-     * @return Reference to the memory data flow tracking
+     * @brief Set the heat map that data reads and writes are counted into
+     * @param heatMap Heat map, or nullptr to stop counting
      */
-    const MemoryDataFlow& getMemoryDataFlow() const;
+    void setHeatMap(HeatMap* heatMap) { heatMap_ = heatMap; }
 
 private:
     // Reference to CPU implementation
@@ -147,8 +147,10 @@ private:
 
     // Track the source of writes to memory
     std::vector<u16> lastWriteToAddr_;
-    std::vector<RegisterSourceInfo> writeSourceInfo_;
 
-    MemoryDataFlow dataFlow_;  // Memory data flow tracking
+    // Shadow memory: where each byte's value came from
+    std::array<TaintTag, 65536> taint_;
+
+    HeatMap* heatMap_ = nullptr;       // Read/write counters (only while the heat map is enabled)
 
 };
\ No newline at end of file
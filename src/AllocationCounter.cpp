@@ -0,0 +1,53 @@
+// ==================================
+//             SIDBlaster
+//
+//  Raistlin / Genesis Project (G*P)
+// ==================================
+#include "AllocationCounter.h"
+
+namespace sidblaster {
+    namespace util {
+
+        namespace {
+            bool enabled_ = false;                 // Set once the allocation hooks are loaded
+            thread_local u64 allocations_ = 0;     // operator new calls on this thread
+            thread_local u64 allocatedBytes_ = 0;  // Bytes requested on this thread
+        }
+
+        /**
+         * @brief Check whether this program counts allocations
+         *
+         * @return True if AllocationHooks.cpp is linked in
+         */
+        bool AllocationCounter::isEnabled() {
+            return enabled_;
+        }
+
+        /**
+         * @brief Get the allocations made by the calling thread so far
+         *
+         * @return Allocation totals (always zero unless counting is enabled)
+         */
+        AllocationCounter::Counts AllocationCounter::current() {
+            return { allocations_, allocatedBytes_ };
+        }
+
+        /**
+         * @brief Turn counting on
+         */
+        void AllocationCounter::enable() {
+            enabled_ = true;
+        }
+
+        /**
+         * @brief Count one allocation on the calling thread
+         *
+         * @param bytes Bytes requested
+         */
+        void AllocationCounter::record(std::size_t bytes) {
+            ++allocations_;
+            allocatedBytes_ += bytes;
+        }
+
+    } // namespace util
+} // namespace sidblaster
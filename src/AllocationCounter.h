@@ -0,0 +1,61 @@
+// ==================================
+//             SIDBlaster
+//
+//  Raistlin / Genesis Project (G*P)
+// ==================================
+#pragma once
+
+#include "Common.h"
+
+#include <cstddef>
+
+namespace sidblaster {
+    namespace util {
+
+        /**
+         * @class AllocationCounter
+         * @brief Counts heap allocations made through the global operator new
+         *
+         * The counting operator new/delete replacements live in
+         * AllocationHooks.cpp, which is only linked into instrumented programs
+         * (CMake option SIDBLASTER_COUNT_ALLOCATIONS, and always the test
+         * driver). It enables counting when it is loaded; otherwise the counts
+         * always read zero and isEnabled() returns false. Counts are kept per
+         * thread.
+         */
+        class AllocationCounter {
+        public:
+            /**
+             * @brief Allocation totals at a point in time
+             */
+            struct Counts {
+                u64 allocations = 0;    // Number of operator new calls
+                u64 bytes = 0;          // Bytes requested
+            };
+
+            /**
+             * @brief Check whether this program counts allocations
+             * @return True if the allocation hooks are linked in
+             */
+            static bool isEnabled();
+
+            /**
+             * @brief Get the allocations made by the calling thread so far
+             * @return Allocation totals
+             */
+            static Counts current();
+
+            /**
+             * @brief Turn counting on (called by the allocation hooks)
+             */
+            static void enable();
+
+            /**
+             * @brief Count one allocation on the calling thread
+             * @param bytes Bytes requested
+             */
+            static void record(std::size_t bytes);
+        };
+
+    } // namespace util
+} // namespace sidblaster
@@ -0,0 +1,95 @@
+// ==================================
+//             SIDBlaster
+//
+//  Raistlin / Genesis Project (G*P)
+// ==================================
+#include "AllocationCounter.h"
+
+#include <cstdlib>
+#include <new>
+
+// Replacements for the global allocation functions that feed AllocationCounter.
+// Only linked into instrumented programs: see SIDBLASTER_COUNT_ALLOCATIONS in
+// CMakeLists.txt. The array and nothrow forms are replaced as well so that
+// every allocation is paired with the matching deallocation.
+
+namespace {
+    using sidblaster::util::AllocationCounter;
+
+    // Turn counting on before main() runs
+    [[maybe_unused]] const bool hooksLoaded = (AllocationCounter::enable(), true);
+
+    /**
+     * @brief Count and perform an allocation
+     */
+    void* countedAlloc(std::size_t size) {
+        AllocationCounter::record(size);
+        return std::malloc(size == 0 ? 1 : size);
+    }
+
+    /**
+     * @brief Count and perform an over-aligned allocation
+     */
+    void* countedAlignedAlloc(std::size_t size, std::size_t alignment) {
+        AllocationCounter::record(size);
+#ifdef _WIN32
+        return _aligned_malloc(size == 0 ? 1 : size, alignment);
+#else
+        // aligned_alloc needs the size to be a multiple of the alignment
+        const std::size_t rounded = ((size == 0 ? 1 : size) + alignment - 1) / alignment * alignment;
+        return std::aligned_alloc(alignment, rounded);
+#endif
+    }
+
+    /**
+     * @brief Release an over-aligned allocation
+     */
+    void alignedFree(void* ptr) {
+#ifdef _WIN32
+        _aligned_free(ptr);
+#else
+        std::free(ptr);
+#endif
+    }
+}
+
+void* operator new(std::size_t size) {
+    if (void* ptr = countedAlloc(size)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size) {
+    return ::operator new(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    return countedAlloc(size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+    return countedAlloc(size);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment) {
+    if (void* ptr = countedAlignedAlloc(size, static_cast<std::size_t>(alignment))) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment) {
+    return ::operator new(size, alignment);
+}
+
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+void operator delete[](void* ptr) noexcept { std::free(ptr); }
+void operator delete(void* ptr, std::size_t) noexcept { std::free(ptr); }
+void operator delete[](void* ptr, std::size_t) noexcept { std::free(ptr); }
+void operator delete(void* ptr, const std::nothrow_t&) noexcept { std::free(ptr); }
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept { std::free(ptr); }
+void operator delete(void* ptr, std::align_val_t) noexcept { alignedFree(ptr); }
+void operator delete[](void* ptr, std::align_val_t) noexcept { alignedFree(ptr); }
+void operator delete(void* ptr, std::size_t, std::align_val_t) noexcept { alignedFree(ptr); }
+void operator delete[](void* ptr, std::size_t, std::align_val_t) noexcept { alignedFree(ptr); }
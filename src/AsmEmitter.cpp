@@ -0,0 +1,104 @@
+// ==================================
+//             SIDBlaster
+//
+//  Raistlin / Genesis Project (G*P)
+// ==================================
+#include "AsmEmitter.h"
+#include "SIDBlasterUtils.h"
+
+#include <algorithm>
+#include <charconv>
+#include <fstream>
+
+namespace sidblaster {
+
+    namespace {
+        // Padding is copied from here instead of constructing space strings
+        constexpr std::array<char, 128> makeSpaces() {
+            std::array<char, 128> spaces{};
+            for (auto& c : spaces) {
+                c = ' ';
+            }
+            return spaces;
+        }
+
+        constexpr auto Spaces = makeSpaces();
+    }
+
+    /**
+     * @brief Append a value as uppercase hex without leading zeros
+     *
+     * @param value Value to append
+     */
+    void AsmEmitter::putHex(u32 value) {
+        char digits[8];
+        int count = 0;
+        do {
+            digits[count++] = HexPairs[value & 0x0F][1];
+            value >>= 4;
+        } while (value != 0);
+
+        while (count > 0) {
+            buffer_.push_back(digits[--count]);
+        }
+    }
+
+    /**
+     * @brief Append a value in decimal
+     *
+     * @param value Value to append
+     */
+    void AsmEmitter::putDecimal(long long value) {
+        char digits[24];
+        const auto result = std::to_chars(digits, digits + sizeof(digits), value);
+        buffer_.append(digits, result.ptr);
+    }
+
+    /**
+     * @brief Pad the current line with spaces up to a column
+     *
+     * @param column Target column
+     */
+    void AsmEmitter::padToColumn(size_t column) {
+        size_t current = this->column();
+        while (current < column) {
+            const size_t count = std::min(column - current, Spaces.size());
+            buffer_.append(Spaces.data(), count);
+            current += count;
+        }
+    }
+
+    /**
+     * @brief Get the length of the current line
+     *
+     * @return Number of characters since the last newline
+     */
+    size_t AsmEmitter::column() const {
+        const size_t newline = buffer_.rfind('\n');
+        return (newline == std::string::npos) ? buffer_.size() : buffer_.size() - newline - 1;
+    }
+
+    /**
+     * @brief Write the whole buffer to a file
+     *
+     * @param filename Output filename
+     * @return True if the file was written successfully
+     */
+    bool AsmEmitter::writeToFile(const std::string& filename) const {
+        // Text mode, so line endings match what the platform's streams produce
+        std::ofstream file(filename);
+        if (!file) {
+            util::Logger::error("Failed to open output file: " + filename);
+            return false;
+        }
+
+        file.write(buffer_.data(), static_cast<std::streamsize>(buffer_.size()));
+        if (!file) {
+            util::Logger::error("Failed to write output file: " + filename);
+            return false;
+        }
+
+        return true;
+    }
+
+} // namespace sidblaster
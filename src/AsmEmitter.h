@@ -0,0 +1,154 @@
+// ==================================
+//             SIDBlaster
+//
+//  Raistlin / Genesis Project (G*P)
+// ==================================
+#pragma once
+
+#include "Common.h"
+
+#include <array>
+#include <string>
+#include <string_view>
+
+/**
+ * @file AsmEmitter.h
+ * @brief Append-only text buffer for assembly output
+ *
+ * The disassembler produces tens of thousands of short, column-aligned lines.
+ * Rather than building each one in its own stream or string, every piece of
+ * text is appended to a single growable buffer which is written to disk in
+ * one call when the file is complete.
+ */
+
+namespace sidblaster {
+
+    /**
+     * @brief Build the two-digit uppercase hex table used by AsmEmitter
+     * @return Table mapping each byte to its "00".."FF" digits
+     */
+    constexpr std::array<std::array<char, 2>, 256> makeHexPairs() {
+        constexpr char digits[] = "0123456789ABCDEF";
+        std::array<std::array<char, 2>, 256> table{};
+        for (int i = 0; i < 256; ++i) {
+            table[i] = { digits[i >> 4], digits[i & 0x0F] };
+        }
+        return table;
+    }
+
+    inline constexpr auto HexPairs = makeHexPairs();  // "00".."FF"
+
+    /**
+     * @class AsmEmitter
+     * @brief Builds assembly text in a single reusable char buffer
+     *
+     * Hex digits come from constexpr lookup tables and padding is copied from a
+     * precomputed run of spaces, so appending a line never allocates once the
+     * buffer has grown to the size of the output.
+     */
+    class AsmEmitter {
+    public:
+        /**
+         * @brief Constructor
+         * @param reserveBytes Initial buffer capacity
+         */
+        explicit AsmEmitter(size_t reserveBytes = 256 * 1024) {
+            buffer_.reserve(reserveBytes);
+        }
+
+        /**
+         * @brief Append text
+         * @param text Text to append
+         */
+        void put(std::string_view text) {
+            buffer_.append(text);
+        }
+
+        /**
+         * @brief Append a single character
+         * @param c Character to append
+         */
+        void put(char c) {
+            buffer_.push_back(c);
+        }
+
+        /**
+         * @brief Append a byte as two uppercase hex digits
+         * @param value Byte value
+         */
+        void putHex8(u8 value) {
+            buffer_.append(HexPairs[value].data(), 2);
+        }
+
+        /**
+         * @brief Append a word as four uppercase hex digits
+         * @param value Word value
+         */
+        void putHex16(u16 value) {
+            putHex8(static_cast<u8>(value >> 8));
+            putHex8(static_cast<u8>(value & 0xFF));
+        }
+
+        /**
+         * @brief Append a value as uppercase hex without leading zeros
+         * @param value Value to append
+         *
+         * Matches the output of streaming a value with std::hex and std::uppercase.
+         */
+        void putHex(u32 value);
+
+        /**
+         * @brief Append a value in decimal
+         * @param value Value to append
+         */
+        void putDecimal(long long value);
+
+        /**
+         * @brief Pad the current line with spaces up to a column
+         * @param column Target column (no-op if the line is already that long)
+         */
+        void padToColumn(size_t column);
+
+        /**
+         * @brief Get the length of the current (unterminated) line
+         * @return Number of characters since the last newline
+         */
+        size_t column() const;
+
+        /**
+         * @brief Get the current buffer size
+         * @return Number of bytes emitted so far
+         */
+        size_t size() const {
+            return buffer_.size();
+        }
+
+        /**
+         * @brief Get a view of emitted text
+         * @param offset Start offset within the buffer
+         * @param length Number of bytes
+         * @return View into the buffer (invalidated by further appends)
+         */
+        std::string_view view(size_t offset = 0, size_t length = std::string_view::npos) const {
+            return std::string_view(buffer_).substr(offset, length);
+        }
+
+        /**
+         * @brief Discard all emitted text, keeping the allocation
+         */
+        void clear() {
+            buffer_.clear();
+        }
+
+        /**
+         * @brief Write the whole buffer to a file
+         * @param filename Output filename
+         * @return True if the file was written successfully
+         */
+        bool writeToFile(const std::string& filename) const;
+
+    private:
+        std::string buffer_;  // Emitted text
+    };
+
+} // namespace sidblaster
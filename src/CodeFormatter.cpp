@@ -8,7 +8,6 @@
 #include "DisassemblyWriter.h"
 
 #include <algorithm>
-#include <sstream>
 
 namespace sidblaster {
 
@@ -37,14 +36,12 @@ namespace sidblaster {
      * Converts a machine code instruction at PC into assembly language.
      * Updates PC to point to the next instruction.
      *
+     * @param out Emitter to append the instruction to (no newline is added)
      * @param pc Program counter (will be updated to point after instruction)
-     * @return Formatted instruction string
      */
-    std::string CodeFormatter::formatInstruction(u16& pc) const {
-        std::ostringstream line;
-
+    void CodeFormatter::formatInstruction(AsmEmitter& out, u16& pc) const {
         const u8 opcode = memory_[pc];
-        const std::string mnemonic = std::string(cpu_.getMnemonic(opcode));
+        const std::string_view mnemonic = cpu_.getMnemonic(opcode);
         const auto mode = cpu_.getAddressingMode(opcode);
         const int size = cpu_.getInstructionSize(opcode);
 
@@ -55,35 +52,34 @@ namespace sidblaster {
         if (static_cast<int>(mode) == static_cast<int>(AddressingMode::Absolute)) {
             const u16 absAddr = memory_[pc + 1] | (memory_[pc + 2] << 8);
             if (isCIAStorePatch(opcode, static_cast<int>(mode), absAddr, mnemonic)) {
-                std::ostringstream patched;
-                patched << "    bit $abcd   //; disabled " << mnemonic << " $"
-                    << util::wordToHex(absAddr) << " (CIA Timer)";
+                out.put("    bit $abcd   //; disabled ");
+                out.put(mnemonic);
+                out.put(" $");
+                out.putHex16(absAddr);
+                out.put(" (CIA Timer)");
                 pc += size;
-                return patched.str();
+                return;
             }
         }
 
         // Format instruction with mnemonic
-        line << "    " << mnemonic;
+        out.put("    ");
+        out.put(mnemonic);
 
         // Add operand if needed
         if (size > 1) {
-            line << " " << formatOperand(pc, static_cast<int>(mode));
+            out.put(' ');
+            formatOperand(out, pc, static_cast<int>(mode));
         }
 
         // Update PC
         pc += size;
 
         // Calculate the end PC
-        u16 endPC = startPC + size - 1;
+        const u16 endPC = startPC + size - 1;
 
         // Pad to fixed column and add address comment
-        std::string lineStr = line.str();
-        int padding = std::max(0, 97 - static_cast<int>(lineStr.length())); // Adjusted to column 97
-
-        return lineStr + std::string(padding, ' ') + "//; $" +
-            util::wordToHex(startPC) + " - " +
-            util::wordToHex(endPC);
+        formatAddressRangeComment(out, startPC, endPC);
     }
 
     /**
@@ -93,65 +89,44 @@ namespace sidblaster {
      * Handles relocation entries and unused bytes.
      * Enhanced to include memory address ranges in comments with proper alignment.
      *
-     * @param file Output stream
+     * @param out Emitter to append the data lines to
      * @param pc Program counter (will be updated)
      * @param originalMemory Original memory data
      * @param originalBase Base address of original memory
      * @param endAddress End address
-     * @param relocationBytes Map of relocation bytes
-     * @param memoryTags Memory type tags
+     * @param endsTune Whether endAddress is the end of the tune
      * @return Number of unused bytes zeroed out
      */
     int CodeFormatter::formatDataBytes(
-        std::ostream& file,
+        AsmEmitter& out,
         u16& pc,
         std::span<const u8> originalMemory,
         u16 originalBase,
         u16 endAddress,
-        const std::map<u16, RelocationEntry>& relocationBytes,
-        std::span<const MemoryType> memoryTags) const {
+        bool endsTune) const {
 
         int unusedByteCount = 0;
-        const int commentColumn = 97; // Target column for alignment of comments (adjusted +1)
 
-        while (pc < endAddress && (memoryTags[pc] & MemoryType::Data)) {
+        while (pc < endAddress && (labelGenerator_.getAnnotation(pc).type & MemoryType::Data)) {
+            const AddressAnnotation& annotation = labelGenerator_.getAnnotation(pc);
+
             // Emit label if present
-            const std::string label = labelGenerator_.getLabel(pc);
+            const std::string& label = labelGenerator_.getLabel(pc);
             if (!label.empty()) {
-                file << label << ":\n";
+                out.put(label);
+                out.put(":\n");
             }
 
             // Check for relocation byte
-            auto relocIt = relocationBytes.find(pc);
-            if (relocIt != relocationBytes.end()) {
-                const u16 target = relocIt->second.targetAddress;
-                const std::string targetLabel = labelGenerator_.formatAddress(target);
-
-                // Store the current PC for comment
-                const u16 startPC = pc;
-                const u16 endPC = pc; // For relocation entries, end = start (1 byte)
-
-                // Build the line in a string stream
-                std::ostringstream lineSS;
-                lineSS << "    .byte ";
-                if (relocIt->second.type == RelocationEntry::Type::Low) {
-                    lineSS << "<(" << targetLabel << ")";
-                }
-                else {
-                    lineSS << ">(" << targetLabel << ")";
-                }
-
-                // Get the line as a string
-                std::string line = lineSS.str();
+            if (annotation.hasRelocation) {
+                out.put("    .byte ");
+                out.put(annotation.relocation.type == RelocationEntry::Type::Low ? "<(" : ">(");
+                labelGenerator_.formatAddress(out, annotation.relocation.targetAddress);
+                out.put(')');
 
-                // Output the line with properly aligned comment
-                file << line;
-
-                // Calculate padding needed
-                int padding = std::max(0, commentColumn - static_cast<int>(line.length()));
-                file << std::string(padding, ' ') << "//; $"
-                    << util::wordToHex(startPC) << " - "
-                    << util::wordToHex(endPC) << "\n";
+                // For relocation entries, end = start (1 byte)
+                formatAddressRangeComment(out, pc, pc);
+                out.put('\n');
 
                 ++pc;
                 continue;
@@ -159,21 +134,25 @@ namespace sidblaster {
 
             u16 lineStartPC = pc; // Remember line start for comment
 
-            // Build the line in a string stream
-            std::ostringstream lineSS;
-            lineSS << "    .byte ";
+            // Where the current line's text starts, and its length once flushed
+            size_t lineOffset = out.size();
+            size_t flushedLength = 0;
+            bool lineFlushed = false;
+
+            out.put("    .byte ");
 
             int count = 0;
-            while (pc < endAddress && (memoryTags[pc] & MemoryType::Data)) {
+            while (pc < endAddress && (labelGenerator_.getAnnotation(pc).type & MemoryType::Data)) {
+                const AddressAnnotation& byteInfo = labelGenerator_.getAnnotation(pc);
 
                 // Stop at relocation bytes
-                if (relocationBytes.count(pc)) {
+                if (byteInfo.hasRelocation) {
                     break;
                 }
 
                 // Add comma if not the first byte
                 if (count > 0) {
-                    lineSS << ", ";
+                    out.put(", ");
                 }
 
                 // Get the byte from original memory if possible
@@ -187,43 +166,41 @@ namespace sidblaster {
                 }
 
                 // Check if unused (not accessed)
-                bool isUnused = !(memoryTags[pc] & (MemoryType::Accessed | MemoryType::LabelTarget));
+                bool isUnused = !(byteInfo.type & (MemoryType::Accessed | MemoryType::LabelTarget));
                 if (isUnused) {
                     byte = 0;  // Always zero out unused bytes to help with compression
                     unusedByteCount++;
                 }
 
-                lineSS << "$" << util::byteToHex(byte);
+                out.put('$');
+                out.putHex8(byte);
 
                 ++pc;
                 ++count;
 
                 // Stop at code or label
-                if ((memoryTags[pc] & MemoryType::Code) || !labelGenerator_.getLabel(pc).empty()) {
+                const AddressAnnotation& next = labelGenerator_.getAnnotation(pc);
+                if ((next.type & MemoryType::Code) || next.labelId != AddressAnnotation::NoLabel) {
                     break;
                 }
 
                 // Line break after 16 bytes
                 if (count == 16) {
-                    // Get the full line as a string
-                    std::string line = lineSS.str();
-
-                    // Calculate end address for range
-                    const u16 lineEndPC = pc - 1; // Last byte processed
-
-                    // Output the line with properly aligned comment
-                    file << line;
-
-                    // Calculate padding needed
-                    int padding = std::max(0, commentColumn - static_cast<int>(line.length()));
-                    file << std::string(padding, ' ') << "//; $"
-                        << util::wordToHex(lineStartPC) << " - "
-                        << util::wordToHex(lineEndPC) << "\n";
+                    flushedLength = out.size() - lineOffset;
+                    formatAddressRangeComment(out, lineStartPC, pc - 1);
+                    out.put('\n');
 
                     // Start a new line if there are more bytes
-                    if (pc < endAddress && (memoryTags[pc] & MemoryType::Data)) {
-                        lineSS.str("");  // Clear the string stream
-                        lineSS << "    .byte ";
+                    if (pc < endAddress && (labelGenerator_.getAnnotation(pc).type & MemoryType::Data)) {
+                        lineOffset = out.size();
+                        out.put("    .byte ");
+                        count = 0;
+                    }
+                    else if (endsTune && pc == endAddress) {
+                        lineFlushed = true;
+                    }
+                    else {
+                        // Ends before removed bytes or a segment end: nothing more to write
                         count = 0;
                     }
 
@@ -233,26 +210,36 @@ namespace sidblaster {
 
             // Output last line if anything remains
             if (count > 0) {
-                // Calculate end address for the final line
-                const u16 lineEndPC = pc - 1; // Last byte processed
-
-                // Get the full line as a string
-                std::string line = lineSS.str();
-
-                // Output the line with properly aligned comment
-                file << line;
+                // A full 16-byte line that ends the tune has already been written
+                // above; the output format repeats it here with an empty range
+                if (lineFlushed) {
+                    const std::string repeated(out.view(lineOffset, flushedLength));
+                    out.put(repeated);
+                }
 
-                // Calculate padding needed
-                int padding = std::max(0, commentColumn - static_cast<int>(line.length()));
-                file << std::string(padding, ' ') << "//; $"
-                    << util::wordToHex(lineStartPC) << " - "
-                    << util::wordToHex(lineEndPC) << "\n";
+                formatAddressRangeComment(out, lineStartPC, pc - 1);
+                out.put('\n');
             }
         }
 
         return unusedByteCount;
     }
 
+    /**
+     * @brief Pad to the comment column and add an address range comment
+     *
+     * @param out Emitter to append the comment to
+     * @param startPC First address covered by the line
+     * @param endPC Last address covered by the line
+     */
+    void CodeFormatter::formatAddressRangeComment(AsmEmitter& out, u16 startPC, u16 endPC) const {
+        out.padToColumn(CommentColumn);
+        out.put("//; $");
+        out.putHex16(startPC);
+        out.put(" - ");
+        out.putHex16(endPC);
+    }
+
     /**
      * @brief Check if a store instruction is a CIA timer patch
      *
@@ -287,77 +274,93 @@ namespace sidblaster {
      * Handles different addressing modes and formats operands appropriately,
      * including resolving labels and symbolic addresses.
      *
+     * @param out Emitter to append the operand to
      * @param pc Program counter
      * @param mode Addressing mode
-     * @return Formatted operand string
      */
-    std::string CodeFormatter::formatOperand(u16 pc, int mode) const {
+    void CodeFormatter::formatOperand(AsmEmitter& out, u16 pc, int mode) const {
         const auto addressingMode = static_cast<AddressingMode>(mode);
 
         switch (addressingMode) {
         case AddressingMode::Immediate: {
-            return "#$" + util::byteToHex(memory_[pc + 1]);
+            out.put("#$");
+            out.putHex8(memory_[pc + 1]);
+            break;
         }
 
         case AddressingMode::ZeroPage: {
             const u8 zp = memory_[pc + 1];
-            return labelGenerator_.formatZeroPage(zp);
+            labelGenerator_.formatZeroPage(out, zp);
+            break;
         }
 
         case AddressingMode::ZeroPageX: {
             const u8 zp = memory_[pc + 1];
-            const std::string baseAddr = labelGenerator_.formatZeroPage(zp);
-            return baseAddr + ",X";
+            labelGenerator_.formatZeroPage(out, zp);
+            out.put(",X");
+            break;
         }
 
         case AddressingMode::ZeroPageY: {
             const u8 zp = memory_[pc + 1];
-            const std::string baseAddr = labelGenerator_.formatZeroPage(zp);
-            return baseAddr + ",Y";
+            labelGenerator_.formatZeroPage(out, zp);
+            out.put(",Y");
+            break;
         }
 
         case AddressingMode::IndirectX: {
             const u8 zp = memory_[pc + 1];
-            const std::string baseAddr = labelGenerator_.formatZeroPage(zp);
-            return "(" + baseAddr + ",X)";
+            out.put('(');
+            labelGenerator_.formatZeroPage(out, zp);
+            out.put(",X)");
+            break;
         }
 
         case AddressingMode::IndirectY: {
             const u8 zp = memory_[pc + 1];
-            const std::string baseAddr = labelGenerator_.formatZeroPage(zp);
-            return "(" + baseAddr + "),Y";
+            out.put('(');
+            labelGenerator_.formatZeroPage(out, zp);
+            out.put("),Y");
+            break;
         }
 
         case AddressingMode::Absolute: {
             const u16 accessAddr = memory_[pc + 1] | (memory_[pc + 2] << 8);
-            return labelGenerator_.formatAddress(accessAddr);
+            labelGenerator_.formatAddress(out, accessAddr);
+            break;
         }
 
         case AddressingMode::AbsoluteX: {
             const u16 baseAddr = memory_[pc + 1] | (memory_[pc + 2] << 8);
             const auto [minIndex, maxIndex] = cpu_.getIndexRange(pc + 1);
-            return formatIndexedAddressWithMinOffset(baseAddr, minIndex, 'X');
+            formatIndexedAddressWithMinOffset(out, baseAddr, chooseIndexOffset(pc + 1, baseAddr, minIndex), 'X');
+            break;
         }
 
         case AddressingMode::AbsoluteY: {
             const u16 baseAddr = memory_[pc + 1] | (memory_[pc + 2] << 8);
             const auto [minIndex, maxIndex] = cpu_.getIndexRange(pc + 1);
-            return formatIndexedAddressWithMinOffset(baseAddr, minIndex, 'Y');
+            formatIndexedAddressWithMinOffset(out, baseAddr, chooseIndexOffset(pc + 1, baseAddr, minIndex), 'Y');
+            break;
         }
 
         case AddressingMode::Indirect: {
             const u16 accessAddr = memory_[pc + 1] | (memory_[pc + 2] << 8);
-            return "($" + util::wordToHex(accessAddr) + ")";
+            out.put("($");
+            out.putHex16(accessAddr);
+            out.put(')');
+            break;
         }
 
         case AddressingMode::Relative: {
             const i8 offset = static_cast<i8>(memory_[pc + 1]);
             const u16 dest = pc + 2 + offset;
-            return labelGenerator_.formatAddress(dest);
+            labelGenerator_.formatAddress(out, dest);
+            break;
         }
 
         default:
-            return "";
+            break;
         }
     }
 
@@ -367,29 +370,64 @@ namespace sidblaster {
      * Formats addresses with index registers, accounting for offsets.
      * Uses label-based expressions when appropriate.
      *
+     * @param out Emitter to append the operand to
      * @param baseAddr Base address
      * @param minOffset Minimum offset
      * @param indexReg Index register ('X' or 'Y')
-     * @return Formatted address string
      */
-    std::string CodeFormatter::formatIndexedAddressWithMinOffset(
+    void CodeFormatter::formatIndexedAddressWithMinOffset(
+        AsmEmitter& out,
         u16 baseAddr,
         u8 minOffset,
         char indexReg) const {
 
         const u16 targetAddr = baseAddr + minOffset;
-        const std::string label = labelGenerator_.getLabel(targetAddr);
+        const std::string& label = labelGenerator_.getLabel(targetAddr);
 
         if (!label.empty()) {
-            if (minOffset == 0) {
-                return label + "," + indexReg;
+            out.put(label);
+            if (minOffset != 0) {
+                out.put('-');
+                out.putDecimal(minOffset);
             }
-            else {
-                return label + "-" + std::to_string(minOffset) + "," + indexReg;
+        }
+        else {
+            labelGenerator_.formatAddress(out, baseAddr);
+        }
+
+        out.put(',');
+        out.put(indexReg);
+    }
+
+    /**
+     * @brief Choose the index offset an indexed operand's label is based on
+     *
+     * With histograms recorded, the label is taken from the element the
+     * instruction actually touched most often rather than the lowest one,
+     * which may belong to a neighbouring table.
+     *
+     * @param operandAddr Address of the instruction's operand
+     * @param baseAddr Base address
+     * @param minOffset Minimum index used by the instruction
+     * @return Chosen index offset
+     */
+    u8 CodeFormatter::chooseIndexOffset(u16 operandAddr, u16 baseAddr, u8 minOffset) const {
+        const std::span<const u32> histogram = cpu_.getIndexHistogram(operandAddr);
+        if (histogram.empty()) {
+            return minOffset;
+        }
+
+        u8 bestOffset = minOffset;
+        u32 bestCount = 0;
+        for (size_t index = 0; index < histogram.size(); ++index) {
+            if (histogram[index] > bestCount &&
+                !labelGenerator_.getLabel(static_cast<u16>(baseAddr + index)).empty()) {
+                bestOffset = static_cast<u8>(index);
+                bestCount = histogram[index];
             }
         }
 
-        return labelGenerator_.formatAddress(baseAddr) + "," + indexReg;
+        return bestOffset;
     }
 
-} // namespace sidblaster
\ No newline at end of file
+} // namespace sidblaster
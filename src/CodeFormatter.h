@@ -5,6 +5,7 @@
 // ==================================
 #pragma once
 
+#include "AsmEmitter.h"
 #include "LabelGenerator.h"
 #include "SIDBlasterUtils.h"
 #include "RelocationStructs.h"
@@ -50,36 +51,35 @@ namespace sidblaster {
 
         /**
          * @brief Format a disassembled instruction
+         * @param out Emitter to append the instruction to (no newline is added)
          * @param pc Program counter (will be updated to point after instruction)
-         * @return Formatted instruction string
          *
          * Converts a machine code instruction at PC into assembly language.
          * Updates PC to point to the next instruction.
          */
-        std::string formatInstruction(u16& pc) const;
+        void formatInstruction(AsmEmitter& out, u16& pc) const;
 
         /**
          * @brief Format data bytes
-         * @param file Output stream
+         * @param out Emitter to append the data lines to
          * @param pc Program counter (will be updated)
          * @param originalMemory Original memory data
          * @param originalBase Base address of original memory
          * @param endAddress End address
-         * @param relocationBytes Map of relocation bytes
-         * @param memoryTags Memory type tags
+         * @param endsTune Whether endAddress is the end of the tune
          * @return Number of unused bytes zeroed out
          *
          * Outputs data bytes in assembly format (.byte directives).
-         * Handles relocation entries and unused bytes.
+         * Handles relocation entries and unused bytes, reading both from the
+         * label generator's address table.
          */
         int formatDataBytes(
-            std::ostream& file,
+            AsmEmitter& out,
             u16& pc,
             std::span<const u8> originalMemory,
             u16 originalBase,
             u16 endAddress,
-            const std::map<u16, RelocationEntry>& relocationBytes,
-            std::span<const MemoryType> memoryTags) const;
+            bool endsTune = true) const;
 
         /**
          * @brief Check if a store instruction is a CIA timer patch
@@ -99,29 +99,51 @@ namespace sidblaster {
 
         /**
          * @brief Format an instruction operand
+         * @param out Emitter to append the operand to
          * @param pc Program counter
          * @param mode Addressing mode
-         * @return Formatted operand string
          *
          * Handles different addressing modes and formats operands appropriately.
          */
-        std::string formatOperand(u16 pc, int mode) const;
+        void formatOperand(AsmEmitter& out, u16 pc, int mode) const;
 
         /**
          * @brief Format an indexed address with minimum offset
+         * @param out Emitter to append the operand to
          * @param baseAddr Base address
          * @param minOffset Minimum offset
          * @param indexReg Index register ('X' or 'Y')
-         * @return Formatted address string
          *
          * Formats addresses with index registers, accounting for offsets.
          */
-        std::string formatIndexedAddressWithMinOffset(
+        void formatIndexedAddressWithMinOffset(
+            AsmEmitter& out,
             u16 baseAddr,
             u8 minOffset,
             char indexReg) const;
 
+        /**
+         * @brief Choose the index offset an indexed operand's label is based on
+         * @param operandAddr Address of the instruction's operand
+         * @param baseAddr Base address
+         * @param minOffset Minimum index used by the instruction
+         * @return Most frequently used index whose target has a label, or minOffset
+         *
+         * Only differs from minOffset when index histograms were recorded.
+         */
+        u8 chooseIndexOffset(u16 operandAddr, u16 baseAddr, u8 minOffset) const;
+
+        /**
+         * @brief Pad to the comment column and add an address range comment
+         * @param out Emitter to append the comment to
+         * @param startPC First address covered by the line
+         * @param endPC Last address covered by the line
+         */
+        void formatAddressRangeComment(AsmEmitter& out, u16 startPC, u16 endPC) const;
+
     private:
+        static constexpr size_t CommentColumn = 97;  // Column for the address range comment
+
         const CPU6510& cpu_;                      // Reference to CPU
         const LabelGenerator& labelGenerator_;    // Reference to label generator
         std::span<const u8> memory_;              // Memory data
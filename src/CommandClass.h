@@ -27,6 +27,7 @@ namespace sidblaster {
             Relocate,      ///< Relocate a SID file to a new address
             Disassemble,   ///< Disassemble a SID file to assembly
             Trace,         ///< Trace SID register writes
+            Serve,         ///< Run JSON jobs from stdin until it closes
             Help,          ///< Show help information
             Unknown        ///< Unknown command
         };
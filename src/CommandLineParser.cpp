@@ -3,9 +3,11 @@
 #include "SIDBlasterUtils.h"
 
 #include <algorithm>
+#include <cctype>
 #include <iostream>
 #include <sstream>
 #include <set>
+#include <utility>
 
 namespace sidblaster {
 
@@ -21,6 +23,11 @@ namespace sidblaster {
         }
     }
 
+    CommandLineParser::CommandLineParser(std::string programName, std::vector<std::string> args)
+        : args_(std::move(args)),
+        programName_(std::move(programName)) {
+    }
+
     CommandClass CommandLineParser::parse() const {
         CommandClass cmd;
 
@@ -95,6 +102,9 @@ namespace sidblaster {
                         cmd.setParameter("tracelog", "trace.bin");
                         cmd.setParameter("traceformat", "binary");
                     }
+                    else if (option == "serve") {
+                        cmd.setType(CommandClass::Type::Serve);
+                    }
                     else if (option == "help" || option == "h") {
                         cmd.setType(CommandClass::Type::Help);
                     }
@@ -110,10 +120,16 @@ namespace sidblaster {
                             static const std::set<std::string> valueOptions = {
                                 "kickass", "input", "title", "author", "copyright",
                                 "sidloadaddr", "sidinitaddr", "sidplayaddr", "playeraddr",
-                                "exomizer"
+                                "exomizer", "profile", "heatmap", "worstframes", "stats", "timeline",
+                                "budget"
                             };
 
-                            if (valueOptions.find(option) != valueOptions.end()) {
+                            // A bare -budget means one whole frame, so only a number is its value
+                            const std::string& next = args_[i];
+                            const bool isValue = option != "budget" || (!next.empty() &&
+                                std::all_of(next.begin(), next.end(), [](unsigned char c) { return std::isdigit(c) != 0; }));
+
+                            if (valueOptions.find(option) != valueOptions.end() && isValue) {
                                 cmd.setParameter(option, args_[i++]);
                             }
                             else {
@@ -170,15 +186,19 @@ namespace sidblaster {
         std::cout << "  " << programName_ << " -trace[=<file>] inputfile.sid" << std::endl;
         std::cout << "  " << programName_ << " -player[=<type>] inputfile.sid outputfile.prg" << std::endl;
         std::cout << "  " << programName_ << " -disassemble inputfile.sid outputfile.asm" << std::endl;
+        std::cout << "  " << programName_ << " -serve < jobs.ndjson" << std::endl;
         std::cout << "  " << programName_ << " -help" << std::endl;
         std::cout << std::endl;
 
         // Command descriptions - updated with new syntax
         std::cout << "COMMANDS:" << std::endl;
         std::cout << "  -relocate=<address>    Relocate a SID file to a new memory address" << std::endl;
+        std::cout << "                         (a comma-separated list writes one file per address)" << std::endl;
         std::cout << "  -trace[=<file>]        Trace SID register writes during emulation" << std::endl;
         std::cout << "  -player[=<type>]       Link SID music with a player to create executable PRG" << std::endl;
         std::cout << "  -disassemble           Disassemble a SID file to assembly code" << std::endl;
+        std::cout << "  -serve                 Run JSON jobs from stdin, one per line, writing one JSON result" << std::endl;
+        std::cout << "                         line per job to stdout (see ReadMe.md for the job format)" << std::endl;
         std::cout << "  -help                  Display this help information" << std::endl;
         std::cout << std::endl;
 
@@ -187,6 +207,7 @@ namespace sidblaster {
         std::cout << "  -player                Use the default player (SimpleRaster)" << std::endl;
         std::cout << "  -player=<type>         Specify player type, e.g.: -player=SimpleBitmap or -player=RaistlinBars" << std::endl;
         std::cout << "  -playeraddr=<address>  Player load address (default: $4000)" << std::endl;
+        std::cout << "  -watch                 Rebuild the PRG every time the SID file is saved" << std::endl;
         std::cout << std::endl;
 
         // Trace command options
@@ -199,10 +220,23 @@ namespace sidblaster {
 
         // General options
         std::cout << "GENERAL OPTIONS:" << std::endl;
-        std::cout << "  -verbose               Enable verbose logging" << std::endl;
+        std::cout << "  -verbose               Enable verbose logging and print per-stage timings" << std::endl;
         std::cout << "  -force                 Force overwrite of output file" << std::endl;
         std::cout << "  -log=<file>            Log file path (default: SIDBlaster.log)" << std::endl;
         std::cout << "  -kickass=<path>        Path to KickAss.jar assembler" << std::endl;
+        std::cout << "  -profile=<file>        Write a per-subroutine rastertime profile of the play routine" << std::endl;
+        std::cout << "                         (flamegraph folded stacks go to <file> with a .folded extension)" << std::endl;
+        std::cout << "  -heatmap=<file>        Write per-address execution, cycle, read and write counts" << std::endl;
+        std::cout << "                         (binary to <file>, CSV to <file> with a .csv extension)" << std::endl;
+        std::cout << "  -heatcomments          Append execution counts and cycles to disassembled code lines" << std::endl;
+        std::cout << "  -budget[=<cycles>]     Fail if any frame uses more cycles than the budget" << std::endl;
+        std::cout << "                         (default: one full frame, cyclesPerLine * linesPerFrame)" << std::endl;
+        std::cout << "  -worstframes=<file>    Write the most expensive frames, with CPU snapshots to replay" << std::endl;
+        std::cout << "                         them (snapshots go to <file> with a .snap extension)" << std::endl;
+        std::cout << "  -stats=<file>          Write wall/CPU time, peak memory, bytes written and emulation" << std::endl;
+        std::cout << "                         counts for each processing stage as JSON" << std::endl;
+        std::cout << "  -timeline=<file>       Write stages, tool runs and emulation phases as Chrome trace" << std::endl;
+        std::cout << "                         events (open in chrome://tracing or ui.perfetto.dev)" << std::endl;
         std::cout << std::endl;
 
         // Examples - updated with new syntax
@@ -227,9 +261,19 @@ namespace sidblaster {
         std::cout << "    Links music.sid with SimpleBitmap player" << std::endl;
         std::cout << std::endl;
 
+        std::cout << "  " << programName_ << " -player -watch music.sid music.prg" << std::endl;
+        std::cout << "    Rebuilds music.prg whenever music.sid is saved" << std::endl;
+        std::cout << std::endl;
+
         std::cout << "  " << programName_ << " -disassemble music.sid music.asm" << std::endl;
         std::cout << "    Disassembles music.sid to assembly code in music.asm" << std::endl;
         std::cout << std::endl;
+
+        std::cout << "  " << programName_ << " -profile=music.txt -disassemble music.sid music.asm" << std::endl;
+        std::cout << "    Also writes a rastertime profile to music.txt and music.folded" << std::endl;
+        std::cout << "  " << programName_ << " -budget=4000 -disassemble music.sid music.asm" << std::endl;
+        std::cout << "    Fails if any frame of music.sid uses more than 4000 cycles" << std::endl;
+        std::cout << std::endl;
     }
 
     CommandLineParser& CommandLineParser::addFlagDefinition(
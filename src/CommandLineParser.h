@@ -24,6 +24,13 @@ namespace sidblaster {
          */
         CommandLineParser(int argc, char** argv);
 
+        /**
+         * @brief Constructor for arguments that did not come from main()
+         * @param programName Program name
+         * @param args Arguments, without the program name
+         */
+        CommandLineParser(std::string programName, std::vector<std::string> args);
+
         /**
          * @brief Parse the command line arguments
          * @return Command object representing the parsed arguments
@@ -63,6 +63,7 @@ namespace sidblaster {
             // Development Settings
             configValues_["debugComments"] = "true";
             configValues_["keepTempFiles"] = "false";
+            configValues_["indexHistogram"] = "false";
 
             // Compression tool options
             configValues_["exomizerOptions"] = "-x 3 -q";
@@ -204,13 +205,17 @@ namespace sidblaster {
             ss << "# Keep temporary files after processing\n";
             ss << "keepTempFiles=" << configValues_["keepTempFiles"] << "\n\n";
 
+            ss << "# Record how often each index value is used by every indexed instruction,\n";
+            ss << "# so indexed operands are labelled from the table they mostly access\n";
+            ss << "indexHistogram=" << configValues_["indexHistogram"] << "\n\n";
+
             // Add any custom settings not included in our sections
             std::vector<std::string> handledKeys = {
                 "kickassPath", "exomizerPath", "pucrunchPath", "compressorType", "exomizerOptions", "pucrunchOptions",
                 "defaultSidLoadAddress", "defaultSidInitAddress", "defaultSidPlayAddress",
                 "playerName", "playerAddress", "playerDirectory", "defaultPlayCallsPerFrame",
                 "emulationFrames", "cyclesPerLine", "linesPerFrame",
-                "logFile", "logLevel", "debugComments", "keepTempFiles"
+                "logFile", "logLevel", "debugComments", "keepTempFiles", "indexHistogram"
             };
 
             bool hasCustomSettings = false;
@@ -8,11 +8,79 @@
 #include "DisassemblyWriter.h"
 #include "LabelGenerator.h"
 #include "MemoryAnalyzer.h"
+#include "PipelineStats.h"
 #include "SIDLoader.h"
 #include "cpu6510.h"
 
+#include <algorithm>
+#include <chrono>
+
 namespace sidblaster {
 
+    namespace {
+
+        /**
+         * @brief Pack blocks of the tune into free memory windows
+         * @param blocks Blocks in address order, with the number of bytes each assembles to
+         * @param windows First and last addresses of the free windows, in order of preference
+         * @return Segments covering the tune in address order, or empty if the blocks do not fit
+         *
+         * First fit in address order keeps neighbouring blocks together, so
+         * most of them need no segment of their own. If that leaves a block
+         * over, first fit by decreasing size packs tighter.
+         */
+        std::vector<MemorySegment> packIntoWindows(
+            const std::vector<std::pair<std::pair<u16, u16>, u32>>& blocks,
+            std::span<const std::pair<u16, u16>> windows) {
+
+            std::vector<u32> newStarts(blocks.size());
+            const auto firstFit = [&](const std::vector<size_t>& order) {
+                std::vector<u32> next;
+                for (const auto& window : windows) {
+                    next.push_back(window.first);
+                }
+                for (const size_t i : order) {
+                    size_t w = 0;
+                    while (w < windows.size() && next[w] + blocks[i].second > windows[w].second + 1u) {
+                        ++w;
+                    }
+                    if (w == windows.size()) {
+                        return false;
+                    }
+                    newStarts[i] = next[w];
+                    next[w] += blocks[i].second;
+                }
+                return true;
+            };
+
+            std::vector<size_t> order(blocks.size());
+            for (size_t i = 0; i < order.size(); ++i) {
+                order[i] = i;
+            }
+            if (!firstFit(order)) {
+                std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+                    return blocks[a].second > blocks[b].second;
+                    });
+                if (!firstFit(order)) {
+                    return {};
+                }
+            }
+
+            // A block placed straight after its neighbour continues the neighbour's segment
+            std::vector<MemorySegment> segments;
+            for (size_t i = 0; i < blocks.size(); ++i) {
+                const auto& [range, size] = blocks[i];
+                if (!segments.empty() && newStarts[i] == newStarts[i - 1] + blocks[i - 1].second) {
+                    segments.back().originalEnd = range.second;
+                    continue;
+                }
+                segments.push_back({ range.first, range.second, static_cast<u16>(newStarts[i]) });
+            }
+            return segments;
+        }
+
+    } // anonymous namespace
+
     /**
      * @brief Constructor for Disassembler
      *
@@ -85,11 +153,154 @@ namespace sidblaster {
         util::Logger::debug("Disassembler initialization complete");
     }
 
+    /**
+     * @brief Append heat map execution counts to code line comments
+     *
+     * @param enabled Whether to add the counts
+     */
+    void Disassembler::setExecutionCountComments(bool enabled) {
+        writer_->setExecutionCountComments(enabled);
+    }
+
+    /**
+     * @brief Leave unused data out of the output instead of zeroing it
+     *
+     * @param enabled Whether to remove unused data
+     */
+    void Disassembler::setCompaction(bool enabled) {
+        compact_ = enabled;
+    }
+
+    /**
+     * @brief Split the tune up to fit into free memory windows
+     *
+     * @param windows First and last addresses of each free window, in order of preference
+     */
+    void Disassembler::setScatterWindows(std::vector<std::pair<u16, u16>> windows) {
+        scatterWindows_ = std::move(windows);
+    }
+
+    /**
+     * @brief Get the runs of unused data left out of the output
+     *
+     * @return Start and end addresses of the removed runs, in address order
+     */
+    std::vector<std::pair<u16, u16>> Disassembler::getRemovedRanges() const {
+        return analyzer_->findRemovedRanges();
+    }
+
+    /**
+     * @brief Pack the tune into the scatter windows and label the segments
+     *
+     * Removed bytes take no space, and a block of nothing but removed bytes
+     * goes with the block after it (or before it, at the end of the tune).
+     *
+     * @param pointerRanges Address ranges the traced pointers depend on
+     */
+    void Disassembler::scatter(std::span<const std::pair<u16, u16>> pointerRanges) {
+        std::vector<std::pair<std::pair<u16, u16>, u32>> blocks;
+        for (const auto& [start, end] : analyzer_->findMovableBlocks(cpu_, pointerRanges)) {
+            u32 size = 0;
+            for (u32 addr = start; addr <= end; ++addr) {
+                size += (analyzer_->getMemoryType(static_cast<u16>(addr)) & MemoryType::Removed) ? 0 : 1;
+            }
+            if (!blocks.empty() && blocks.back().second == 0) {
+                blocks.back().first.second = end;
+                blocks.back().second = size;
+            }
+            else if (!blocks.empty() && size == 0) {
+                blocks.back().first.second = end;
+            }
+            else {
+                blocks.push_back({ { start, end }, size });
+            }
+        }
+
+        segments_ = packIntoWindows(blocks, scatterWindows_);
+        if (segments_.empty()) {
+            util::Logger::error("The tune does not fit into the free memory windows");
+            return;
+        }
+        util::Logger::info("Scattered into " + std::to_string(segments_.size()) + " segments from " +
+            std::to_string(blocks.size()) + " movable blocks");
+
+        labelGenerator_->labelSegments(segments_);
+        writer_->setSegments(segments_);
+    }
+
+    /**
+     * @brief Analyze the emulation: memory types, relocations and labels
+     *
+     * Classifies memory, finds code the emulation never reached, resolves the
+     * indirect accesses into relocation entries, removes unused data if
+     * compaction is on, and builds the labels and the address table the
+     * writer reads. Later calls do nothing.
+     */
+    void Disassembler::analyze() {
+        if (analyzed_) {
+            return;
+        }
+
+        util::StageTimer analyzeStage("analyze");
+
+        // NOW perform the analysis AFTER all CPU execution is complete
+        util::Logger::debug("Performing memory analysis...");
+        analyzer_->analyzeExecution();
+
+        // Code the emulation never reached still has to relocate
+        const u16 entryPoints[] = { sid_.getInitAddress(), sid_.getPlayAddress() };
+        const int unexecutedBytes = analyzer_->analyzeStaticCode(cpu_, entryPoints);
+        if (unexecutedBytes > 0) {
+            util::Logger::info(std::to_string(unexecutedBytes) + " bytes of code were never executed; " +
+                "they were found by following branches and jumps");
+            for (const auto& [start, end] : analyzer_->findUnexecutedCodeRanges()) {
+                util::Logger::debug("Unexecuted code: $" + util::wordToHex(start) + "-$" + util::wordToHex(end));
+            }
+        }
+
+        analyzer_->analyzeAccesses();
+        analyzer_->analyzeData();
+
+        // Process any detected indirect accesses to identify relocation entries
+        util::Logger::debug("Processing indirect memory accesses...");
+        writer_->processIndirectAccesses();
+
+        // Compaction needs the pointers traced, and has to finish before any label is placed
+        const auto pointerRanges = writer_->getPointerRanges();
+        if (compact_) {
+            const int removedBytes = analyzer_->removeUnusedData(cpu_, pointerRanges);
+            util::Logger::info(std::to_string(removedBytes) + " unused bytes can be removed");
+            for (const auto& [start, end] : analyzer_->findRemovedRanges()) {
+                util::Logger::debug("Removed: $" + util::wordToHex(start) + "-$" + util::wordToHex(end));
+            }
+        }
+
+        // Generate labels based on the analysis
+        util::Logger::debug("Generating labels...");
+        labelGenerator_->generateLabels();
+
+        // Apply any pending subdivisions to data blocks
+        labelGenerator_->applySubdivisions();
+        if (compact_) {
+            labelGenerator_->labelCompactedBlocks();
+        }
+        if (!scatterWindows_.empty()) {
+            scatter(pointerRanges);
+        }
+
+        // Flatten labels, memory types and relocations into the address table
+        labelGenerator_->buildAddressTable(writer_->getRelocationTable());
+
+        analyzed_ = true;
+    }
+
     /**
      * @brief Generate an assembly file from the loaded SID
      *
      * Performs analysis on the CPU memory, generates labels, processes
      * memory access patterns, and produces an assembly language output file.
+     * The analysis is only done once, so later calls can write the same
+     * analysis to other load addresses.
      *
      * @param outputPath Path to write the assembly file
      * @param sidLoad New SID load address (for relocation)
@@ -108,25 +319,28 @@ namespace sidblaster {
             return -1;
         }
 
-        // NOW perform the analysis AFTER all CPU execution is complete
-        util::Logger::debug("Performing memory analysis...");
-        analyzer_->analyzeExecution();
-        analyzer_->analyzeAccesses();
-        analyzer_->analyzeData();
+        util::StageTimer stage("disassemble");
+        stage.addOutputFile(outputPath);
+        const auto stageStart = std::chrono::steady_clock::now();
 
-        // Process any detected indirect accesses to identify relocation entries
-        util::Logger::debug("Processing indirect memory accesses...");
-        writer_->processIndirectAccesses();
+        analyze();
 
-        // Generate labels based on the analysis
-        util::Logger::debug("Generating labels...");
-        labelGenerator_->generateLabels();
+        // Generate the assembly file
+        const auto writeStart = std::chrono::steady_clock::now();
+        int unusedBytes = 0;
+        {
+            util::StageTimer writeStage("write asm");
+            writeStage.addOutputFile(outputPath);
+            unusedBytes = writer_->generateAsmFile(outputPath, sidLoad, sidInit, sidPlay);
+        }
+        const auto stageEnd = std::chrono::steady_clock::now();
 
-        // Apply any pending subdivisions to data blocks
-        labelGenerator_->applySubdivisions();
+        using Micros = std::chrono::duration<double, std::micro>;
+        util::Logger::info("Disassembly stage took " +
+            std::to_string(Micros(stageEnd - stageStart).count() / 1000.0) + " ms (text generation " +
+            std::to_string(Micros(stageEnd - writeStart).count() / 1000.0) + " ms)");
 
-        // Generate the assembly file
-        return writer_->generateAsmFile(outputPath, sidLoad, sidInit, sidPlay);
+        return unusedBytes;
     }
 
 } // namespace sidblaster
\ No newline at end of file
@@ -5,11 +5,13 @@
 // ==================================
 #pragma once
 
+#include "MemoryAnalyzer.h"
 #include "SIDBlasterUtils.h"
 
 #include <functional>
 #include <memory>
 #include <string>
+#include <vector>
 
 /**
  * @file Disassembler.h
@@ -61,7 +63,9 @@ namespace sidblaster {
          * @return Number of unused bytes removed, or -1 on error
          *
          * Performs the entire disassembly process and writes the result
-         * to the specified output file.
+         * to the specified output file. The analysis is done by the first
+         * call only; later calls write the same analysis again, so one
+         * emulation can be written out for several load addresses.
          */
         int generateAsmFile(
             const std::string& outputPath,
@@ -69,6 +73,63 @@ namespace sidblaster {
             u16 sidInit,
             u16 sidPlay);
 
+        /**
+         * @brief Append heat map execution counts to code line comments
+         * @param enabled Whether to add the counts
+         *
+         * Has no effect unless the CPU collected a heat map.
+         */
+        void setExecutionCountComments(bool enabled);
+
+        /**
+         * @brief Leave unused data out of the output instead of zeroing it
+         * @param enabled Whether to remove unused data
+         *
+         * Has to be set before the analysis. Everything after a removed run
+         * moves down, so the output is smaller than the original tune.
+         */
+        void setCompaction(bool enabled);
+
+        /**
+         * @brief Analyze the emulation: memory types, relocations and labels
+         *
+         * Done by the first generateAsmFile() call if not called before;
+         * call it directly to query the removed ranges before writing.
+         */
+        void analyze();
+
+        /**
+         * @brief Get the runs of unused data left out of the output
+         * @return Start and end addresses of the removed runs, in address order
+         *
+         * Empty unless compaction was enabled and the analysis has run.
+         */
+        std::vector<std::pair<u16, u16>> getRemovedRanges() const;
+
+        /**
+         * @brief Split the tune up to fit into free memory windows
+         * @param windows First and last addresses of each free window, in order of preference
+         *
+         * Has to be set before the analysis. The tune is cut where nothing
+         * depends on the bytes either side staying together, and the pieces
+         * are packed into the windows; each is assembled at its own address.
+         */
+        void setScatterWindows(std::vector<std::pair<u16, u16>> windows);
+
+        /**
+         * @brief Get where each run of the tune is assembled
+         * @return Segments covering the tune in address order
+         *
+         * Empty unless scatter windows were set and the tune fit into them.
+         */
+        const std::vector<MemorySegment>& getSegments() const { return segments_; }
+
+        /**
+         * @brief Check whether the tune is to be scattered
+         * @return True if scatter windows were set
+         */
+        bool hasScatterWindows() const { return !scatterWindows_.empty(); }
+
     private:
         const CPU6510& cpu_;  // Reference to CPU
         const SIDLoader& sid_;  // Reference to SID loader
@@ -79,12 +140,25 @@ namespace sidblaster {
         std::unique_ptr<CodeFormatter> formatter_;
         std::unique_ptr<DisassemblyWriter> writer_;
 
+        bool analyzed_ = false;  // Whether analyze() has run
+        bool compact_ = false;   // Whether unused data is removed
+        std::vector<std::pair<u16, u16>> scatterWindows_;  // Free windows to split the tune into
+        std::vector<MemorySegment> segments_;              // Where the runs of a scattered tune go
+
         /**
          * @brief Initialize the disassembler components
          *
          * Sets up all the necessary components for the disassembly process.
          */
         void initialize();
+
+        /**
+         * @brief Pack the tune into the scatter windows and label the segments
+         * @param pointerRanges Address ranges the traced pointers depend on
+         *
+         * Leaves segments_ empty if the tune does not fit.
+         */
+        void scatter(std::span<const std::pair<u16, u16>> pointerRanges);
     };
 
 } // namespace sidblaster
\ No newline at end of file
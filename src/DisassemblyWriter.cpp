@@ -37,7 +37,9 @@ namespace sidblaster {
         sid_(sid),
         analyzer_(analyzer),
         labelGenerator_(labelGenerator),
-        formatter_(formatter) {
+        formatter_(formatter),
+        accessSlots_(256, EmptySlot) {
+        indirectAccesses_.reserve(128);
     }
 
     /**
@@ -60,38 +62,54 @@ namespace sidblaster {
 
         util::Logger::info("Generating assembly file: " + filename);
 
-        // Open the output file
-        std::ofstream file(filename);
-        if (!file) {
-            util::Logger::error("Failed to open output file: " + filename);
-            return 0;
-        }
+        // Everything is built in memory and written out in one go
+        AsmEmitter out(static_cast<size_t>(sid_.getDataSize()) * 64 + 4096);
 
         // Write file header
-        file << "//; ------------------------------------------\n";
-        file << "//; Generated by " << SIDBLASTER_VERSION << "\n";
-        file << "//; \n";
-        file << "//; Name: " << sid_.getHeader().name << "\n";
-        file << "//; Author: " << sid_.getHeader().author << "\n";
-        file << "//; Copyright: " << sid_.getHeader().copyright << "\n";
-        file << "//; ------------------------------------------\n\n";
+        out.put("//; ------------------------------------------\n");
+        out.put("//; Generated by " SIDBLASTER_VERSION "\n");
+        out.put("//; \n");
+        out.put("//; Name: ");
+        out.put(sid_.getHeader().name);
+        out.put("\n//; Author: ");
+        out.put(sid_.getHeader().author);
+        out.put("\n//; Copyright: ");
+        out.put(sid_.getHeader().copyright);
+        out.put("\n//; ------------------------------------------\n\n");
 
         // Output addresses as constants
-        file << ".const SIDLoad = $" << util::wordToHex(sidLoad) << "\n";
+        out.put(".const SIDLoad = $");
+        out.putHex16(sidLoad);
+        out.put('\n');
 
         // Output hardware registers as constants
-        outputHardwareConstants(file);
+        outputHardwareConstants(out);
 
         // Output zero page defines
-        emitZPDefines(file);
+        emitZPDefines(out);
 
         // Disassemble to file
-        int unusedByteCount = disassembleToFile(file);
+        int unusedByteCount = disassembleToFile(out);
 
         // Output unused byte count
-        file << "//; " << unusedByteCount << " unused bytes zeroed out\n\n";
+        out.put("//; ");
+        out.putDecimal(unusedByteCount);
+        out.put(" unused bytes zeroed out\n");
+
+        int removedByteCount = 0;
+        for (const auto& [start, end] : analyzer_.findRemovedRanges()) {
+            removedByteCount += end - start + 1;
+        }
+        if (removedByteCount > 0) {
+            out.put("//; ");
+            out.putDecimal(removedByteCount);
+            out.put(" unused bytes removed\n");
+        }
+        out.put('\n');
 
-        file.close();
+        if (!out.writeToFile(filename)) {
+            return 0;
+        }
 
         return unusedByteCount;
     }
@@ -100,141 +118,230 @@ namespace sidblaster {
      * @brief Add an indirect memory access
      *
      * Records information about an indirect memory access for later analysis.
-     * Enhanced to collect more detailed information about pointer usage.
+     * Called for every indexed-indirect instruction executed, so the lookup is
+     * a hash probe and nothing is allocated once a pointer and its targets
+     * have been seen.
      *
      * @param pc Program counter
      * @param zpAddr Zero page address
      * @param targetAddr Target address
      */
     void DisassemblyWriter::addIndirectAccess(u16 pc, u8 zpAddr, u16 targetAddr) {
-        // Get the sources of the ZP variables
-        const auto& lowSource = cpu_.getWriteSourceInfo(zpAddr);
-        const auto& highSource = cpu_.getWriteSourceInfo(zpAddr + 1);
-
-        // Get the last instructions that wrote to these ZP addresses
-        u16 lastWriteLow = cpu_.getLastWriteTo(zpAddr);
-        u16 lastWriteHigh = cpu_.getLastWriteTo(zpAddr + 1);
-
-        // Look for an existing record for this ZP address
-        IndirectAccessInfo* existingInfo = nullptr;
-        for (auto& existing : indirectAccesses_) {
-            if (existing.zpAddr == zpAddr &&
-                existing.sourceLowAddress == lowSource.address &&
-                existing.sourceHighAddress == highSource.address) {
-                existingInfo = &existing;
-                break;
-            }
+        // Get the origins of the ZP variables (address is 0 if the value was never read from memory)
+        const TaintTag lowTaint = cpu_.getTaint(zpAddr);
+        const TaintTag highTaint = cpu_.getTaint(static_cast<u8>(zpAddr + 1));
+        const u16 lowAddress = lowTaint.isValid() ? lowTaint.origin : 0;
+        const u16 highAddress = highTaint.isValid() ? highTaint.origin : 0;
+
+        const u64 key = (static_cast<u64>(zpAddr) << 32) | (static_cast<u64>(lowAddress) << 16) | highAddress;
+
+        // The same pointer is usually dereferenced many times in a row
+        u32 index = lastAccess_;
+        if (index == EmptySlot || indirectAccesses_[index].key != key) {
+            index = findOrAddIndirectAccess(key, pc, zpAddr);
+            lastAccess_ = index;
         }
 
-        // If not found, create a new entry
-        if (!existingInfo) {
-            IndirectAccessInfo info;
-            info.instructionAddress = pc;
-            info.zpAddr = zpAddr;
-            info.lastWriteLow = lastWriteLow;
-            info.lastWriteHigh = lastWriteHigh;
-
-            // Capture source addresses when available
-            if (lowSource.type == RegisterSourceInfo::SourceType::Memory) {
-                info.sourceLowAddress = lowSource.address;
-            }
+        // Add this target address to the entry's sorted set if not already present
+        auto& targets = indirectAccesses_[index].targetAddresses;
+        const auto pos = std::lower_bound(targets.begin(), targets.end(), targetAddr);
+        if (pos == targets.end() || *pos != targetAddr) {
+            targets.insert(pos, targetAddr);
+        }
+    }
 
-            if (highSource.type == RegisterSourceInfo::SourceType::Memory) {
-                info.sourceHighAddress = highSource.address;
+    /**
+     * @brief Find or create the record for an indirect access key
+     *
+     * Linear probing with the table kept at most half full. New records are
+     * appended, so indirectAccesses_ stays in first-seen order.
+     *
+     * @param key Packed (zpAddr, sourceLowAddress, sourceHighAddress)
+     * @param pc Program counter of the accessing instruction
+     * @param zpAddr Zero page address
+     * @return Index of the record in indirectAccesses_
+     */
+    u32 DisassemblyWriter::findOrAddIndirectAccess(u64 key, u16 pc, u8 zpAddr) {
+        const auto slotFor = [](u64 k, size_t mask) {
+            return static_cast<size_t>((k * 0x9E3779B97F4A7C15ull) >> 32) & mask;
+        };
+
+        size_t mask = accessSlots_.size() - 1;
+        size_t slot = slotFor(key, mask);
+        while (accessSlots_[slot] != EmptySlot) {
+            if (indirectAccesses_[accessSlots_[slot]].key == key) {
+                return accessSlots_[slot];
             }
-
-            // Add this target address
-            info.targetAddresses.push_back(targetAddr);
-
-            // Add to the collection
-            indirectAccesses_.push_back(info);
+            slot = (slot + 1) & mask;
         }
-        else {
-            // Add this target address to the existing entry if not already present
-            if (std::find(existingInfo->targetAddresses.begin(),
-                existingInfo->targetAddresses.end(),
-                targetAddr) == existingInfo->targetAddresses.end()) {
-                existingInfo->targetAddresses.push_back(targetAddr);
+
+        // Not found - create a new entry
+        IndirectAccessInfo info;
+        info.key = key;
+        info.instructionAddress = pc;
+        info.zpAddr = zpAddr;
+        info.lastWriteLow = cpu_.getLastWriteTo(zpAddr);
+        info.lastWriteHigh = cpu_.getLastWriteTo(zpAddr + 1);
+        info.sourceLowAddress = static_cast<u16>(key >> 16);
+        info.sourceHighAddress = static_cast<u16>(key);
+        const auto memory = cpu_.getMemory();
+        info.pointerBase = static_cast<u16>(memory[zpAddr] | (memory[static_cast<u8>(zpAddr + 1)] << 8));
+        info.targetAddresses.reserve(8);
+
+        const u32 index = static_cast<u32>(indirectAccesses_.size());
+        indirectAccesses_.push_back(std::move(info));
+        accessSlots_[slot] = index;
+
+        // Grow the index once it is half full
+        if (indirectAccesses_.size() * 2 > accessSlots_.size()) {
+            accessSlots_.assign(accessSlots_.size() * 2, EmptySlot);
+            mask = accessSlots_.size() - 1;
+            for (u32 i = 0; i < indirectAccesses_.size(); ++i) {
+                slot = slotFor(indirectAccesses_[i].key, mask);
+                while (accessSlots_[slot] != EmptySlot) {
+                    slot = (slot + 1) & mask;
+                }
+                accessSlots_[slot] = i;
             }
         }
+
+        return index;
     }
 
     /**
      * @brief Process all recorded indirect accesses
      *
-     * Analyzes indirect access patterns to identify address references
-     * and pointer tables. Updated to use the new RelocationTable approach.
+     * Each pointer half is traced back to the byte its value was first read
+     * from, so that byte is the one to relocate. Its target is rebuilt from
+     * the byte's original value and the other half of the pointer, which
+     * keeps the emitted byte equal to the original even when the value was
+     * offset (ADC/SBC) on its way into the pointer.
      */
     void DisassemblyWriter::processIndirectAccesses() {
         if (indirectAccesses_.empty()) {
             return;
         }
 
-        // Get memory data flow from CPU
-        const auto& dataFlow = cpu_.getMemoryDataFlow();
-
         // Clear any existing entries in relocTable_
         relocTable_.clear();
+        relocationConflicts_ = 0;
 
-        // Process each indirect access - now tracking multiple targets
         for (const auto& access : indirectAccesses_) {
-            // Use ONLY THE FIRST target address - this should be the original one we want
-            // This is the key change to fix the issue
-            if (!access.targetAddresses.empty()) {
-                u16 targetAddr = access.targetAddresses[0]; // Use the FIRST target address
+            if (access.sourceLowAddress != 0) {
+                addRelocationFact(access.sourceLowAddress, lowByteTarget(access), RelocationEntry::Type::Low);
+                const_cast<LabelGenerator&>(labelGenerator_).addPendingSubdivisionAddress(access.sourceLowAddress);
+            }
 
-                // Process the source address for LOW byte
-                if (access.sourceLowAddress != 0) {
-                    // Add entry to relocation table with the FIRST target address
-                    relocTable_.addEntry(access.sourceLowAddress, targetAddr, RelocationEntry::Type::Low);
+            if (access.sourceHighAddress != 0) {
+                addRelocationFact(access.sourceHighAddress, highByteTarget(access), RelocationEntry::Type::High);
+                const_cast<LabelGenerator&>(labelGenerator_).addPendingSubdivisionAddress(access.sourceHighAddress);
+            }
+        }
 
-                    // Mark for potential subdivision
-                    const_cast<LabelGenerator&>(labelGenerator_).addPendingSubdivisionAddress(access.sourceLowAddress);
+        if (relocationConflicts_ > 0) {
+            util::Logger::warning(std::to_string(relocationConflicts_) +
+                " relocation byte(s) were reached with conflicting targets - the last fact was kept");
+        }
+    }
 
-                    // Follow data flow chain
-                    processRelocationChain(dataFlow, relocTable_, access.sourceLowAddress, targetAddr, RelocationEntry::Type::Low);
-                }
+    /**
+     * @brief Get the address the traced low byte of a pointer refers to
+     *
+     * @param access Indirect access with a traced low byte
+     * @return Pointer page combined with the low byte as it was loaded
+     */
+    u16 DisassemblyWriter::lowByteTarget(const IndirectAccessInfo& access) const {
+        return (access.pointerBase & 0xFF00) | originalByte(access.sourceLowAddress, access.pointerBase & 0xFF);
+    }
 
-                // Process the source address for HIGH byte
-                if (access.sourceHighAddress != 0) {
-                    // Add entry to relocation table with the FIRST target address
-                    relocTable_.addEntry(access.sourceHighAddress, targetAddr, RelocationEntry::Type::High);
+    /**
+     * @brief Get the address the traced high byte of a pointer refers to
+     *
+     * @param access Indirect access with a traced high byte
+     * @return High byte as it was loaded combined with the pointer's low byte
+     */
+    u16 DisassemblyWriter::highByteTarget(const IndirectAccessInfo& access) const {
+        return (originalByte(access.sourceHighAddress, access.pointerBase >> 8) << 8) | (access.pointerBase & 0xFF);
+    }
+
+    /**
+     * @brief Get the address ranges the traced pointers depend on
+     *
+     * @return One range per traced pointer
+     */
+    std::vector<std::pair<u16, u16>> DisassemblyWriter::getPointerRanges() const {
+        std::vector<std::pair<u16, u16>> ranges;
+        ranges.reserve(indirectAccesses_.size());
 
-                    // Mark for potential subdivision
-                    const_cast<LabelGenerator&>(labelGenerator_).addPendingSubdivisionAddress(access.sourceHighAddress);
+        for (const auto& access : indirectAccesses_) {
+            u16 first = access.pointerBase;
+            u16 last = access.pointerBase;
+            const auto include = [&](u16 addr) {
+                first = std::min(first, addr);
+                last = std::max(last, addr);
+            };
 
-                    // Follow data flow chain
-                    processRelocationChain(dataFlow, relocTable_, access.sourceHighAddress, targetAddr, RelocationEntry::Type::High);
-                }
+            if (!access.targetAddresses.empty()) {
+                include(access.targetAddresses.front());
+                include(access.targetAddresses.back());
             }
+            if (access.sourceLowAddress != 0) {
+                include(lowByteTarget(access));
+            }
+            if (access.sourceHighAddress != 0) {
+                include(highByteTarget(access));
+            }
+            if (access.sourceLowAddress == 0 || access.sourceHighAddress == 0) {
+                first = 0;
+            }
+
+            ranges.emplace_back(first, last);
         }
+
+        return ranges;
     }
 
-    void DisassemblyWriter::processRelocationChain(
-        const MemoryDataFlow& dataFlow,
-        RelocationTable& relocTable,
-        u16 addr,
-        u16 targetAddr,
-        RelocationEntry::Type relocType) {
-
-        // Add entry with the EXACT target address as received - no adjustments
-        relocTable.addEntry(addr, targetAddr, relocType);
-
-        // Mark this source address for potential subdivision
-        const_cast<LabelGenerator&>(labelGenerator_).addPendingSubdivisionAddress(addr);
-
-        // Find any other memory locations that write to this address
-        auto it = dataFlow.memoryWriteSources.find(addr);
-        if (it != dataFlow.memoryWriteSources.end()) {
-            // Process each source address that writes to this address
-            for (u16 newAddr : it->second) {
-                // Skip self-references to avoid infinite recursion
-                if (newAddr != addr) {
-                    // Use SAME target address for all chain entries to ensure consistency
-                    processRelocationChain(dataFlow, relocTable, newAddr, targetAddr, relocType);
-                }
-            }
+    /**
+     * @brief Get a byte of the tune as it was loaded
+     *
+     * @param addr Address of the byte
+     * @param fallback Value to use outside the loaded data
+     * @return The byte before emulation changed it
+     */
+    u8 DisassemblyWriter::originalByte(u16 addr, u8 fallback) const {
+        const auto& original = sid_.getOriginalMemory();
+        const u16 base = sid_.getOriginalMemoryBase();
+        if (addr < base || static_cast<size_t>(addr - base) >= original.size()) {
+            return fallback;
         }
+        return original[addr - base];
+    }
+
+    /**
+     * @brief Get the relocation table built from indirect accesses
+     *
+     * @return Relocation table
+     */
+    const RelocationTable& DisassemblyWriter::getRelocationTable() const {
+        return relocTable_;
+    }
+
+    /**
+     * @brief Record a relocation fact, reporting any conflict with an earlier one
+     *
+     * @param addr Byte holding half of an address
+     * @param targetAddr Address the byte refers to
+     * @param relocType Whether the byte is the low or high half
+     */
+    void DisassemblyWriter::addRelocationFact(u16 addr, u16 targetAddr, RelocationEntry::Type relocType) {
+        const RelocationEntry* existing = relocTable_.getEntry(addr);
+        if (existing && (existing->targetAddress != targetAddr || existing->type != relocType)) {
+            ++relocationConflicts_;
+            util::Logger::warning("Conflicting relocation for $" + util::wordToHex(addr) + ": " +
+                existing->toString() + " vs " + RelocationEntry{ targetAddr, relocType }.toString());
+        }
+
+        relocTable_.addEntry(addr, targetAddr, relocType);
     }
 
     /**
@@ -243,9 +350,9 @@ namespace sidblaster {
      * Identifies hardware components (like SID chips) that are accessed
      * in the code and generates appropriate constant definitions.
      *
-     * @param file Output stream
+     * @param out Emitter to append the constants to
      */
-    void DisassemblyWriter::outputHardwareConstants(std::ofstream& file) {
+    void DisassemblyWriter::outputHardwareConstants(AsmEmitter& out) {
         // Find all accessed hardware components
 
         // SID detection
@@ -272,7 +379,11 @@ namespace sidblaster {
                 HardwareType::SID, base, sidIndex, name);
 
             // Output to assembly file
-            file << ".const " << name << " = $" << util::wordToHex(base) << "\n";
+            out.put(".const ");
+            out.put(name);
+            out.put(" = $");
+            out.putHex16(base);
+            out.put('\n');
 
             sidIndex++;
         }
@@ -282,7 +393,7 @@ namespace sidblaster {
         // CIA detection (0xDC00-0xDCFF for CIA1, 0xDD00-0xDDFF for CIA2)
         // etc.
 
-        file << "\n";
+        out.put('\n');
     }
 
     /**
@@ -291,9 +402,9 @@ namespace sidblaster {
      * Identifies zero page variables used by the code and generates
      * appropriate constant definitions.
      *
-     * @param file Output stream
+     * @param out Emitter to append the definitions to
      */
-    void DisassemblyWriter::emitZPDefines(std::ofstream& file) {
+    void DisassemblyWriter::emitZPDefines(AsmEmitter& out) {
         // Collect all used zero page addresses
         std::set<u8> usedZP;
         for (u16 addr = 0x0000; addr <= 0x00FF; ++addr) {
@@ -314,16 +425,24 @@ namespace sidblaster {
         u8 zpBase = 0xFF - static_cast<u8>(zpList.size()) + 1;
 
         // Output ZP defines
-        file << ".const ZP_BASE = $" << util::byteToHex(zpBase) << "\n";
+        out.put(".const ZP_BASE = $");
+        out.putHex8(zpBase);
+        out.put('\n');
         for (size_t i = 0; i < zpList.size(); ++i) {
             std::string varName = "ZP_" + std::to_string(i);
-            file << ".const " << varName << " = ZP_BASE + " << i << " // $" << util::byteToHex(zpList[i]) << "\n";
+            out.put(".const ");
+            out.put(varName);
+            out.put(" = ZP_BASE + ");
+            out.putDecimal(static_cast<long long>(i));
+            out.put(" // $");
+            out.putHex8(zpList[i]);
+            out.put('\n');
 
             // Add to label generator
             const_cast<LabelGenerator&>(labelGenerator_).addZeroPageVar(zpList[i], varName);
         }
 
-        file << "\n";
+        out.put('\n');
     }
 
     /**
@@ -332,42 +451,101 @@ namespace sidblaster {
      * Performs the actual disassembly writing to the file, handling code,
      * data, and labels appropriately.
      *
-     * @param file Output stream
+     * @param out Emitter to append the disassembly to
      * @return Number of unused bytes removed
      */
-    int DisassemblyWriter::disassembleToFile(std::ofstream& file) {
+    int DisassemblyWriter::disassembleToFile(AsmEmitter& out) {
         u16 pc = sid_.getLoadAddress();
-        file << "\n* = SIDLoad\n\n";
+        if (segments_.empty()) {
+            out.put("\n* = SIDLoad\n\n");
+        }
 
          const u16 sidEnd = sid_.getLoadAddress() + sid_.getDataSize();
         int unusedByteCount = 0;
 
+        // Data runs must not carry on into the next segment
+        size_t nextSegment = 0;
+        u16 blockEnd = sidEnd;
+
         while (pc < sidEnd) {
+            if (nextSegment < segments_.size() && pc == segments_[nextSegment].originalStart) {
+                const MemorySegment& segment = segments_[nextSegment++];
+                out.put("\n* = $");
+                out.putHex16(segment.newStart);
+                out.put("    //; $");
+                out.putHex16(segment.originalStart);
+                out.put(" - ");
+                out.putHex16(segment.originalEnd);
+                out.put("\n\n");
+                blockEnd = static_cast<u16>(segment.originalEnd + 1);
+                if (blockEnd == 0) {
+                    blockEnd = sidEnd;
+                }
+            }
+
+            const AddressAnnotation& annotation = labelGenerator_.getAnnotation(pc);
+
             // Check if we need to output a label
-            const std::string label = labelGenerator_.getLabel(pc);
-            if (!label.empty() && (analyzer_.getMemoryType(pc) & MemoryType::Code)) {
-                file << label << ":\n";
+            const std::string& label = labelGenerator_.getLabel(pc);
+            if (!label.empty() && (annotation.type & MemoryType::Code)) {
+                out.put(label);
+                out.put(":\n");
             }
 
             // Check if this is code or data
-            if (analyzer_.getMemoryType(pc) & MemoryType::Code) {
+            if (annotation.type & MemoryType::Code) {
                 const u16 startPc = pc;
-                const std::string line = formatter_.formatInstruction(pc);
-
-                file << util::padToColumn(line, 96);
-                file << " //; $" << util::wordToHex(startPc) << " - "
-                    << util::wordToHex(pc - 1) << "\n";
+                formatter_.formatInstruction(out, pc);
+
+                out.padToColumn(96);
+                out.put(" //; $");
+                out.putHex16(startPc);
+                out.put(" - ");
+                out.putHex16(static_cast<u16>(pc - 1));
+
+                // Hot-spot information from the heat map, if collected
+                const HeatMap* heatMap = executionCountComments_ ? cpu_.getHeatMap() : nullptr;
+                if (heatMap && heatMap->executions[startPc] > 0) {
+                    out.put(" | x");
+                    out.putDecimal(heatMap->executions[startPc]);
+                    out.put(", ");
+                    out.putDecimal(static_cast<long long>(heatMap->cycles[startPc]));
+                    out.put(" cycles");
+                }
+                if (annotation.type & MemoryType::Unexecuted) {
+                    out.put(" | never executed");
+                }
+                out.put('\n');
             }
-            else if (analyzer_.getMemoryType(pc) & MemoryType::Data) {
+            else if (annotation.type & MemoryType::Data) {
                 // Format data bytes
                 unusedByteCount += formatter_.formatDataBytes(
-                    file,
+                    out,
                     pc,
                     sid_.getOriginalMemory(),
                     sid_.getOriginalMemoryBase(),
-                    sidEnd,
-                    relocTable_.getAllEntries(),
-                    analyzer_.getMemoryTypes());
+                    blockEnd,
+                    segments_.empty());
+            }
+            else if (annotation.type & MemoryType::Removed) {
+                // Nothing is emitted, so everything after the run moves down
+                const u16 runStart = pc;
+                while (pc < blockEnd && (labelGenerator_.getAnnotation(pc).type & MemoryType::Removed)) {
+                    const std::string& runLabel = labelGenerator_.getLabel(pc);
+                    if (!runLabel.empty()) {
+                        out.put(runLabel);
+                        out.put(":\n");
+                    }
+                    ++pc;
+                }
+
+                out.put("    //; $");
+                out.putHex16(runStart);
+                out.put(" - ");
+                out.putHex16(static_cast<u16>(pc - 1));
+                out.put(": ");
+                out.putDecimal(pc - runStart);
+                out.put(" unused bytes removed\n");
             }
             else {
                 // Unknown memory type, just increment PC
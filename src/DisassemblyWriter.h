@@ -6,6 +6,7 @@
 #pragma once
 
 #include "cpu6510.h"
+#include "AsmEmitter.h"
 #include "CodeFormatter.h"
 #include "LabelGenerator.h"
 #include "MemoryAnalyzer.h"
@@ -101,6 +102,36 @@ namespace sidblaster {
          */
         void processIndirectAccesses();
 
+        /**
+         * @brief Get the relocation table built from indirect accesses
+         * @return Relocation table
+         */
+        const RelocationTable& getRelocationTable() const;
+
+        /**
+         * @brief Get the address ranges the traced pointers depend on
+         * @return One range per traced pointer: its first value, its relocated
+         *         halves and every address read through it
+         *
+         * A pointer assembled from two relocated halves only stays correct if
+         * nothing inside its range moves. If a half was not traced, the range
+         * starts at $0000, so the pointer's whole target keeps its offset from
+         * the load address.
+         */
+        std::vector<std::pair<u16, u16>> getPointerRanges() const;
+
+        /**
+         * @brief Append heat map execution counts to code line comments
+         * @param enabled Whether to add the counts
+         */
+        void setExecutionCountComments(bool enabled) { executionCountComments_ = enabled; }
+
+        /**
+         * @brief Assemble runs of the tune at their own addresses
+         * @param segments Runs covering the tune in address order, or empty for one block at SIDLoad
+         */
+        void setSegments(std::vector<MemorySegment> segments) { segments_ = std::move(segments); }
+
     private:
         const CPU6510& cpu_;                      // Reference to CPU
         const SIDLoader& sid_;                    // Reference to SID loader
@@ -109,6 +140,9 @@ namespace sidblaster {
         const CodeFormatter& formatter_;          // Reference to code formatter
 
         RelocationTable relocTable_;              // Map of bytes that need relocation
+        int relocationConflicts_ = 0;             // Bytes reached with more than one distinct fact
+        bool executionCountComments_ = false;     // Append heat map counts to code lines
+        std::vector<MemorySegment> segments_;     // Where each run of the tune is assembled (empty: all at SIDLoad)
 
         /**
          * @brief Struct for tracking indirect memory accesses
@@ -117,42 +151,85 @@ namespace sidblaster {
          * to identify address references and pointer tables.
          */
         struct IndirectAccessInfo {
+            u64 key = 0;                  // Packed (zpAddr, sourceLowAddress, sourceHighAddress)
             u16 instructionAddress = 0;   // Address of the instruction
             u8 zpAddr = 0;                // Zero page pointer address (low byte)
             u16 lastWriteLow = 0;         // Address of last write to low byte
             u16 lastWriteHigh = 0;        // Address of last write to high byte
-            u16 sourceLowAddress = 0;     // Source of the low byte value
-            u16 sourceHighAddress = 0;    // Source of the high byte value
-            std::vector<u16> targetAddresses; // ALL target addresses for this ZP pointer
+            u16 sourceLowAddress = 0;     // Origin of the low byte value
+            u16 sourceHighAddress = 0;    // Origin of the high byte value
+            u16 pointerBase = 0;          // Pointer value when first dereferenced
+            std::vector<u16> targetAddresses; // ALL target addresses, kept sorted
         };
-        std::vector<IndirectAccessInfo> indirectAccesses_;  // List of indirect accesses
+        std::vector<IndirectAccessInfo> indirectAccesses_;  // List of indirect accesses, in first-seen order
+
+        static constexpr u32 EmptySlot = 0xFFFFFFFF;
+        std::vector<u32> accessSlots_;            // Open-addressing index into indirectAccesses_
+        u32 lastAccess_ = EmptySlot;              // Entry hit by the previous access
+
+        /**
+         * @brief Find or create the record for an indirect access key
+         * @param key Packed (zpAddr, sourceLowAddress, sourceHighAddress)
+         * @param pc Program counter of the accessing instruction
+         * @param zpAddr Zero page address
+         * @return Index of the record in indirectAccesses_
+         */
+        u32 findOrAddIndirectAccess(u64 key, u16 pc, u8 zpAddr);
+
+        /**
+         * @brief Get the address the traced low byte of a pointer refers to
+         * @param access Indirect access with a traced low byte
+         * @return Pointer page combined with the low byte as it was loaded
+         */
+        u16 lowByteTarget(const IndirectAccessInfo& access) const;
+
+        /**
+         * @brief Get the address the traced high byte of a pointer refers to
+         * @param access Indirect access with a traced high byte
+         * @return High byte as it was loaded combined with the pointer's low byte
+         */
+        u16 highByteTarget(const IndirectAccessInfo& access) const;
 
         /**
          * @brief Output hardware constants to the assembly file
-         * @param file Output stream
+         * @param out Emitter to append the constants to
          *
          * Writes hardware-related constant definitions.
          */
-        void outputHardwareConstants(std::ofstream& file);
+        void outputHardwareConstants(AsmEmitter& out);
 
         /**
          * @brief Output zero page definitions to the assembly file
-         * @param file Output stream
+         * @param out Emitter to append the definitions to
          *
          * Writes zero page variable definitions.
          */
-        void emitZPDefines(std::ofstream& file);
+        void emitZPDefines(AsmEmitter& out);
 
         /**
          * @brief Disassemble to the output file
-         * @param file Output stream
+         * @param out Emitter to append the disassembly to
          * @return Number of unused bytes removed
          *
          * Performs the actual disassembly writing to the file.
          */
-        int disassembleToFile(std::ofstream& file);
+        int disassembleToFile(AsmEmitter& out);
 
-        void processRelocationChain(const MemoryDataFlow& dataFlow, RelocationTable& relocTable, u16 addr, u16 targetAddr, RelocationEntry::Type relocType);
+        /**
+         * @brief Get a byte of the tune as it was loaded
+         * @param addr Address of the byte
+         * @param fallback Value to use outside the loaded data
+         * @return The byte before emulation changed it
+         */
+        u8 originalByte(u16 addr, u8 fallback) const;
+
+        /**
+         * @brief Record a relocation fact, reporting any conflict with an earlier one
+         * @param addr Byte holding half of an address
+         * @param targetAddr Address the byte refers to
+         * @param relocType Whether the byte is the low or high half
+         */
+        void addRelocationFact(u16 addr, u16 targetAddr, RelocationEntry::Type relocType);
 
     };
 
@@ -0,0 +1,135 @@
+// ==================================
+//             SIDBlaster
+//
+//  Raistlin / Genesis Project (G*P)
+// ==================================
+#pragma once
+
+#include <coroutine>
+#include <exception>
+#include <iterator>
+#include <memory>
+#include <utility>
+
+namespace sidblaster {
+    namespace util {
+
+        /**
+         * @class Generator
+         * @brief Lazily evaluated sequence produced by a coroutine
+         *
+         * A minimal stand-in for C++23 std::generator. The coroutine runs only
+         * when the consumer advances, and each yielded value is passed by
+         * reference and stays valid until the next advance. Destroying the
+         * generator early destroys the suspended coroutine, running the
+         * destructors of its locals.
+         *
+         * @tparam T Type of the yielded values
+         */
+        template <typename T>
+        class Generator {
+        public:
+            struct promise_type {
+                const T* current = nullptr;         // Most recently yielded value
+                std::exception_ptr exception;       // Exception thrown by the coroutine body
+
+                Generator get_return_object() { return Generator(Handle::from_promise(*this)); }
+                std::suspend_always initial_suspend() noexcept { return {}; }
+                std::suspend_always final_suspend() noexcept { return {}; }
+                std::suspend_always yield_value(const T& value) noexcept {
+                    current = std::addressof(value);
+                    return {};
+                }
+                void return_void() noexcept {}
+                void unhandled_exception() { exception = std::current_exception(); }
+
+                // Generators only yield; awaiting inside one is not supported
+                template <typename U>
+                std::suspend_never await_transform(U&&) = delete;
+            };
+
+            using Handle = std::coroutine_handle<promise_type>;
+
+            /**
+             * @brief Input iterator over the yielded values
+             */
+            class iterator {
+            public:
+                using iterator_category = std::input_iterator_tag;
+                using difference_type = std::ptrdiff_t;
+                using value_type = T;
+
+                iterator() = default;
+                explicit iterator(Handle handle) : handle_(handle) {}
+
+                const T& operator*() const { return *handle_.promise().current; }
+                const T* operator->() const { return handle_.promise().current; }
+
+                iterator& operator++() {
+                    resume(handle_);
+                    return *this;
+                }
+                void operator++(int) { ++*this; }
+
+                bool operator==(std::default_sentinel_t) const { return !handle_ || handle_.done(); }
+
+            private:
+                Handle handle_;
+            };
+
+            Generator(Generator&& other) noexcept : handle_(std::exchange(other.handle_, {})) {}
+
+            Generator& operator=(Generator&& other) noexcept {
+                if (this != &other) {
+                    if (handle_) {
+                        handle_.destroy();
+                    }
+                    handle_ = std::exchange(other.handle_, {});
+                }
+                return *this;
+            }
+
+            Generator(const Generator&) = delete;
+            Generator& operator=(const Generator&) = delete;
+
+            ~Generator() {
+                if (handle_) {
+                    handle_.destroy();
+                }
+            }
+
+            /**
+             * @brief Run the coroutine to its first value
+             * @return Iterator at the first value (or at the end)
+             */
+            iterator begin() {
+                resume(handle_);
+                return iterator(handle_);
+            }
+
+            /**
+             * @brief End of the sequence
+             * @return Sentinel compared against by iterators
+             */
+            std::default_sentinel_t end() const noexcept { return {}; }
+
+        private:
+            explicit Generator(Handle handle) : handle_(handle) {}
+
+            /**
+             * @brief Run the coroutine to its next value, rethrowing anything it threw
+             */
+            static void resume(Handle handle) {
+                if (handle && !handle.done()) {
+                    handle.resume();
+                    if (handle.promise().exception) {
+                        std::rethrow_exception(std::exchange(handle.promise().exception, {}));
+                    }
+                }
+            }
+
+            Handle handle_;     // Coroutine producing the values
+        };
+
+    } // namespace util
+} // namespace sidblaster
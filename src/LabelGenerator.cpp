@@ -7,7 +7,6 @@
 #include "SIDBlasterUtils.h"
 
 #include <algorithm>
-#include <sstream>
 
 namespace sidblaster {
 
@@ -77,15 +76,92 @@ namespace sidblaster {
             " data block labels");
     }
 
+    /**
+     * @brief Build the per-address annotation table
+     *
+     * Flattens the memory types, label map, data blocks and relocation entries
+     * into a single 64K array. The nearest label below each address is found
+     * with one upward sweep, so later lookups never touch the maps.
+     *
+     * @param relocTable Relocation entries to fold into the table
+     */
+    void LabelGenerator::buildAddressTable(const RelocationTable& relocTable) {
+        labelNames_.clear();
+        labelNames_.reserve(labelMap_.size() + dataBlocks_.size());
+        addressTable_.assign(65536, AddressAnnotation{});
+
+        // Memory types
+        const auto memoryTypes = analyzer_.getMemoryTypes();
+        for (size_t addr = 0; addr < addressTable_.size() && addr < memoryTypes.size(); ++addr) {
+            addressTable_[addr].type = memoryTypes[addr];
+        }
+
+        // Exact labels
+        for (const auto& [addr, label] : labelMap_) {
+            addressTable_[addr].labelId = static_cast<u32>(labelNames_.size());
+            labelNames_.push_back(label);
+        }
+
+        // Relocation bytes
+        for (const auto& [addr, entry] : relocTable.getAllEntries()) {
+            addressTable_[addr].hasRelocation = true;
+            addressTable_[addr].relocation = entry;
+        }
+
+        // Nearest label at or below each address. A label at $0000 is never
+        // used as a base here - such addresses fall through to the data blocks.
+        u32 nearestId = AddressAnnotation::NoLabel;
+        u16 nearestAddr = 0;
+        for (u32 addr = 1; addr < 65536; ++addr) {
+            auto& entry = addressTable_[addr];
+            if (entry.labelId != AddressAnnotation::NoLabel) {
+                nearestId = entry.labelId;
+                nearestAddr = static_cast<u16>(addr);
+            }
+            entry.nearestLabelId = nearestId;
+            entry.nearestOffset = static_cast<u16>(addr - nearestAddr);
+        }
+
+        // Anything still without a base uses the first data block containing it
+        for (const auto& block : dataBlocks_) {
+            u32 blockId = AddressAnnotation::NoLabel;
+            for (u32 addr = block.start; addr <= block.end; ++addr) {
+                auto& entry = addressTable_[addr];
+                if (entry.nearestLabelId != AddressAnnotation::NoLabel) {
+                    continue;
+                }
+                if (blockId == AddressAnnotation::NoLabel) {
+                    blockId = static_cast<u32>(labelNames_.size());
+                    labelNames_.push_back(block.label);
+                }
+                entry.nearestLabelId = blockId;
+                entry.nearestOffset = static_cast<u16>(addr - block.start);
+            }
+        }
+
+        util::Logger::debug("Built address table with " + std::to_string(labelNames_.size()) + " label names");
+    }
+
+    /**
+     * @brief Get the annotation for a given address
+     *
+     * @param addr Address to look up
+     * @return Annotation entry for the address
+     */
+    const AddressAnnotation& LabelGenerator::getAnnotation(u16 addr) const {
+        return addressTable_[addr];
+    }
+
     /**
      * @brief Get the label for a given address
      *
      * @param addr Address to look up
      * @return Label for the address, or empty string if no label
      */
-    std::string LabelGenerator::getLabel(u16 addr) const {
-        auto it = labelMap_.find(addr);
-        return (it != labelMap_.end()) ? it->second : "";
+    const std::string& LabelGenerator::getLabel(u16 addr) const {
+        static const std::string noLabel;
+        const u32 id = addressTable_[addr].labelId;
+        return (id != AddressAnnotation::NoLabel) ? labelNames_[id] : noLabel;
     }
 
     /**
@@ -104,10 +180,10 @@ namespace sidblaster {
      * labels and offsets as appropriate. Special handling is applied
      * for hardware registers.
      *
+     * @param out Emitter to append the formatted address to
      * @param addr Address to format
-     * @return Formatted string
      */
-    std::string LabelGenerator::formatAddress(u16 addr) const {
+    void LabelGenerator::formatAddress(AsmEmitter& out, u16 addr) const {
         // Hardware component check - SID registers
         static const u16 sidBaseAddr = 0xD400;
         static const u16 sidEndAddr = 0xD7FF;
@@ -119,17 +195,19 @@ namespace sidblaster {
             // Find the SID index in the registered hardware bases
             for (const auto& hw : usedHardwareBases_) {
                 if (hw.type == HardwareType::SID && hw.address == base) {
-                    if (offset == 0) {
-                        return hw.name; // Return just "SID0", "SID1", etc. for the base address
-                    }
-                    else {
-                        return hw.name + "+" + std::to_string(offset); // "SID0+1", etc. for offsets
+                    out.put(hw.name); // "SID0", "SID1", etc. for the base address
+                    if (offset != 0) {
+                        out.put('+');  // "SID0+1", etc. for offsets
+                        out.putDecimal(offset);
                     }
+                    return;
                 }
             }
 
             // If not found in registered bases, use a default SID0 reference
-            return "SID0+" + std::to_string(addr - sidBaseAddr);
+            out.put("SID0+");
+            out.putDecimal(addr - sidBaseAddr);
+            return;
         }
 
         // Future hardware components can be added here:
@@ -137,58 +215,27 @@ namespace sidblaster {
         // CIA check (0xDC00-0xDCFF for CIA1, 0xDD00-0xDDFF for CIA2)
         // etc.
 
-        // Check for exact label match
-        auto it = labelMap_.find(addr);
-        if (it != labelMap_.end()) {
-            return it->second;
-        }
+        const auto& entry = addressTable_[addr];
 
-        // No exact match, try to find a label for an address range containing this address
-        u16 bestBase = 0;
-        std::string bestLabel;
-
-        // First check if the address is within a labeled code or data block
-        for (const auto& [labelAddr, label] : labelMap_) {
-            // Only consider if this label is before our target address
-            if (labelAddr <= addr) {
-                // If this is closer to our target than the current best, update
-                if (labelAddr > bestBase) {
-                    bestBase = labelAddr;
-                    bestLabel = label;
-                }
-            }
-        }
-
-        // If we found a label that's a good base for this address
-        if (!bestLabel.empty()) {
-            const u16 offset = addr - bestBase;
-            if (offset == 0) {
-                return bestLabel;
-            }
-            else {
-                std::ostringstream oss;
-                oss << bestLabel << " + $" << std::hex << std::uppercase << offset;
-                return oss.str();
-            }
+        // Check for exact label match
+        if (entry.labelId != AddressAnnotation::NoLabel) {
+            out.put(labelNames_[entry.labelId]);
+            return;
         }
 
-        // If we didn't find a label, check if it's within a data block
-        for (const auto& block : dataBlocks_) {
-            if (addr >= block.start && addr <= block.end) {
-                u16 offset = addr - block.start;
-                if (offset == 0) {
-                    return block.label;
-                }
-                else {
-                    std::ostringstream oss;
-                    oss << block.label << " + $" << std::hex << std::uppercase << offset;
-                    return oss.str();
-                }
+        // Otherwise express the address relative to the nearest label below it
+        if (entry.nearestLabelId != AddressAnnotation::NoLabel) {
+            out.put(labelNames_[entry.nearestLabelId]);
+            if (entry.nearestOffset != 0) {
+                out.put(" + $");
+                out.putHex(entry.nearestOffset);
             }
+            return;
         }
 
         // Default to hex
-        return "$" + sidblaster::util::wordToHex(addr);
+        out.put('$');
+        out.putHex16(addr);
     }
 
     /**
@@ -196,16 +243,18 @@ namespace sidblaster {
      *
      * Converts a zero page address to a symbolic name when possible.
      *
+     * @param out Emitter to append the formatted address to
      * @param addr Zero page address to format
-     * @return Formatted string
      */
-    std::string LabelGenerator::formatZeroPage(u8 addr) const {
+    void LabelGenerator::formatZeroPage(AsmEmitter& out, u8 addr) const {
         auto it = zeroPageVars_.find(addr);
         if (it != zeroPageVars_.end()) {
-            return it->second;
+            out.put(it->second);
+            return;
         }
 
-        return "$" + util::byteToHex(addr);
+        out.put('$');
+        out.putHex8(addr);
     }
 
     /**
@@ -410,6 +459,41 @@ namespace sidblaster {
         pendingSubdivisionAddresses_.clear();
     }
 
+    /**
+     * @brief Label the first byte after every run of removed data
+     *
+     * Bytes that already have a label keep it.
+     */
+    void LabelGenerator::labelCompactedBlocks() {
+        int compactedLabelCounter = 0;
+        for (const auto& [start, end] : analyzer_.findRemovedRanges()) {
+            const u32 next = end + 1u;
+            if (next < endAddress_ && labelMap_.find(static_cast<u16>(next)) == labelMap_.end()) {
+                labelMap_[static_cast<u16>(next)] = "Compacted_" + std::to_string(compactedLabelCounter++);
+            }
+        }
+
+        util::Logger::debug("Added " + std::to_string(compactedLabelCounter) + " labels after removed data");
+    }
+
+    /**
+     * @brief Label the first byte of every segment
+     *
+     * Bytes that already have a label keep it.
+     *
+     * @param segments Runs of the tune assembled at their own addresses
+     */
+    void LabelGenerator::labelSegments(std::span<const MemorySegment> segments) {
+        int segmentLabelCounter = 0;
+        for (const auto& segment : segments) {
+            if (labelMap_.find(segment.originalStart) == labelMap_.end()) {
+                labelMap_[segment.originalStart] = "Segment_" + std::to_string(segmentLabelCounter++);
+            }
+        }
+
+        util::Logger::debug("Added " + std::to_string(segmentLabelCounter) + " labels at segment starts");
+    }
+
     /**
      * @brief Get the label map (address to label)
      *
@@ -435,6 +519,13 @@ namespace sidblaster {
         int index,
         const std::string& name) {
 
+        // Every written file registers the same bases again
+        for (const auto& hw : usedHardwareBases_) {
+            if (hw.type == type && hw.address == address) {
+                return;
+            }
+        }
+
         HardwareBase base;
         base.type = type;
         base.address = address;
@@ -5,7 +5,9 @@
 // ==================================
 #pragma once
 
+#include "AsmEmitter.h"
 #include "MemoryAnalyzer.h"
+#include "RelocationStructs.h"
 #include "SIDBlasterUtils.h"
 
 #include <map>
@@ -66,6 +68,25 @@ namespace sidblaster {
         std::string name;   // Name used in assembly output
     };
 
+    /**
+     * @struct AddressAnnotation
+     * @brief Everything the disassembly output needs to know about one address
+     *
+     * One entry exists for every address in the 64K space. The table is built
+     * once after labeling so that formatting an operand or data byte is a single
+     * array index rather than a series of map lookups and scans.
+     */
+    struct AddressAnnotation {
+        static constexpr u32 NoLabel = 0xFFFFFFFF;  // Marker for "no label"
+
+        MemoryType type = MemoryType::Unknown;  // Memory classification from the analyzer
+        bool hasRelocation = false;             // Whether this byte holds half of an address
+        RelocationEntry relocation{};           // Relocation details (valid if hasRelocation)
+        u32 labelId = NoLabel;                  // Label defined exactly at this address
+        u32 nearestLabelId = NoLabel;           // Label used as a base to express this address
+        u16 nearestOffset = 0;                  // Offset of this address from that base
+    };
+
     /**
      * @class LabelGenerator
      * @brief Generates and manages labels for disassembled code
@@ -95,12 +116,28 @@ namespace sidblaster {
          */
         void generateLabels();
 
+        /**
+         * @brief Build the per-address annotation table
+         * @param relocTable Relocation entries to fold into the table
+         *
+         * Must be called after labels and subdivisions are final; getLabel,
+         * formatAddress and getAnnotation all read from this table.
+         */
+        void buildAddressTable(const RelocationTable& relocTable);
+
+        /**
+         * @brief Get the annotation for a given address
+         * @param addr Address to look up
+         * @return Annotation entry for the address
+         */
+        const AddressAnnotation& getAnnotation(u16 addr) const;
+
         /**
          * @brief Get the label for a given address
          * @param addr Address to look up
          * @return Label for the address, or empty string if no label
          */
-        std::string getLabel(u16 addr) const;
+        const std::string& getLabel(u16 addr) const;
 
         /**
          * @brief Get all identified data blocks
@@ -110,22 +147,22 @@ namespace sidblaster {
 
         /**
          * @brief Format an address with its label and offset
+         * @param out Emitter to append the formatted address to
          * @param addr Address to format
-         * @return Formatted string
          *
          * This converts numeric addresses to more readable symbols,
          * optionally with offsets (e.g., "Label+5").
          */
-        std::string formatAddress(u16 addr) const;
+        void formatAddress(AsmEmitter& out, u16 addr) const;
 
         /**
          * @brief Format a zero page address with its label
+         * @param out Emitter to append the formatted address to
          * @param addr Zero page address to format
-         * @return Formatted string
          *
          * Converts zero page addresses to symbolic names when possible.
          */
-        std::string formatZeroPage(u8 addr) const;
+        void formatZeroPage(AsmEmitter& out, u8 addr) const;
 
         /**
          * @brief Add a zero page variable definition
@@ -186,6 +223,24 @@ namespace sidblaster {
          */
         void applySubdivisions();
 
+        /**
+         * @brief Label the first byte after every run of removed data
+         *
+         * Call after applySubdivisions() when unused data was removed. The
+         * nearest label below an address is the base it is written against,
+         * so a label after each run keeps every offset within kept bytes.
+         */
+        void labelCompactedBlocks();
+
+        /**
+         * @brief Label the first byte of every segment
+         * @param segments Runs of the tune assembled at their own addresses
+         *
+         * Call after applySubdivisions(). An offset from a label in another
+         * segment would not survive the move, so each segment gets its own base.
+         */
+        void labelSegments(std::span<const MemorySegment> segments);
+
         /**
          * @brief Get the label map (address to label)
          * @return Map of addresses to labels
@@ -217,6 +272,9 @@ namespace sidblaster {
         std::unordered_map<std::string, std::vector<AccessInfo>> dataBlockAccessMap_;
         std::unordered_map<std::string, std::vector<std::pair<u16, u16>>> dataBlockSubdivisions_;
         std::set<u16> pendingSubdivisionAddresses_;  // Addresses pending subdivision
+
+        std::vector<std::string> labelNames_;          // Label names indexed by label ID
+        std::vector<AddressAnnotation> addressTable_;  // Flat 64K annotation table
     };
 
 } // namespace sidblaster
\ No newline at end of file
@@ -5,6 +5,9 @@
 // ==================================
 #include "MemoryAnalyzer.h"
 #include "SIDBlasterUtils.h"
+#include "cpu6510.h"
+
+#include <algorithm>
 
 namespace sidblaster {
 
@@ -74,6 +77,185 @@ namespace sidblaster {
             std::to_string(jumpCount) + " jump targets");
     }
 
+    /**
+     * @brief Find code the emulation did not reach by following control flow
+     *
+     * Recursive descent from the entry points and from the successors of every
+     * executed instruction. The instructions reached from one start form a
+     * path; if any of them looks like data (BRK or an undocumented opcode, a
+     * byte the emulation read, wrote or executed as part of another
+     * instruction, or an instruction running past the end of the tune) the
+     * whole path is dropped. Data after an always-taken branch is usually
+     * read, so it is not mistaken for code; bytes that were never touched at
+     * all are emitted unchanged whichever way they are classified.
+     *
+     * @param cpu CPU whose opcode table decodes the instructions
+     * @param entryPoints Addresses execution starts from (init and play)
+     * @return Number of code bytes found that never ran
+     */
+    int MemoryAnalyzer::analyzeStaticCode(const CPU6510& cpu, std::span<const u16> entryPoints) {
+        util::Logger::debug("Following control flow through unexecuted code...");
+
+        constexpr u8 OpcodeBRK = 0x00;
+        constexpr u8 OpcodeJSR = 0x20;
+        constexpr u8 OpcodeRTI = 0x40;
+        constexpr u8 OpcodeJMP = 0x4C;
+        constexpr u8 OpcodeRTS = 0x60;
+        constexpr u8 OpcodeJMPIndirect = 0x6C;
+
+        // Bytes of the instructions found so far
+        enum : u8 { NotFound, FoundOpcode, FoundOperand };
+        std::vector<u8> found(65536, NotFound);
+
+        const auto executedOpcode = [this](u16 addr) {
+            return (memoryAccess_[addr] & (MemoryAccess_Execute | MemoryAccess_OpCode)) ==
+                (MemoryAccess_Execute | MemoryAccess_OpCode);
+        };
+
+        // Calls visit(address, isJump) for every address control can pass to from pc
+        const auto forEachSuccessor = [this, &cpu](u16 pc, auto&& visit) {
+            const u8 opcode = memory_[pc];
+            const u16 operand = static_cast<u16>(memory_[static_cast<u16>(pc + 1)] | (memory_[static_cast<u16>(pc + 2)] << 8));
+            const u16 next = static_cast<u16>(pc + cpu.getInstructionSize(opcode));
+
+            if (cpu.getAddressingMode(opcode) == AddressingMode::Relative) {
+                visit(static_cast<u16>(next + static_cast<i8>(memory_[static_cast<u16>(pc + 1)])), true);
+                visit(next, false);
+                return;
+            }
+            switch (opcode) {
+            case OpcodeJSR:
+                visit(operand, true);
+                visit(next, false);
+                break;
+            case OpcodeJMP:
+                visit(operand, true);
+                break;
+            case OpcodeJMPIndirect: {
+                // The vector's current value; the 6502 does not carry into the high byte's page
+                const u16 highAddr = static_cast<u16>((operand & 0xFF00) | ((operand + 1) & 0x00FF));
+                visit(static_cast<u16>(memory_[operand] | (memory_[highAddr] << 8)), true);
+                break;
+            }
+            case OpcodeRTS:
+            case OpcodeRTI:
+            case OpcodeBRK:
+                break;
+            default:
+                visit(next, false);
+                break;
+            }
+        };
+
+        std::vector<u16> worklist;
+        std::vector<u16> path;
+        std::vector<u16> jumpTargets;
+
+        // Follow everything reachable from start; keep it only if none of it looks like data
+        const auto followPath = [&](u16 start) {
+            worklist.assign(1, start);
+            path.clear();
+            bool looksLikeData = false;
+
+            while (!worklist.empty() && !looksLikeData) {
+                const u16 pc = worklist.back();
+                worklist.pop_back();
+
+                if (pc < startAddress_ || pc >= endAddress_ || executedOpcode(pc) || found[pc] == FoundOpcode) {
+                    continue;   // Outside the tune, or already known code
+                }
+                if (found[pc] == FoundOperand) {
+                    looksLikeData = true;   // Decodes across an instruction already found
+                    break;
+                }
+
+                const u8 opcode = memory_[pc];
+                const u32 size = cpu.getInstructionSize(opcode);
+                if (opcode == OpcodeBRK || cpu.isIllegalInstruction(opcode) || pc + size > endAddress_) {
+                    looksLikeData = true;
+                    break;
+                }
+                // Operands may be self-modified, but opcodes of code that never ran are not touched
+                if (memoryAccess_[pc] & (MemoryAccess_Execute | MemoryAccess_Read | MemoryAccess_Write)) {
+                    looksLikeData = true;
+                    break;
+                }
+                for (u32 i = 1; i < size; ++i) {
+                    const u16 addr = static_cast<u16>(pc + i);
+                    if ((memoryAccess_[addr] & MemoryAccess_Execute) || found[addr] != NotFound) {
+                        looksLikeData = true;
+                        break;
+                    }
+                }
+                if (looksLikeData) {
+                    break;
+                }
+
+                found[pc] = FoundOpcode;
+                for (u32 i = 1; i < size; ++i) {
+                    found[pc + i] = FoundOperand;
+                }
+                path.push_back(pc);
+
+                forEachSuccessor(pc, [&](u16 target, bool isJump) {
+                    worklist.push_back(target);
+                    if (isJump) {
+                        jumpTargets.push_back(target);
+                    }
+                    });
+            }
+
+            if (looksLikeData) {
+                for (const u16 pc : path) {
+                    const u32 size = cpu.getInstructionSize(memory_[pc]);
+                    for (u32 i = 0; i < size; ++i) {
+                        found[pc + i] = NotFound;
+                    }
+                }
+                path.clear();
+            }
+            return path.size();
+        };
+
+        int pathCount = 0;
+        const auto tryStart = [&](u16 start, bool isJump) {
+            if (isJump) {
+                jumpTargets.push_back(start);
+            }
+            if (start >= startAddress_ && start < endAddress_ && !executedOpcode(start) && found[start] == NotFound &&
+                followPath(start) > 0) {
+                ++pathCount;
+            }
+        };
+
+        for (const u16 entry : entryPoints) {
+            tryStart(entry, true);
+        }
+        for (u32 addr = startAddress_; addr < endAddress_; ++addr) {
+            if (executedOpcode(static_cast<u16>(addr))) {
+                forEachSuccessor(static_cast<u16>(addr), tryStart);
+            }
+        }
+
+        int codeBytes = 0;
+        for (u32 addr = startAddress_; addr < endAddress_; ++addr) {
+            if (found[addr] != NotFound) {
+                memoryTypes_[addr] |= MemoryType::Code | MemoryType::Unexecuted;
+                ++codeBytes;
+            }
+        }
+        for (const u16 target : jumpTargets) {
+            if (found[target] == FoundOpcode) {
+                memoryTypes_[target] |= MemoryType::LabelTarget;
+            }
+        }
+
+        util::Logger::debug("Static analysis complete: " + std::to_string(codeBytes) +
+            " unexecuted code bytes in " + std::to_string(pathCount) + " paths");
+
+        return codeBytes;
+    }
+
     /**
      * @brief Analyze memory access patterns
      *
@@ -125,6 +307,204 @@ namespace sidblaster {
         util::Logger::debug("Data region analysis complete");
     }
 
+    /**
+     * @brief Mark unused data that can be left out of the output
+     *
+     * Every byte of a layout span is kept, since a reference depends on where
+     * it is relative to the others. Everything else that was never accessed
+     * can go.
+     *
+     * @param cpu CPU whose opcode table decodes the instructions
+     * @param pinnedRanges Address ranges whose layout a pointer depends on
+     * @return Number of bytes marked Removed
+     */
+    int MemoryAnalyzer::removeUnusedData(const CPU6510& cpu, std::span<const std::pair<u16, u16>> pinnedRanges) {
+        util::Logger::debug("Finding unused data to remove...");
+
+        std::vector<u8> pinned(65536, 0);
+        for (const auto& [first, last] : findLayoutSpans(cpu, pinnedRanges)) {
+            for (u32 addr = first; addr <= last; ++addr) {
+                pinned[addr] = 1;
+            }
+        }
+
+        int removedCount = 0;
+        for (u32 addr = startAddress_; addr < endAddress_; ++addr) {
+            const MemoryType type = memoryTypes_[addr];
+            if ((type & MemoryType::Data) && !(type & (MemoryType::Accessed | MemoryType::LabelTarget)) && !pinned[addr]) {
+                memoryTypes_[addr] = MemoryType::Removed;
+                ++removedCount;
+            }
+        }
+
+        util::Logger::debug("Unused data analysis complete: " + std::to_string(removedCount) + " bytes can be removed");
+
+        return removedCount;
+    }
+
+    /**
+     * @brief Split the tune into blocks that can be placed independently
+     *
+     * A boundary is allowed between two bytes unless something needs them
+     * next to each other: an instruction, execution falling through to the
+     * next instruction, a branch and its destination, or a layout span. The
+     * blocks are the runs between the allowed boundaries, so a fragmented
+     * layout can still keep neighbouring blocks together.
+     *
+     * @param cpu CPU whose opcode table decodes the instructions
+     * @param pinnedRanges Address ranges whose layout a pointer depends on
+     * @return Start and end addresses of the blocks, in address order
+     */
+    std::vector<std::pair<u16, u16>> MemoryAnalyzer::findMovableBlocks(const CPU6510& cpu, std::span<const std::pair<u16, u16>> pinnedRanges) const {
+        constexpr u8 OpcodeRTI = 0x40;
+        constexpr u8 OpcodeJMP = 0x4C;
+        constexpr u8 OpcodeRTS = 0x60;
+        constexpr u8 OpcodeJMPIndirect = 0x6C;
+
+        // joined[addr] counts the spans that forbid a boundary just below addr
+        std::vector<int> joined(65537, 0);
+        const auto join = [&](u32 first, u32 last) {
+            first = std::max<u32>(first, startAddress_);
+            last = std::min<u32>(last, endAddress_ - 1u);
+            if (first < last) {
+                ++joined[first + 1];
+                --joined[last + 1];
+            }
+        };
+
+        for (const auto& [first, last] : findLayoutSpans(cpu, pinnedRanges)) {
+            join(first, last);
+        }
+
+        for (u32 pc = startAddress_; pc < endAddress_;) {
+            if (!(memoryTypes_[pc] & MemoryType::Code)) {
+                ++pc;
+                continue;
+            }
+
+            const u8 opcode = memory_[pc];
+            const u32 size = cpu.getInstructionSize(opcode);
+            const bool endsFlow = opcode == OpcodeJMP || opcode == OpcodeJMPIndirect ||
+                opcode == OpcodeRTS || opcode == OpcodeRTI;
+            join(pc, endsFlow ? pc + size - 1 : pc + size);
+
+            // Branches only reach 128 bytes, so they cannot cross to another block
+            if (cpu.getAddressingMode(opcode) == AddressingMode::Relative) {
+                const u32 next = pc + 2;
+                const u32 dest = static_cast<u16>(next + static_cast<i8>(memory_[static_cast<u16>(pc + 1)]));
+                join(std::min(pc, dest), std::max(next - 1, dest));
+            }
+            pc += size;
+        }
+
+        std::vector<std::pair<u16, u16>> blocks;
+        int spans = 0;
+        u32 blockStart = startAddress_;
+        for (u32 addr = startAddress_ + 1u; addr < endAddress_; ++addr) {
+            spans += joined[addr];
+            if (spans == 0) {
+                blocks.emplace_back(static_cast<u16>(blockStart), static_cast<u16>(addr - 1));
+                blockStart = addr;
+            }
+        }
+        blocks.emplace_back(static_cast<u16>(blockStart), static_cast<u16>(endAddress_ - 1u));
+        return blocks;
+    }
+
+    /**
+     * @brief Find the address ranges whose layout references depend on
+     *
+     * The disassembly expresses every reference as a label plus an offset,
+     * so removing or moving bytes only breaks a reference whose offset spans
+     * them. The code is walked the way the writer decodes it, and every byte
+     * an operand can reach is covered; so are the ranges a traced pointer and
+     * its targets cover. Operands the tune rewrites take their values from
+     * bytes that are emitted unchanged (a table of low bytes of its own
+     * routines, say), which is only safe where the layout from the load
+     * address on is kept, so those cover everything below the memory they
+     * can reach. A branch covers its destination only.
+     *
+     * @param cpu CPU whose opcode table decodes the instructions
+     * @param pinnedRanges Address ranges whose layout a pointer depends on
+     * @return First and last addresses of the spans, clamped to the tune
+     */
+    std::vector<std::pair<u32, u32>> MemoryAnalyzer::findLayoutSpans(const CPU6510& cpu, std::span<const std::pair<u16, u16>> pinnedRanges) const {
+        std::vector<std::pair<u32, u32>> spans;
+        const auto add = [&](u32 first, u32 last) {
+            first = std::max<u32>(first, startAddress_);
+            last = std::min<u32>(last, endAddress_ - 1u);
+            if (first <= last) {
+                spans.emplace_back(first, last);
+            }
+        };
+
+        for (const auto& [first, last] : pinnedRanges) {
+            add(first, last);
+        }
+
+        for (u32 pc = startAddress_; pc < endAddress_;) {
+            if (!(memoryTypes_[pc] & MemoryType::Code)) {
+                ++pc;
+                continue;
+            }
+
+            const u8 opcode = memory_[pc];
+            const u16 operand = static_cast<u16>(memory_[static_cast<u16>(pc + 1)] | (memory_[static_cast<u16>(pc + 2)] << 8));
+            const bool lowWritten = (memoryAccess_[static_cast<u16>(pc + 1)] & MemoryAccess_Write) != 0;
+            const bool highWritten = (memoryAccess_[static_cast<u16>(pc + 2)] & MemoryAccess_Write) != 0;
+
+            const auto mode = cpu.getAddressingMode(opcode);
+            switch (mode) {
+            case AddressingMode::Absolute:
+            case AddressingMode::AbsoluteX:
+            case AddressingMode::AbsoluteY:
+            case AddressingMode::Indirect: {
+                // Code that never ran may use any index
+                u32 maxIndex = 0;
+                if (mode == AddressingMode::AbsoluteX || mode == AddressingMode::AbsoluteY) {
+                    maxIndex = (memoryTypes_[pc] & MemoryType::Unexecuted) ?
+                        0xFF : cpu.getIndexRange(static_cast<u16>(pc + 1)).second;
+                }
+
+                // A self-modified operand takes values from untraced bytes, which only stay
+                // right where the layout is kept: its page for a new low byte, anywhere for a new high byte
+                if (highWritten) {
+                    add(startAddress_, endAddress_ - 1u);
+                }
+                else if (lowWritten) {
+                    add(startAddress_, (operand | 0xFFu) + maxIndex + 1u);
+                }
+                else if (mode == AddressingMode::Indirect) {
+                    // The vector is written as a number, so nothing below it may move
+                    if (operand >= startAddress_ && operand < endAddress_) {
+                        add(startAddress_, operand + 1u);
+                    }
+                }
+                else {
+                    add(operand, operand + maxIndex);
+                }
+                break;
+            }
+            case AddressingMode::Relative: {
+                // A rewritten offset can reach anything in range of the branch
+                const u32 next = pc + 2;
+                if (lowWritten) {
+                    add(next - std::min<u32>(next, 0x80), next + 0x7F);
+                }
+                else {
+                    const u16 dest = static_cast<u16>(next + static_cast<i8>(memory_[static_cast<u16>(pc + 1)]));
+                    add(dest, dest);
+                }
+                break;
+            }
+            default:
+                break;
+            }
+            pc += cpu.getInstructionSize(opcode);
+        }
+        return spans;
+    }
+
     /**
      * @brief Find the start of an instruction that covers a specific address
      *
@@ -181,33 +561,7 @@ namespace sidblaster {
      * @return Vector of pairs representing start and end addresses of data blocks
      */
     std::vector<std::pair<u16, u16>> MemoryAnalyzer::findDataRanges() const {
-        std::vector<std::pair<u16, u16>> ranges;
-
-        bool inDataRange = false;
-        u16 rangeStart = 0;
-
-        // Only look at the SID range
-        for (u32 addr = startAddress_; addr < endAddress_; ++addr) {
-            const bool isData = memoryTypes_[addr] & MemoryType::Data;
-
-            if (isData && !inDataRange) {
-                // Start of a new data range
-                rangeStart = addr;
-                inDataRange = true;
-            }
-            else if (!isData && inDataRange) {
-                // End of a data range
-                ranges.emplace_back(rangeStart, addr - 1);
-                inDataRange = false;
-            }
-        }
-
-        // Handle the case where the last range extends to the end
-        if (inDataRange) {
-            ranges.emplace_back(rangeStart, endAddress_ - 1);
-        }
-
-        return ranges;
+        return findRanges(MemoryType::Data);
     }
 
     /**
@@ -218,29 +572,57 @@ namespace sidblaster {
      * @return Vector of pairs representing start and end addresses of code blocks
      */
     std::vector<std::pair<u16, u16>> MemoryAnalyzer::findCodeRanges() const {
+        return findRanges(MemoryType::Code);
+    }
+
+    /**
+     * @brief Find the code ranges that only static analysis found
+     *
+     * @return Vector of pairs representing start and end addresses of code that never ran
+     */
+    std::vector<std::pair<u16, u16>> MemoryAnalyzer::findUnexecutedCodeRanges() const {
+        return findRanges(MemoryType::Unexecuted);
+    }
+
+    /**
+     * @brief Find the runs of unused data marked by removeUnusedData()
+     *
+     * @return Vector of pairs representing start and end addresses of removed bytes
+     */
+    std::vector<std::pair<u16, u16>> MemoryAnalyzer::findRemovedRanges() const {
+        return findRanges(MemoryType::Removed);
+    }
+
+    /**
+     * @brief Find contiguous runs of a memory type inside the analyzed region
+     *
+     * @param type Memory type the bytes must have
+     * @return Vector of pairs representing start and end addresses of the runs
+     */
+    std::vector<std::pair<u16, u16>> MemoryAnalyzer::findRanges(MemoryType type) const {
         std::vector<std::pair<u16, u16>> ranges;
 
-        bool inCodeRange = false;
+        bool inRange = false;
         u16 rangeStart = 0;
 
         // Only look at the SID range
         for (u32 addr = startAddress_; addr < endAddress_; ++addr) {
-            const bool isCode = memoryTypes_[addr] & MemoryType::Code;
+            const bool matches = memoryTypes_[addr] & type;
 
-            if (isCode && !inCodeRange) {
-                // Start of a new code range
+            if (matches && !inRange) {
+                // Start of a new range
                 rangeStart = addr;
-                inCodeRange = true;
+                inRange = true;
             }
-            else if (!isCode && inCodeRange) {
-                // End of a code range
+            else if (!matches && inRange) {
+                // End of a range
                 ranges.emplace_back(rangeStart, addr - 1);
-                inCodeRange = false;
+                inRange = false;
             }
         }
 
         // Handle the case where the last range extends to the end
-        if (inCodeRange) {
+        if (inRange) {
             ranges.emplace_back(rangeStart, endAddress_ - 1);
         }
 
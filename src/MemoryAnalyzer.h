@@ -11,6 +11,8 @@
 #include <span>
 #include <vector>
 
+class CPU6510;
+
 /**
  * @file MemoryAnalyzer.h
  * @brief Analysis of CPU memory patterns for disassembly
@@ -31,7 +33,9 @@ namespace sidblaster {
         Code = 1 << 0,      // Memory containing executable code
         Data = 1 << 1,      // Memory containing data
         LabelTarget = 1 << 2, // Memory that is the target of a jump or call
-        Accessed = 1 << 3   // Memory that has been accessed during execution
+        Accessed = 1 << 3,  // Memory that has been accessed during execution
+        Unexecuted = 1 << 4, // Code found by static analysis that never ran
+        Removed = 1 << 5    // Unused data left out of a compacted relocation
     };
 
     // Operator overloads for MemoryType
@@ -48,6 +52,15 @@ namespace sidblaster {
         return a;
     }
 
+    /**
+     * @brief A run of the tune assembled at an address of its own
+     */
+    struct MemorySegment {
+        u16 originalStart = 0;  // First address in the original tune
+        u16 originalEnd = 0;    // Last address in the original tune
+        u16 newStart = 0;       // Address the run is assembled at
+    };
+
     /**
      * @class MemoryAnalyzer
      * @brief Analyzes CPU memory to identify code, data, and label targets
@@ -79,6 +92,23 @@ namespace sidblaster {
          */
         void analyzeExecution();
 
+        /**
+         * @brief Find code the emulation did not reach by following control flow
+         * @param cpu CPU whose opcode table decodes the instructions
+         * @param entryPoints Addresses execution starts from (init and play)
+         * @return Number of code bytes found that never ran
+         *
+         * Call after analyzeExecution(). Starting from the entry points and
+         * from every executed instruction, branches (both ways), JSR and JMP
+         * targets and JMP (ind) vectors are followed through bytes the
+         * emulation never executed. A path is only kept if every byte of it
+         * decodes as a documented instruction that was never read or written
+         * as data and does not overlap executed code or code already found;
+         * its bytes are then marked Code and Unexecuted, so they are
+         * disassembled as code and relocate like the code that ran.
+         */
+        int analyzeStaticCode(const CPU6510& cpu, std::span<const u16> entryPoints);
+
         /**
          * @brief Analyze memory access patterns
          *
@@ -95,6 +125,34 @@ namespace sidblaster {
          */
         void analyzeData();
 
+        /**
+         * @brief Mark unused data that can be left out of the output
+         * @param cpu CPU whose opcode table decodes the instructions
+         * @param pinnedRanges Address ranges whose layout a pointer depends on
+         * @return Number of bytes marked Removed
+         *
+         * Call after analyzeData(). A data byte is removed if it was never
+         * accessed, is not a label target, and no reference depends on its
+         * position: absolute and branch operands, the index range of indexed
+         * operands (all 256 indices for code that never ran), and the pinned
+         * ranges. Removed bytes lose their Data type, so everything after a
+         * run of them moves down when the output is assembled.
+         */
+        int removeUnusedData(const CPU6510& cpu, std::span<const std::pair<u16, u16>> pinnedRanges);
+
+        /**
+         * @brief Split the tune into blocks that can be placed independently
+         * @param cpu CPU whose opcode table decodes the instructions
+         * @param pinnedRanges Address ranges whose layout a pointer depends on
+         * @return Start and end addresses of the blocks, in address order, covering the tune
+         *
+         * Call after analyzeData(), and after removeUnusedData() when compacting.
+         * No instruction, fall-through, branch, indexed operand range or
+         * pinned range crosses from one block to another, so each block can be
+         * assembled anywhere as long as a label starts it.
+         */
+        std::vector<std::pair<u16, u16>> findMovableBlocks(const CPU6510& cpu, std::span<const std::pair<u16, u16>> pinnedRanges) const;
+
         /**
          * @brief Find the start of an instruction that covers a specific address
          * @param addr Address to find the covering instruction for
@@ -129,6 +187,18 @@ namespace sidblaster {
          */
         std::vector<std::pair<u16, u16>> findCodeRanges() const;
 
+        /**
+         * @brief Find the code ranges that only static analysis found
+         * @return Vector of pairs representing start and end addresses of code that never ran
+         */
+        std::vector<std::pair<u16, u16>> findUnexecutedCodeRanges() const;
+
+        /**
+         * @brief Find the runs of unused data marked by removeUnusedData()
+         * @return Vector of pairs representing start and end addresses of removed bytes
+         */
+        std::vector<std::pair<u16, u16>> findRemovedRanges() const;
+
         /**
          * @brief Find all addresses that should have labels
          * @return Vector of addresses that should have labels
@@ -143,6 +213,24 @@ namespace sidblaster {
         u16 startAddress_;                  // Start address of region to analyze
         u16 endAddress_;                    // End address of region to analyze
         std::vector<MemoryType> memoryTypes_; // Classification of each memory byte
+
+        /**
+         * @brief Find contiguous runs of a memory type inside the analyzed region
+         * @param type Memory type the bytes must have
+         * @return Vector of pairs representing start and end addresses of the runs
+         */
+        std::vector<std::pair<u16, u16>> findRanges(MemoryType type) const;
+
+        /**
+         * @brief Find the address ranges whose layout references depend on
+         * @param cpu CPU whose opcode table decodes the instructions
+         * @param pinnedRanges Address ranges whose layout a pointer depends on
+         * @return First and last addresses of the spans, clamped to the tune
+         *
+         * Shared by compaction, which keeps every byte of a span, and by
+         * findMovableBlocks(), which never splits one.
+         */
+        std::vector<std::pair<u32, u32>> findLayoutSpans(const CPU6510& cpu, std::span<const std::pair<u16, u16>> pinnedRanges) const;
     };
 
 } // namespace sidblaster
\ No newline at end of file
@@ -0,0 +1,421 @@
+// ==================================
+//             SIDBlaster
+//
+//  Raistlin / Genesis Project (G*P)
+// ==================================
+#include "PipelineStats.h"
+#include "SIDBlasterUtils.h"
+#include "cpu6510.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+namespace sidblaster {
+    namespace util {
+
+        // Initialize static members
+        bool PipelineStats::enabled_ = false;
+        thread_local int PipelineStats::depth_ = 0;
+        std::mutex PipelineStats::mutex_;
+        std::vector<PipelineStats::Stage> PipelineStats::stages_;
+
+        namespace {
+            std::chrono::steady_clock::time_point startTime_;  // Time of enable()
+
+            /**
+             * @brief Escape a string for inclusion in JSON
+             */
+            std::string jsonString(const std::string& text) {
+                std::string escaped = "\"";
+                for (char c : text) {
+                    if (c == '"' || c == '\\') {
+                        escaped += '\\';
+                    }
+                    escaped += static_cast<unsigned char>(c) < 0x20 ? ' ' : c;
+                }
+                return escaped + "\"";
+            }
+
+            /**
+             * @brief Format a byte count in megabytes
+             */
+            std::string megabytes(u64 bytes) {
+                std::ostringstream text;
+                text << std::fixed << std::setprecision(1) << static_cast<double>(bytes) / (1024.0 * 1024.0);
+                return text.str();
+            }
+        }
+
+        /**
+         * @brief Start collecting stage statistics
+         */
+        void PipelineStats::enable() {
+            enabled_ = true;
+            startTime_ = std::chrono::steady_clock::now();
+        }
+
+        /**
+         * @brief Add a completed stage
+         *
+         * @param stage Stage measurements
+         */
+        void PipelineStats::record(Stage stage) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stages_.push_back(std::move(stage));
+        }
+
+        /**
+         * @brief Get a small index for the calling thread
+         *
+         * @return Thread index (assigned in order of first use)
+         */
+        u32 PipelineStats::currentThread() {
+            static std::atomic<u32> nextThread{ 0 };
+            thread_local const u32 thread = nextThread++;
+            return thread;
+        }
+
+        /**
+         * @brief Seconds since enable() was called
+         *
+         * @return Elapsed seconds
+         */
+        double PipelineStats::elapsedSeconds() {
+            return std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime_).count();
+        }
+
+        /**
+         * @brief CPU time used so far by this process and its finished child processes
+         *
+         * On Windows child processes (KickAss, Exomizer) are not included.
+         *
+         * @return CPU seconds
+         */
+        double PipelineStats::cpuSeconds() {
+#ifdef _WIN32
+            FILETIME creation, exit, kernel, user;
+            if (!GetProcessTimes(GetCurrentProcess(), &creation, &exit, &kernel, &user)) {
+                return 0.0;
+            }
+            const auto toSeconds = [](const FILETIME& time) {
+                const u64 ticks = (static_cast<u64>(time.dwHighDateTime) << 32) | time.dwLowDateTime;
+                return static_cast<double>(ticks) / 1.0e7;
+            };
+            return toSeconds(kernel) + toSeconds(user);
+#else
+            double seconds = 0.0;
+            for (int who : { RUSAGE_SELF, RUSAGE_CHILDREN }) {
+                rusage usage{};
+                if (getrusage(who, &usage) == 0) {
+                    seconds += usage.ru_utime.tv_sec + usage.ru_utime.tv_usec / 1.0e6;
+                    seconds += usage.ru_stime.tv_sec + usage.ru_stime.tv_usec / 1.0e6;
+                }
+            }
+            return seconds;
+#endif
+        }
+
+        /**
+         * @brief Peak resident set size of this process
+         *
+         * @return Bytes, or 0 if unavailable
+         */
+        u64 PipelineStats::peakRssBytes() {
+#ifdef _WIN32
+            PROCESS_MEMORY_COUNTERS counters{};
+            if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+                return 0;
+            }
+            return counters.PeakWorkingSetSize;
+#else
+            rusage usage{};
+            if (getrusage(RUSAGE_SELF, &usage) != 0) {
+                return 0;
+            }
+#ifdef __APPLE__
+            return static_cast<u64>(usage.ru_maxrss);           // Already in bytes
+#else
+            return static_cast<u64>(usage.ru_maxrss) * 1024;    // Kilobytes
+#endif
+#endif
+        }
+
+        /**
+         * @brief Peak resident set size of the largest finished child process
+         *
+         * @return Bytes, or 0 if unavailable (always on Windows)
+         */
+        u64 PipelineStats::childPeakRssBytes() {
+#ifdef _WIN32
+            return 0;
+#else
+            rusage usage{};
+            if (getrusage(RUSAGE_CHILDREN, &usage) != 0) {
+                return 0;
+            }
+#ifdef __APPLE__
+            return static_cast<u64>(usage.ru_maxrss);
+#else
+            return static_cast<u64>(usage.ru_maxrss) * 1024;
+#endif
+#endif
+        }
+
+        /**
+         * @brief Print the stages as a table
+         *
+         * Nested stages are indented under the stage that contains them. Their
+         * time is included in the enclosing stage as well.
+         *
+         * @param out Output stream
+         */
+        void PipelineStats::printTable(std::ostream& out) {
+            const bool allocations = AllocationCounter::isEnabled();
+            out << "Stage                  |   Wall ms |    CPU ms | Peak RSS MB | Child RSS MB |    Written |  Frames | Instructions |       Cycles"
+                << (allocations ? " |     Allocs | Alloc bytes" : "") << "\n";
+            out << "-----------------------+-----------+-----------+-------------+--------------+------------+---------+--------------+-------------"
+                << (allocations ? "+------------+------------" : "") << "\n";
+
+            for (const auto& stage : stages_) {
+                const std::string name = std::string(stage.depth * 2, ' ') + stage.name;
+                out << std::left << std::setw(22) << name << std::right << " | "
+                    << std::fixed << std::setprecision(1)
+                    << std::setw(9) << stage.wallSeconds * 1000.0 << " | "
+                    << std::setw(9) << stage.cpuSeconds * 1000.0 << " | "
+                    << std::setw(11) << megabytes(stage.peakRssBytes) << " | "
+                    << std::setw(12) << (stage.childPeakRssBytes > 0 ? megabytes(stage.childPeakRssBytes) : "-") << " | "
+                    << std::setw(10) << stage.bytesWritten << " | "
+                    << std::setw(7) << stage.frames << " | "
+                    << std::setw(12) << stage.instructions << " | "
+                    << std::setw(12) << stage.cycles;
+                if (allocations) {
+                    out << " | " << std::setw(10) << stage.allocations << " | " << std::setw(11) << stage.allocatedBytes;
+                }
+                out << "\n";
+            }
+
+            out << "Total wall time: " << std::fixed << std::setprecision(1)
+                << elapsedSeconds() * 1000.0 << " ms, CPU time: " << cpuSeconds() * 1000.0 << " ms\n";
+            out.unsetf(std::ios::floatfield);
+        }
+
+        /**
+         * @brief Write the stages as JSON
+         *
+         * @param filename Output filename
+         * @return True if the file was written successfully
+         */
+        bool PipelineStats::writeJson(const std::string& filename) {
+            std::ofstream file(filename);
+            if (!file) {
+                Logger::error("Failed to create stats file: " + filename);
+                return false;
+            }
+
+            file << std::setprecision(9);
+            file << "{\n";
+            file << "  \"version\": " << jsonString(SIDBLASTER_VERSION) << ",\n";
+            file << "  \"wall_seconds\": " << elapsedSeconds() << ",\n";
+            file << "  \"cpu_seconds\": " << cpuSeconds() << ",\n";
+            file << "  \"peak_rss_bytes\": " << peakRssBytes() << ",\n";
+            file << "  \"child_peak_rss_bytes\": " << childPeakRssBytes() << ",\n";
+            file << "  \"stages\": [";
+
+            for (size_t i = 0; i < stages_.size(); ++i) {
+                const auto& stage = stages_[i];
+                file << (i > 0 ? "," : "") << "\n    { "
+                    << "\"name\": " << jsonString(stage.name)
+                    << ", \"category\": " << jsonString(stage.category)
+                    << ", \"thread\": " << stage.thread
+                    << ", \"depth\": " << stage.depth
+                    << ", \"start_seconds\": " << stage.startSeconds
+                    << ", \"wall_seconds\": " << stage.wallSeconds
+                    << ", \"cpu_seconds\": " << stage.cpuSeconds
+                    << ", \"peak_rss_bytes\": " << stage.peakRssBytes
+                    << ", \"child_peak_rss_bytes\": " << stage.childPeakRssBytes
+                    << ", \"bytes_written\": " << stage.bytesWritten
+                    << ", \"frames\": " << stage.frames
+                    << ", \"instructions\": " << stage.instructions
+                    << ", \"cycles\": " << stage.cycles;
+                if (AllocationCounter::isEnabled()) {
+                    file << ", \"allocations\": " << stage.allocations
+                        << ", \"allocated_bytes\": " << stage.allocatedBytes;
+                }
+                if (!stage.detail.empty()) {
+                    file << ", \"detail\": " << jsonString(stage.detail);
+                }
+                file << " }";
+            }
+            file << "\n  ]\n}\n";
+
+            if (!file) {
+                Logger::error("Failed to write stats file: " + filename);
+                return false;
+            }
+
+            Logger::info("Wrote stage statistics: " + filename);
+            return true;
+        }
+
+        /**
+         * @brief Write the stages as Chrome trace events
+         *
+         * Each stage becomes a complete ("X") event on the track of the thread
+         * that recorded it, with its counters as event arguments. The file
+         * loads in chrome://tracing and ui.perfetto.dev.
+         *
+         * @param filename Output filename
+         * @return True if the file was written successfully
+         */
+        bool PipelineStats::writeTimeline(const std::string& filename) {
+            std::ofstream file(filename);
+            if (!file) {
+                Logger::error("Failed to create timeline file: " + filename);
+                return false;
+            }
+
+            std::vector<u32> threads;
+            for (const auto& stage : stages_) {
+                if (std::find(threads.begin(), threads.end(), stage.thread) == threads.end()) {
+                    threads.push_back(stage.thread);
+                }
+            }
+            std::sort(threads.begin(), threads.end());
+
+            file << std::fixed << std::setprecision(3);
+            file << "{\n  \"displayTimeUnit\": \"ms\",\n  \"traceEvents\": [\n";
+            file << "    { \"ph\": \"M\", \"name\": \"process_name\", \"pid\": 1, \"args\": { \"name\": "
+                << jsonString(SIDBLASTER_VERSION) << " } }";
+            for (u32 thread : threads) {
+                file << ",\n    { \"ph\": \"M\", \"name\": \"thread_name\", \"pid\": 1, \"tid\": " << thread
+                    << ", \"args\": { \"name\": \"" << (thread == 0 ? "main" : "worker " + std::to_string(thread)) << "\" } }";
+            }
+
+            for (const auto& stage : stages_) {
+                file << ",\n    { \"ph\": \"X\", \"name\": " << jsonString(stage.name)
+                    << ", \"cat\": " << jsonString(stage.category)
+                    << ", \"pid\": 1, \"tid\": " << stage.thread
+                    << ", \"ts\": " << stage.startSeconds * 1.0e6
+                    << ", \"dur\": " << stage.wallSeconds * 1.0e6
+                    << ", \"args\": { \"cpu_ms\": " << stage.cpuSeconds * 1000.0
+                    << ", \"peak_rss_bytes\": " << stage.peakRssBytes;
+                if (stage.bytesWritten > 0) {
+                    file << ", \"bytes_written\": " << stage.bytesWritten;
+                }
+                if (stage.frames > 0) {
+                    file << ", \"frames\": " << stage.frames;
+                }
+                if (stage.instructions > 0) {
+                    file << ", \"instructions\": " << stage.instructions << ", \"cycles\": " << stage.cycles;
+                }
+                if (AllocationCounter::isEnabled()) {
+                    file << ", \"allocations\": " << stage.allocations
+                        << ", \"allocated_bytes\": " << stage.allocatedBytes;
+                }
+                if (!stage.detail.empty()) {
+                    file << ", \"detail\": " << jsonString(stage.detail);
+                }
+                file << " } }";
+            }
+            file << "\n  ]\n}\n";
+
+            if (!file) {
+                Logger::error("Failed to write timeline file: " + filename);
+                return false;
+            }
+
+            Logger::info("Wrote timeline: " + filename);
+            return true;
+        }
+
+        /**
+         * @brief Start a stage
+         *
+         * @param name Stage name
+         * @param cpu CPU whose instructions and cycles are attributed to the stage (optional)
+         */
+        StageTimer::StageTimer(std::string name, const CPU6510* cpu)
+            : active_(PipelineStats::isEnabled()), cpu_(cpu) {
+            if (!active_) {
+                return;
+            }
+
+            stage_.name = std::move(name);
+            stage_.thread = PipelineStats::currentThread();
+            stage_.depth = PipelineStats::depth_++;
+            stage_.startSeconds = PipelineStats::elapsedSeconds();
+            startCpuSeconds_ = PipelineStats::cpuSeconds();
+            if (cpu_) {
+                startInstructions_ = cpu_->getInstructionCount();
+                startCycles_ = cpu_->getCycles();
+            }
+
+            // Last, so the bookkeeping above is not attributed to the stage
+            startAllocations_ = AllocationCounter::current();
+        }
+
+        /**
+         * @brief Finish the stage and record it
+         */
+        StageTimer::~StageTimer() {
+            if (!active_) {
+                return;
+            }
+
+            // First, before the bookkeeping below allocates anything
+            const AllocationCounter::Counts allocations = AllocationCounter::current();
+            stage_.allocations = allocations.allocations - startAllocations_.allocations;
+            stage_.allocatedBytes = allocations.bytes - startAllocations_.bytes;
+
+            PipelineStats::depth_--;
+            stage_.wallSeconds = PipelineStats::elapsedSeconds() - stage_.startSeconds;
+            stage_.cpuSeconds = PipelineStats::cpuSeconds() - startCpuSeconds_;
+            stage_.peakRssBytes = PipelineStats::peakRssBytes();
+            stage_.childPeakRssBytes = PipelineStats::childPeakRssBytes();
+
+            if (cpu_) {
+                // A CPU reset during the stage restarts the cycle count
+                const u64 cycles = cpu_->getCycles();
+                stage_.instructions = cpu_->getInstructionCount() - startInstructions_;
+                stage_.cycles = cycles >= startCycles_ ? cycles - startCycles_ : cycles;
+            }
+
+            for (const auto& path : outputs_) {
+                std::error_code ec;
+                const auto size = std::filesystem::file_size(path, ec);
+                if (!ec) {
+                    stage_.bytesWritten += size;
+                }
+            }
+
+            PipelineStats::record(std::move(stage_));
+        }
+
+        /**
+         * @brief Count a file produced by the stage towards its bytes written
+         *
+         * @param path File path (sized when the stage finishes)
+         */
+        void StageTimer::addOutputFile(const std::filesystem::path& path) {
+            if (active_) {
+                outputs_.push_back(path);
+            }
+        }
+
+    } // namespace util
+} // namespace sidblaster
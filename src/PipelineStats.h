@@ -0,0 +1,199 @@
+// ==================================
+//             SIDBlaster
+//
+//  Raistlin / Genesis Project (G*P)
+// ==================================
+#pragma once
+
+#include "AllocationCounter.h"
+#include "Common.h"
+
+#include <filesystem>
+#include <iosfwd>
+#include <mutex>
+#include <string>
+#include <vector>
+
+class CPU6510;
+
+namespace sidblaster {
+    namespace util {
+
+        /**
+         * @class PipelineStats
+         * @brief Collects timing and resource usage of each processing stage
+         *
+         * Stages (load, emulate, disassemble, assemble, compress, ...) are
+         * recorded by StageTimer objects placed around the work itself, so
+         * every command path is covered without threading a collector through
+         * the call chain. Collection is off until enable() is called.
+         *
+         * Stages may be recorded from several threads; each thread's stages nest
+         * independently and are tagged with a per-thread index.
+         */
+        class PipelineStats {
+        public:
+            /**
+             * @brief Measurements for one completed stage
+             */
+            struct Stage {
+                std::string name;               // Stage name
+                std::string category = "stage"; // "stage", "emulation" or "tool"
+                std::string detail;             // Extra information (e.g. a tool's command line)
+                u32 thread = 0;                 // Index of the recording thread (0 = first thread seen)
+                int depth = 0;                  // Nesting depth within the thread (0 = top level)
+                double startSeconds = 0.0;      // Start time relative to enable()
+                double wallSeconds = 0.0;       // Elapsed wall-clock time
+                double cpuSeconds = 0.0;        // CPU time of this process and its child processes
+                u64 peakRssBytes = 0;           // Process peak resident set size at the end of the stage
+                u64 childPeakRssBytes = 0;      // Largest child process resident set size so far (0 if unknown)
+                u64 bytesWritten = 0;           // Size of the files the stage produced
+                u64 frames = 0;                 // Emulated frames
+                u64 instructions = 0;           // Emulated instructions
+                u64 cycles = 0;                 // Emulated cycles
+                u64 allocations = 0;            // Heap allocations on the recording thread (instrumented builds)
+                u64 allocatedBytes = 0;         // Bytes those allocations requested
+            };
+
+            /**
+             * @brief Start collecting stage statistics
+             */
+            static void enable();
+
+            /**
+             * @brief Check whether statistics are being collected
+             * @return True if enable() has been called
+             */
+            static bool isEnabled() { return enabled_; }
+
+            /**
+             * @brief Add a completed stage
+             * @param stage Stage measurements
+             */
+            static void record(Stage stage);
+
+            /**
+             * @brief Get all recorded stages in completion order
+             * @return Recorded stages
+             */
+            static const std::vector<Stage>& getStages() { return stages_; }
+
+            /**
+             * @brief Get a small index for the calling thread
+             * @return Thread index (assigned in order of first use)
+             */
+            static u32 currentThread();
+
+            /**
+             * @brief Print the stages as a table
+             * @param out Output stream
+             */
+            static void printTable(std::ostream& out);
+
+            /**
+             * @brief Write the stages as JSON
+             * @param filename Output filename
+             * @return True if the file was written successfully
+             */
+            static bool writeJson(const std::string& filename);
+
+            /**
+             * @brief Write the stages as Chrome trace events (chrome://tracing, Perfetto)
+             * @param filename Output filename
+             * @return True if the file was written successfully
+             */
+            static bool writeTimeline(const std::string& filename);
+
+            /**
+             * @brief Seconds since enable() was called
+             * @return Elapsed seconds
+             */
+            static double elapsedSeconds();
+
+            /**
+             * @brief CPU time used so far by this process and its finished child processes
+             * @return CPU seconds
+             */
+            static double cpuSeconds();
+
+            /**
+             * @brief Peak resident set size of this process
+             * @return Bytes, or 0 if unavailable
+             */
+            static u64 peakRssBytes();
+
+            /**
+             * @brief Peak resident set size of the largest finished child process
+             * @return Bytes, or 0 if unavailable
+             */
+            static u64 childPeakRssBytes();
+
+        private:
+            friend class StageTimer;
+
+            static bool enabled_;                    // Whether collection is on
+            static thread_local int depth_;          // Number of stages currently open on this thread
+            static std::mutex mutex_;                // Guards stages_
+            static std::vector<Stage> stages_;       // Completed stages
+        };
+
+        /**
+         * @class StageTimer
+         * @brief Records one pipeline stage for as long as it is in scope
+         *
+         * Does nothing unless PipelineStats is enabled.
+         */
+        class StageTimer {
+        public:
+            /**
+             * @brief Start a stage
+             * @param name Stage name
+             * @param cpu CPU whose instructions and cycles are attributed to the stage (optional)
+             */
+            explicit StageTimer(std::string name, const CPU6510* cpu = nullptr);
+
+            /**
+             * @brief Finish the stage and record it
+             */
+            ~StageTimer();
+
+            StageTimer(const StageTimer&) = delete;
+            StageTimer& operator=(const StageTimer&) = delete;
+
+            /**
+             * @brief Count a file produced by the stage towards its bytes written
+             * @param path File path (sized when the stage finishes)
+             */
+            void addOutputFile(const std::filesystem::path& path);
+
+            /**
+             * @brief Set the number of frames the stage emulated
+             * @param frames Frame count
+             */
+            void setFrames(u64 frames) { stage_.frames = frames; }
+
+            /**
+             * @brief Set the stage category shown in the timeline
+             * @param category Category name ("stage", "emulation" or "tool")
+             */
+            void setCategory(const char* category) { stage_.category = category; }
+
+            /**
+             * @brief Attach extra information to the stage
+             * @param detail Text such as a tool's command line
+             */
+            void setDetail(std::string detail) { stage_.detail = std::move(detail); }
+
+        private:
+            bool active_;                                   // Whether the stage is being recorded
+            const CPU6510* cpu_;                            // CPU to sample (may be null)
+            PipelineStats::Stage stage_;                    // Measurements so far
+            double startCpuSeconds_ = 0.0;                  // CPU time at the start
+            u64 startInstructions_ = 0;                     // CPU instruction count at the start
+            u64 startCycles_ = 0;                           // CPU cycle count at the start
+            AllocationCounter::Counts startAllocations_;    // Allocation counts at the start
+            std::vector<std::filesystem::path> outputs_;    // Files produced by the stage
+        };
+
+    } // namespace util
+} // namespace sidblaster
@@ -0,0 +1,299 @@
+// ==================================
+//             SIDBlaster
+//
+//  Raistlin / Genesis Project (G*P)
+// ==================================
+#include "RasterProfiler.h"
+#include "SIDBlasterUtils.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+namespace sidblaster {
+
+    namespace {
+        /**
+         * @brief Nearest-rank percentile of a set of samples
+         * @param samples Samples (taken by value, reordered)
+         * @param percent Percentile (0-100)
+         * @return Percentile value, or 0 if there are no samples
+         */
+        template <typename T>
+        T percentile(std::vector<T> samples, int percent) {
+            if (samples.empty()) {
+                return 0;
+            }
+            const size_t rank = (samples.size() * percent + 99) / 100;
+            const size_t index = rank > 0 ? rank - 1 : 0;
+            std::nth_element(samples.begin(), samples.begin() + index, samples.end());
+            return samples[index];
+        }
+    }
+
+    /**
+     * @brief Constructor
+     */
+    RasterProfiler::RasterProfiler()
+        : routineIndex_(65536, None) {
+        stack_.reserve(64);
+    }
+
+    /**
+     * @brief Start a top-level call
+     *
+     * @param entry Address being called
+     * @param sp Stack pointer before the call
+     * @param cycles CPU cycle count at the call
+     */
+    void RasterProfiler::beginCall(u16 entry, u8 sp, u64 cycles) {
+        enter(entry, sp, cycles);
+    }
+
+    /**
+     * @brief Finish a top-level call
+     *
+     * Anything still on the stack (the play routine returned via a stack trick,
+     * or execution was aborted) is closed at the given cycle count.
+     *
+     * @param cycles CPU cycle count after the call
+     */
+    void RasterProfiler::endCall(u64 cycles) {
+        while (!stack_.empty()) {
+            leave(cycles);
+        }
+    }
+
+    /**
+     * @brief Record a JSR
+     *
+     * @param target Subroutine entry point
+     * @param sp Stack pointer after the return address was pushed
+     * @param cycles CPU cycle count after the JSR
+     */
+    void RasterProfiler::onCall(u16 target, u8 sp, u64 cycles) {
+        enter(target, static_cast<u8>(sp + 2), cycles);
+    }
+
+    /**
+     * @brief Record an RTS
+     *
+     * Matches by stack pointer rather than by count, so pushed-address jumps
+     * (PHA/PHA/RTS) don't close a routine, and a routine that drops its own
+     * return address closes every level it unwound.
+     *
+     * @param sp Stack pointer after the return address was popped
+     * @param cycles CPU cycle count after the RTS
+     */
+    void RasterProfiler::onReturn(u8 sp, u64 cycles) {
+        while (!stack_.empty() && stack_.back().returnSP <= sp) {
+            leave(cycles);
+        }
+    }
+
+    /**
+     * @brief Close the current frame
+     */
+    void RasterProfiler::endFrame() {
+        frameCycles_.push_back(currentFrameCycles_);
+        currentFrameCycles_ = 0;
+
+        for (u32 index : touched_) {
+            Routine& routine = routines_[index];
+            routine.frameSamples.push_back(routine.frameInclusive);
+            routine.frameInclusive = 0;
+            routine.touchedThisFrame = false;
+        }
+        touched_.clear();
+    }
+
+    /**
+     * @brief Look up or create the record for an entry point
+     *
+     * @param entry Entry address
+     * @return Index into routines_
+     */
+    u32 RasterProfiler::routineFor(u16 entry) {
+        u32& index = routineIndex_[entry];
+        if (index == None) {
+            index = static_cast<u32>(routines_.size());
+            routines_.emplace_back();
+            routines_.back().entry = entry;
+        }
+        return index;
+    }
+
+    /**
+     * @brief Look up or create the call-path node for a routine under a parent
+     *
+     * @param parent Parent node (None for a root)
+     * @param routine Routine index
+     * @return Index into paths_
+     */
+    u32 RasterProfiler::pathFor(u32 parent, u32 routine) {
+        const u64 key = (static_cast<u64>(parent) << 32) | routine;
+        const auto [it, inserted] = pathIndex_.try_emplace(key, static_cast<u32>(paths_.size()));
+        if (inserted) {
+            paths_.push_back({ parent, routine, 0 });
+        }
+        return it->second;
+    }
+
+    /**
+     * @brief Push a routine onto the call stack
+     *
+     * @param entry Entry address
+     * @param returnSP Stack pointer once the routine has returned
+     * @param cycles CPU cycle count on entry
+     */
+    void RasterProfiler::enter(u16 entry, u8 returnSP, u64 cycles) {
+        const u32 index = routineFor(entry);
+        Routine& routine = routines_[index];
+        routine.calls++;
+        routine.activeDepth++;
+
+        const u32 parentPath = stack_.empty() ? None : stack_.back().path;
+        stack_.push_back({ index, pathFor(parentPath, index), returnSP, cycles, 0 });
+    }
+
+    /**
+     * @brief Pop the innermost routine off the call stack
+     *
+     * @param cycles CPU cycle count at the return
+     */
+    void RasterProfiler::leave(u64 cycles) {
+        const StackEntry top = stack_.back();
+        stack_.pop_back();
+
+        const u64 inclusive = cycles - top.startCycles;
+        const u64 exclusive = inclusive - std::min(inclusive, top.childCycles);
+
+        Routine& routine = routines_[top.routine];
+        routine.exclusiveCycles += exclusive;
+        paths_[top.path].exclusiveCycles += exclusive;
+
+        // Recursive activations are already covered by the outermost one
+        if (--routine.activeDepth == 0) {
+            routine.inclusiveCycles += inclusive;
+            routine.frameInclusive += static_cast<u32>(inclusive);
+            if (!routine.touchedThisFrame) {
+                routine.touchedThisFrame = true;
+                touched_.push_back(top.routine);
+            }
+        }
+
+        if (!stack_.empty()) {
+            stack_.back().childCycles += inclusive;
+        }
+        else {
+            currentFrameCycles_ += inclusive;
+        }
+    }
+
+    /**
+     * @brief Write the per-subroutine report
+     *
+     * Routines are listed by total inclusive cycles. The per-frame columns
+     * only consider frames in which the routine ran.
+     *
+     * @param filename Output filename
+     * @return True if the file was written successfully
+     */
+    bool RasterProfiler::writeReport(const std::string& filename) const {
+        std::ofstream file(filename);
+        if (!file) {
+            util::Logger::error("Failed to create profile report: " + filename);
+            return false;
+        }
+
+        u64 totalCycles = 0;
+        for (u64 frame : frameCycles_) {
+            totalCycles += frame;
+        }
+
+        file << "SIDBlaster rastertime profile\n";
+        file << "-----------------------------\n";
+        file << "Frames profiled: " << frameCycles_.size() << "\n";
+        file << "Total cycles:    " << totalCycles << "\n";
+        file << "Cycles/frame:    p50 " << percentile(frameCycles_, 50)
+            << ", p95 " << percentile(frameCycles_, 95)
+            << ", max " << percentile(frameCycles_, 100) << "\n\n";
+
+        std::vector<const Routine*> sorted;
+        sorted.reserve(routines_.size());
+        for (const auto& routine : routines_) {
+            sorted.push_back(&routine);
+        }
+        std::sort(sorted.begin(), sorted.end(), [](const Routine* a, const Routine* b) {
+            return a->inclusiveCycles != b->inclusiveCycles ?
+                a->inclusiveCycles > b->inclusiveCycles : a->entry < b->entry;
+            });
+
+        file << "Routine |      Calls | Frames |    Inclusive |    Exclusive | Incl% | Frame p50 | Frame p95 | Frame max\n";
+        file << "--------+------------+--------+--------------+--------------+-------+-----------+-----------+----------\n";
+
+        for (const Routine* routine : sorted) {
+            const double share = totalCycles > 0 ?
+                100.0 * static_cast<double>(routine->inclusiveCycles) / static_cast<double>(totalCycles) : 0.0;
+
+            file << "$" << util::wordToHex(routine->entry) << "   | "
+                << std::setw(10) << routine->calls << " | "
+                << std::setw(6) << routine->frameSamples.size() << " | "
+                << std::setw(12) << routine->inclusiveCycles << " | "
+                << std::setw(12) << routine->exclusiveCycles << " | "
+                << std::setw(5) << std::fixed << std::setprecision(1) << share << " | "
+                << std::setw(9) << percentile(routine->frameSamples, 50) << " | "
+                << std::setw(9) << percentile(routine->frameSamples, 95) << " | "
+                << std::setw(9) << percentile(routine->frameSamples, 100) << "\n";
+        }
+
+        util::Logger::info("Wrote rastertime profile: " + filename +
+            " (" + std::to_string(routines_.size()) + " routines)");
+        return true;
+    }
+
+    /**
+     * @brief Write exclusive cycles per call stack in folded-stacks format
+     *
+     * One line per distinct call path, e.g. "$1003;$1120;$11F0 123456",
+     * suitable for flamegraph.pl and compatible viewers.
+     *
+     * @param filename Output filename
+     * @return True if the file was written successfully
+     */
+    bool RasterProfiler::writeFoldedStacks(const std::string& filename) const {
+        std::ofstream file(filename);
+        if (!file) {
+            util::Logger::error("Failed to create folded stacks file: " + filename);
+            return false;
+        }
+
+        std::vector<u32> chain;
+        for (const auto& node : paths_) {
+            if (node.exclusiveCycles == 0) {
+                continue;
+            }
+
+            chain.clear();
+            for (const PathNode* level = &node; ; level = &paths_[level->parent]) {
+                chain.push_back(level->routine);
+                if (level->parent == None) {
+                    break;
+                }
+            }
+
+            for (auto it = chain.rbegin(); it != chain.rend(); ++it) {
+                if (it != chain.rbegin()) {
+                    file << ';';
+                }
+                file << '$' << util::wordToHex(routines_[*it].entry);
+            }
+            file << ' ' << node.exclusiveCycles << '\n';
+        }
+
+        util::Logger::info("Wrote folded stacks: " + filename);
+        return true;
+    }
+
+} // namespace sidblaster
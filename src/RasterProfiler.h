@@ -0,0 +1,156 @@
+// ==================================
+//             SIDBlaster
+//
+//  Raistlin / Genesis Project (G*P)
+// ==================================
+#pragma once
+
+#include "Common.h"
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace sidblaster {
+
+    /**
+     * @class RasterProfiler
+     * @brief Attributes play-routine cycles to the subroutines that spend them
+     *
+     * Follows the JSR/RTS call stack reported by the CPU and accumulates
+     * inclusive and exclusive cycles per subroutine entry point, both per
+     * frame and across the whole run. Results can be written as a text report
+     * and as a folded-stacks file for flamegraph tools.
+     */
+    class RasterProfiler {
+    public:
+        /**
+         * @brief Constructor
+         */
+        RasterProfiler();
+
+        /**
+         * @brief Start a top-level call (e.g. the play routine)
+         * @param entry Address being called
+         * @param sp Stack pointer before the call
+         * @param cycles CPU cycle count at the call
+         */
+        void beginCall(u16 entry, u8 sp, u64 cycles);
+
+        /**
+         * @brief Finish a top-level call, closing any subroutines left open
+         * @param cycles CPU cycle count after the call
+         */
+        void endCall(u64 cycles);
+
+        /**
+         * @brief Record a JSR
+         * @param target Subroutine entry point
+         * @param sp Stack pointer after the return address was pushed
+         * @param cycles CPU cycle count after the JSR
+         */
+        void onCall(u16 target, u8 sp, u64 cycles);
+
+        /**
+         * @brief Record an RTS
+         * @param sp Stack pointer after the return address was popped
+         * @param cycles CPU cycle count after the RTS
+         */
+        void onReturn(u8 sp, u64 cycles);
+
+        /**
+         * @brief Close the current frame and fold its totals into the per-frame statistics
+         */
+        void endFrame();
+
+        /**
+         * @brief Write the per-subroutine report
+         * @param filename Output filename
+         * @return True if the file was written successfully
+         */
+        bool writeReport(const std::string& filename) const;
+
+        /**
+         * @brief Write exclusive cycles per call stack in folded-stacks format
+         * @param filename Output filename
+         * @return True if the file was written successfully
+         */
+        bool writeFoldedStacks(const std::string& filename) const;
+
+    private:
+        static constexpr u32 None = 0xFFFFFFFF;
+
+        /**
+         * @brief Totals for one subroutine entry point
+         */
+        struct Routine {
+            u16 entry = 0;                   // Entry address
+            u64 calls = 0;                   // Number of times called
+            u64 inclusiveCycles = 0;         // Cycles including callees (outermost activations only)
+            u64 exclusiveCycles = 0;         // Cycles spent in the routine itself
+            int activeDepth = 0;             // Activations currently on the call stack
+            u32 frameInclusive = 0;          // Inclusive cycles in the current frame
+            bool touchedThisFrame = false;   // Whether frameInclusive is in use
+            std::vector<u32> frameSamples;   // Inclusive cycles for each frame it ran in
+        };
+
+        /**
+         * @brief One node of the call-path tree used for folded stacks
+         */
+        struct PathNode {
+            u32 parent = None;               // Parent node (None for a root)
+            u32 routine = 0;                 // Routine at this level
+            u64 exclusiveCycles = 0;         // Exclusive cycles spent on this exact path
+        };
+
+        /**
+         * @brief An active subroutine on the call stack
+         */
+        struct StackEntry {
+            u32 routine;                     // Routine being executed
+            u32 path;                        // Call-path node
+            u8 returnSP;                     // Stack pointer once the routine has returned
+            u64 startCycles;                 // Cycle count on entry
+            u64 childCycles;                 // Inclusive cycles of completed callees
+        };
+
+        /**
+         * @brief Look up or create the record for an entry point
+         * @param entry Entry address
+         * @return Index into routines_
+         */
+        u32 routineFor(u16 entry);
+
+        /**
+         * @brief Look up or create the call-path node for a routine under a parent
+         * @param parent Parent node (None for a root)
+         * @param routine Routine index
+         * @return Index into paths_
+         */
+        u32 pathFor(u32 parent, u32 routine);
+
+        /**
+         * @brief Push a routine onto the call stack
+         * @param entry Entry address
+         * @param returnSP Stack pointer once the routine has returned
+         * @param cycles CPU cycle count on entry
+         */
+        void enter(u16 entry, u8 returnSP, u64 cycles);
+
+        /**
+         * @brief Pop the innermost routine off the call stack
+         * @param cycles CPU cycle count at the return
+         */
+        void leave(u64 cycles);
+
+        std::vector<u32> routineIndex_;                 // Entry address -> index into routines_
+        std::vector<Routine> routines_;                 // Per-routine totals
+        std::vector<u32> touched_;                      // Routines with cycles in the current frame
+        std::vector<PathNode> paths_;                   // Call-path tree
+        std::unordered_map<u64, u32> pathIndex_;        // (parent, routine) -> index into paths_
+        std::vector<StackEntry> stack_;                 // Active call stack
+        std::vector<u64> frameCycles_;                  // Total cycles of every frame
+        u64 currentFrameCycles_ = 0;                    // Top-level cycles in the current frame
+    };
+
+} // namespace sidblaster
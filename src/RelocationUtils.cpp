@@ -1,17 +1,348 @@
 #include "RelocationUtils.h"
 #include "SIDBlasterUtils.h"
 #include "ConfigManager.h"
+#include "PipelineStats.h"
 #include "cpu6510.h"
 #include "SIDEmulator.h"
 #include "SIDLoader.h"
 #include "Disassembler.h"
 
+#include <algorithm>
 #include <fstream>
+#include <memory>
+#include <thread>
 
 
 namespace sidblaster {
     namespace util {
 
+        namespace {
+
+            /**
+             * @brief Load and emulate a tune for relocation
+             * @param cpu CPU instance for disassembly
+             * @param sid SID loader for file handling
+             * @param params Relocation parameters (the input file and temp directory)
+             * @param result Receives the original addresses, or the error message
+             * @return Disassembler holding the analysis, or null on failure
+             *
+             * The disassembler has to exist before the emulation runs, since it
+             * records the indirect accesses as they happen.
+             */
+            std::unique_ptr<Disassembler> analyzeForRelocation(
+                CPU6510* cpu,
+                SIDLoader* sid,
+                const RelocationParams& params,
+                RelocationResult& result) {
+
+                // Validate that the input is a SID file
+                const std::string inExt = getFileExtension(params.inputFile);
+                if (inExt != ".sid") {
+                    result.message = "Input file must be a SID file (.sid): " + params.inputFile.string();
+                    Logger::error(result.message);
+                    return nullptr;
+                }
+
+                // Create temp directory if it doesn't exist
+                try {
+                    fs::create_directories(params.tempDir);
+                }
+                catch (const std::exception& e) {
+                    result.message = std::string("Failed to create temp directory: ") + e.what();
+                    Logger::error(result.message);
+                    return nullptr;
+                }
+
+                // Load the input file
+                if (!sid->loadSID(params.inputFile.string())) {
+                    result.message = "Failed to load file for relocation: " + params.inputFile.string();
+                    Logger::error(result.message);
+                    return nullptr;
+                }
+
+                // Get original addresses
+                result.originalLoad = sid->getLoadAddress();
+                result.originalInit = sid->getInitAddress();
+                result.originalPlay = sid->getPlayAddress();
+
+                const SIDHeader& originalHeader = sid->getHeader();
+                Logger::info("Original addresses - Load: $" + wordToHex(result.originalLoad) +
+                    ", Init: $" + wordToHex(result.originalInit) +
+                    ", Play: $" + wordToHex(result.originalPlay) +
+                    ", Flags: $" + wordToHex(originalHeader.flags) +
+                    ", Version: " + std::to_string(originalHeader.version));
+
+                // Create a Disassembler
+                auto disassembler = std::make_unique<sidblaster::Disassembler>(*cpu, *sid);
+                disassembler->setCompaction(params.compact);
+                disassembler->setScatterWindows(params.windows);
+
+                // Run emulation to analyze memory access patterns
+                const int numFrames = sidblaster::util::ConfigManager::getInt("emulationFrames", DEFAULT_SID_EMULATION_FRAMES);
+                if (!runSIDEmulation(cpu, sid, numFrames)) {
+                    result.message = "Failed to run SID emulation for memory analysis";
+                    Logger::error(result.message);
+                    return nullptr;
+                }
+
+                return disassembler;
+            }
+
+            /**
+             * @brief Write the relocated assembly for one target address
+             * @param disassembler Disassembler holding the analysis
+             * @param asmFile Assembly file to write
+             * @param address Target load address (not used if the tune is scattered)
+             * @param dataSize Size of the original music data
+             * @param result Original addresses in; new addresses, memory map and unused byte counts out
+             * @return False if a scattered tune did not fit into its windows
+             */
+            bool writeRelocatedAsm(
+                Disassembler& disassembler,
+                const fs::path& asmFile,
+                u16 address,
+                u16 dataSize,
+                RelocationResult& result) {
+
+                // Removed runs move everything above them down, within each segment
+                disassembler.analyze();
+                const auto removed = disassembler.getRemovedRanges();
+                const u32 dataEnd = static_cast<u32>(result.originalLoad) + dataSize;
+                std::vector<MemorySegment> segments = disassembler.getSegments();
+                if (segments.empty()) {
+                    if (disassembler.hasScatterWindows()) {
+                        result.message = "The tune does not fit into the free memory windows";
+                        Logger::error(result.message);
+                        return false;
+                    }
+                    segments.push_back({ result.originalLoad, static_cast<u16>(dataEnd - 1), address });
+                }
+
+                // The removed bytes of a segment, as runs clipped to it
+                const auto removedIn = [&](const MemorySegment& segment) {
+                    std::vector<std::pair<u16, u16>> runs;
+                    for (const auto& [start, end] : removed) {
+                        if (end >= segment.originalStart && start <= segment.originalEnd) {
+                            runs.emplace_back(std::max(start, segment.originalStart), std::min(end, segment.originalEnd));
+                        }
+                    }
+                    return runs;
+                };
+
+                const auto newAddress = [&](u16 addr) {
+                    const MemorySegment* segment = &segments.front();
+                    for (const auto& candidate : segments) {
+                        if (candidate.originalStart <= addr) {
+                            segment = &candidate;
+                        }
+                    }
+                    u16 removedBelow = 0;
+                    for (const auto& [start, end] : removedIn(*segment)) {
+                        if (end < addr) {
+                            removedBelow += end - start + 1;
+                        }
+                    }
+                    return static_cast<u16>(segment->newStart + (addr - segment->originalStart) - removedBelow);
+                };
+
+                // Calculate relocated addresses
+                result.newLoad = segments.front().newStart;
+                for (const auto& segment : segments) {
+                    result.newLoad = std::min(result.newLoad, segment.newStart);
+                }
+                result.newInit = newAddress(result.originalInit);
+                result.newPlay = newAddress(result.originalPlay);
+
+                // The blocks between the removed runs and segment starts, where they were and where they go
+                result.bytesSaved = 0;
+                for (const auto& [start, end] : removed) {
+                    result.bytesSaved += end - start + 1;
+                }
+                result.memoryMap.clear();
+                for (const auto& segment : segments) {
+                    u32 blockStart = segment.originalStart;
+                    for (const auto& [start, end] : removedIn(segment)) {
+                        if (start > blockStart) {
+                            result.memoryMap.push_back({ static_cast<u16>(blockStart), static_cast<u16>(start - 1), newAddress(static_cast<u16>(blockStart)) });
+                        }
+                        blockStart = end + 1u;
+                    }
+                    if (blockStart <= segment.originalEnd) {
+                        result.memoryMap.push_back({ static_cast<u16>(blockStart), segment.originalEnd, newAddress(static_cast<u16>(blockStart)) });
+                    }
+                }
+
+                Logger::info("Relocated addresses - Load: $" + wordToHex(result.newLoad) +
+                    ", Init: $" + wordToHex(result.newInit) +
+                    ", Play: $" + wordToHex(result.newPlay));
+
+                // Generate ASM with relocated addresses
+                result.unusedBytesRemoved = disassembler.generateAsmFile(
+                    asmFile.string(),
+                    result.newLoad,
+                    result.newInit,
+                    result.newPlay);
+                return true;
+            }
+
+            /**
+             * @brief Assemble relocated assembly into the output SID file
+             * @param header Header of the original tune
+             * @param asmFile Relocated assembly
+             * @param prgFile Temporary PRG file
+             * @param outputFile SID file to write
+             * @param kickAssPath Path to KickAss.jar
+             * @param result New addresses in; success and message out
+             *
+             * Touches no shared state, so several targets can be built at once.
+             */
+            void buildRelocatedSID(
+                const SIDHeader& header,
+                const fs::path& asmFile,
+                const fs::path& prgFile,
+                const fs::path& outputFile,
+                const std::string& kickAssPath,
+                RelocationResult& result) {
+
+                // Assemble to PRG
+                if (!assembleAsmToPrg(asmFile, prgFile, kickAssPath)) {
+                    result.message = "Failed to assemble relocated code: " + asmFile.string();
+                    Logger::error(result.message);
+                    return;
+                }
+
+                // Create SID file from PRG, keeping the original flags, extra SID addresses and version
+                if (!createSIDFromPRG(
+                    prgFile,
+                    outputFile,
+                    result.newLoad,
+                    result.newInit,
+                    result.newPlay,
+                    header.name,
+                    header.author,
+                    header.copyright,
+                    header.flags,
+                    header.secondSIDAddress,
+                    header.thirdSIDAddress,
+                    header.version)) {
+
+                    // If SID creation fails, fall back to PRG
+                    Logger::warning("SID file generation failed. Saving as PRG instead.");
+
+                    try {
+                        fs::copy_file(prgFile, outputFile, fs::copy_options::overwrite_existing);
+
+                        result.success = true;
+                        result.message = "Relocation complete (saved as PRG). " +
+                            std::to_string(result.unusedBytesRemoved) + " unused bytes removed.";
+                        Logger::info(result.message);
+                    }
+                    catch (const std::exception& e) {
+                        result.message = std::string("Failed to copy output file: ") + e.what();
+                        Logger::error(result.message);
+                    }
+                }
+                else {
+                    result.success = true;
+                    result.message = "Relocation to SID complete. " +
+                        std::to_string(result.unusedBytesRemoved) + " unused bytes removed.";
+                    Logger::info(result.message);
+                }
+            }
+
+            /**
+             * @brief Play the original and relocated tunes side by side and compare their SID writes
+             * @param cpu CPU to run the original tune on
+             * @param sid SID loader for the original tune
+             * @param inputFile Original SID file
+             * @param outputFile Relocated SID file
+             * @param result Trace paths in; verified, outputsMatch and message out
+             */
+            void verifyRelocation(
+                CPU6510* cpu,
+                SIDLoader* sid,
+                const fs::path& inputFile,
+                const fs::path& outputFile,
+                RelocationVerificationResult& result) {
+
+                // Load the original and relocated tunes into separate CPUs
+                if (!sid->loadSID(inputFile.string())) {
+                    result.message = "Failed to load original SID file";
+                    return;
+                }
+                cpu->reset();
+
+                CPU6510 relocatedCpu;
+                SIDLoader relocatedSid;
+                relocatedSid.setCPU(&relocatedCpu);
+                relocatedCpu.reset();
+                if (!relocatedSid.loadSID(outputFile.string())) {
+                    result.message = "Failed to load relocated SID file";
+                    return;
+                }
+
+                // Emulate both in lockstep, tracing each, and stop at the first frame that differs
+                SIDEmulator originalEmulator(cpu, sid);
+                SIDEmulator relocatedEmulator(&relocatedCpu, &relocatedSid);
+                SIDEmulator::EmulationOptions options;
+                options.frames = DEFAULT_SID_EMULATION_FRAMES;
+
+                bool framesDiffer = false;
+                {
+                    StageTimer stage("verify (stream)");
+                    TraceLogger originalLog(result.originalTrace, TraceFormat::Binary);
+                    TraceLogger relocatedLog(result.relocatedTrace, TraceFormat::Binary);
+                    const auto logFrame = [](TraceLogger& log, const SIDEmulator::FrameView& frame) {
+                        for (const auto& write : frame.writes) {
+                            log.logSIDWrite(write.addr, write.value);
+                        }
+                        log.logFrameMarker();
+                    };
+
+                    auto originalFrames = originalEmulator.frames(options);
+                    auto relocatedFrames = relocatedEmulator.frames(options);
+                    auto original = originalFrames.begin();
+                    auto relocated = relocatedFrames.begin();
+                    for (; original != originalFrames.end() && relocated != relocatedFrames.end(); ++original, ++relocated) {
+                        logFrame(originalLog, *original);
+                        logFrame(relocatedLog, *relocated);
+                        if (!std::ranges::equal(original->writes, relocated->writes)) {
+                            framesDiffer = true;
+                            break;
+                        }
+                    }
+                }
+
+                if (!framesDiffer && originalEmulator.frameStreamFailed()) {
+                    result.message = "Failed to emulate original SID file";
+                    return;
+                }
+                if (!framesDiffer && relocatedEmulator.frameStreamFailed()) {
+                    result.message = "Relocation succeeded but failed to emulate relocated SID file";
+                    return;
+                }
+
+                result.verified = true;
+                result.outputsMatch = !framesDiffer;
+
+                // Report the difference (the traces end at the first differing frame)
+                if (framesDiffer) {
+                    TraceLogger::compareTraceLogs(
+                        result.originalTrace,
+                        result.relocatedTrace,
+                        result.diffReport);
+                }
+
+                if (result.outputsMatch) {
+                    result.message = "Relocation and verification successful";
+                }
+                else {
+                    result.message = "Relocation succeeded but verification failed - outputs differ";
+                }
+            }
+
+        } // anonymous namespace
+
         RelocationResult relocateSID(
             CPU6510* cpu,
             SIDLoader* sid,
@@ -20,14 +351,6 @@ namespace sidblaster {
             RelocationResult result;
             result.success = false;
 
-            // Validate that both input and output are SID files
-            const std::string inExt = getFileExtension(params.inputFile);
-            if (inExt != ".sid") {
-                result.message = "Input file must be a SID file (.sid): " + params.inputFile.string();
-                Logger::error(result.message);
-                return result;
-            }
-
             const std::string outExt = getFileExtension(params.outputFile);
             if (outExt != ".sid") {
                 result.message = "Output file must be a SID file (.sid): " + params.outputFile.string();
@@ -35,58 +358,8 @@ namespace sidblaster {
                 return result;
             }
 
-            // Create temp directory if it doesn't exist
-            try {
-                fs::create_directories(params.tempDir);
-            }
-            catch (const std::exception& e) {
-                result.message = std::string("Failed to create temp directory: ") + e.what();
-                Logger::error(result.message);
-                return result;
-            }
-
-            // Load the input file
-            if (!sid->loadSID(params.inputFile.string())) {
-                result.message = "Failed to load file for relocation: " + params.inputFile.string();
-                Logger::error(result.message);
-                return result;
-            }
-
-            // Get original addresses and header
-            result.originalLoad = sid->getLoadAddress();
-            result.originalInit = sid->getInitAddress();
-            result.originalPlay = sid->getPlayAddress();
-
-            // Get the original SID header to preserve its flags and additional SID addresses
-            const SIDHeader& originalHeader = sid->getHeader();
-            u16 originalFlags = originalHeader.flags;
-            u8 secondSIDAddress = originalHeader.secondSIDAddress;
-            u8 thirdSIDAddress = originalHeader.thirdSIDAddress;
-            u16 version = originalHeader.version;
-
-            // Calculate relocated addresses
-            result.newLoad = params.relocationAddress;
-            result.newInit = result.newLoad + (result.originalInit - result.originalLoad);
-            result.newPlay = result.newLoad + (result.originalPlay - result.originalLoad);
-
-            Logger::info("Original addresses - Load: $" + wordToHex(result.originalLoad) +
-                ", Init: $" + wordToHex(result.originalInit) +
-                ", Play: $" + wordToHex(result.originalPlay) +
-                ", Flags: $" + wordToHex(originalFlags) +
-                ", Version: " + std::to_string(version));
-
-            Logger::info("Relocated addresses - Load: $" + wordToHex(result.newLoad) +
-                ", Init: $" + wordToHex(result.newInit) +
-                ", Play: $" + wordToHex(result.newPlay));
-
-            // Create a Disassembler
-            sidblaster::Disassembler disassembler(*cpu, *sid);
-
-            // Run emulation to analyze memory access patterns
-            const int numFrames = sidblaster::util::ConfigManager::getInt("emulationFrames");
-            if (!runSIDEmulation(cpu, sid, numFrames)) {
-                result.message = "Failed to run SID emulation for memory analysis";
-                Logger::error(result.message);
+            const auto disassembler = analyzeForRelocation(cpu, sid, params, result);
+            if (!disassembler) {
                 return result;
             }
 
@@ -100,64 +373,112 @@ namespace sidblaster {
             const fs::path tempAsmFile = params.tempDir / (basename + "-relocated.asm");
             const fs::path tempPrgFile = params.tempDir / (basename + "-relocated.prg");
 
-            // Generate ASM with relocated addresses
-            result.unusedBytesRemoved = disassembler.generateAsmFile(
-                tempAsmFile.string(),
-                result.newLoad,
-                result.newInit,
-                result.newPlay);
-
-            // Assemble to PRG
-            if (!assembleAsmToPrg(tempAsmFile, tempPrgFile, params.kickAssPath)) {
-                result.message = "Failed to assemble relocated code: " + tempAsmFile.string();
-                Logger::error(result.message);
+            if (!writeRelocatedAsm(*disassembler, tempAsmFile, params.relocationAddress, sid->getDataSize(), result)) {
                 return result;
             }
+            buildRelocatedSID(sid->getHeader(), tempAsmFile, tempPrgFile, params.outputFile, params.kickAssPath, result);
 
-            // Create SID file from PRG
-            const std::string title = originalHeader.name;
-            const std::string author = originalHeader.author;
-            const std::string copyright = originalHeader.copyright;
-
-            if (!createSIDFromPRG(
-                tempPrgFile,
-                params.outputFile,
-                result.newLoad,
-                result.newInit,
-                result.newPlay,
-                title,
-                author,
-                copyright,
-                originalFlags,       // Pass original header flags
-                secondSIDAddress,    // Pass original secondSIDAddress
-                thirdSIDAddress,    // Pass original thirdSIDAddress
-                version)) {     // Pass original version number
-
-                // If SID creation fails, fall back to PRG
-                Logger::warning("SID file generation failed. Saving as PRG instead.");
-
+            // The SID fills the gaps between the windows; a demo links the segments from the assembly instead
+            if (result.success && !params.windows.empty()) {
+                const fs::path asmOutput = fs::path(params.outputFile).replace_extension(".asm");
                 try {
-                    fs::copy_file(tempPrgFile, params.outputFile, fs::copy_options::overwrite_existing);
-
-                    result.success = true;
-                    result.message = "Relocation complete (saved as PRG). " +
-                        std::to_string(result.unusedBytesRemoved) + " unused bytes removed.";
-                    Logger::info(result.message);
+                    fs::copy_file(tempAsmFile, asmOutput, fs::copy_options::overwrite_existing);
+                    Logger::info("Segment assembly written to " + asmOutput.string());
                 }
                 catch (const std::exception& e) {
-                    result.message = std::string("Failed to copy output file: ") + e.what();
+                    result.success = false;
+                    result.message = std::string("Failed to write segment assembly: ") + e.what();
                     Logger::error(result.message);
-                    return result;
                 }
             }
-            else {
-                result.success = true;
-                result.message = "Relocation to SID complete. " +
-                    std::to_string(result.unusedBytesRemoved) + " unused bytes removed.";
-                Logger::info(result.message);
+            return result;
+        }
+
+        std::vector<RelocationVerificationResult> relocateSIDToTargets(
+            CPU6510* cpu,
+            SIDLoader* sid,
+            const RelocationParams& params,
+            std::span<const RelocationTarget> targets,
+            bool verify) {
+
+            std::vector<RelocationVerificationResult> results(targets.size());
+            for (auto& result : results) {
+                result.success = false;
+                result.verified = false;
+                result.outputsMatch = false;
             }
 
-            return result;
+            for (size_t i = 0; i < targets.size(); ++i) {
+                if (getFileExtension(targets[i].outputFile) != ".sid") {
+                    results[i].message = "Output file must be a SID file (.sid): " + targets[i].outputFile.string();
+                    Logger::error(results[i].message);
+                    return results;
+                }
+            }
+
+            // One emulation and analysis serves every target; scattering is for a single output
+            RelocationParams analysisParams = params;
+            analysisParams.windows.clear();
+            RelocationResult analysis;
+            analysis.success = false;
+            const auto disassembler = analyzeForRelocation(cpu, sid, analysisParams, analysis);
+            if (!disassembler) {
+                for (auto& result : results) {
+                    result.message = analysis.message;
+                }
+                return results;
+            }
+
+            // Writing shares the analysis, so the assembly files are written one after the other
+            const std::string basename = params.inputFile.stem().string();
+            std::vector<RelocationResult> relocations(targets.size(), analysis);
+            std::vector<fs::path> asmFiles;
+            for (size_t i = 0; i < targets.size(); ++i) {
+                const std::string stem = basename + "-" + wordToHex(targets[i].address);
+                asmFiles.push_back(params.tempDir / (stem + "-relocated.asm"));
+                writeRelocatedAsm(*disassembler, asmFiles.back(), targets[i].address, sid->getDataSize(), relocations[i]);
+                results[i].bytesSaved = relocations[i].bytesSaved;
+                results[i].memoryMap = relocations[i].memoryMap;
+
+                results[i].originalTrace = (params.tempDir / (stem + "-original.trace")).string();
+                results[i].relocatedTrace = (params.tempDir / (stem + "-relocated.trace")).string();
+                results[i].diffReport = (params.tempDir / (stem + "-diff.txt")).string();
+            }
+
+            // KickAss and the verification runs are independent per target, so each gets a thread
+            const SIDHeader header = sid->getHeader();
+            std::vector<std::thread> workers;
+            for (size_t i = 0; i < targets.size(); ++i) {
+                workers.emplace_back([&, i] {
+                    RelocationVerificationResult& result = results[i];
+                    try {
+                        const fs::path prgFile = fs::path(asmFiles[i]).replace_extension(".prg");
+                        buildRelocatedSID(header, asmFiles[i], prgFile, targets[i].outputFile, params.kickAssPath, relocations[i]);
+                        if (!relocations[i].success) {
+                            result.message = "Relocation failed: " + relocations[i].message;
+                            return;
+                        }
+
+                        result.success = true;
+                        result.message = relocations[i].message;
+                        if (verify) {
+                            CPU6510 originalCpu;
+                            SIDLoader originalSid;
+                            originalSid.setCPU(&originalCpu);
+                            originalCpu.reset();
+                            verifyRelocation(&originalCpu, &originalSid, params.inputFile, targets[i].outputFile, result);
+                        }
+                    }
+                    catch (const std::exception& e) {
+                        result.message = std::string("Exception during relocation/verification: ") + e.what();
+                    }
+                    });
+            }
+            for (auto& worker : workers) {
+                worker.join();
+            }
+
+            return results;
         }
 
         RelocationVerificationResult relocateAndVerifySID(
@@ -167,7 +488,9 @@ namespace sidblaster {
             const fs::path& outputFile,
             u16 relocationAddress,
             const fs::path& tempDir,
-            const std::string& kickAssPath) {  // Add parameter here too
+            const std::string& kickAssPath,
+            bool compact,
+            std::span<const std::pair<u16, u16>> windows) {
 
             RelocationVerificationResult result;
             result.success = false;
@@ -191,8 +514,12 @@ namespace sidblaster {
                 relocParams.tempDir = tempDir;
                 relocParams.relocationAddress = relocationAddress;
                 relocParams.kickAssPath = kickAssPath;  // Use the passed KickAss path
+                relocParams.compact = compact;
+                relocParams.windows.assign(windows.begin(), windows.end());
 
                 util::RelocationResult relocResult = util::relocateSID(cpu, sid, relocParams);
+                result.bytesSaved = relocResult.bytesSaved;
+                result.memoryMap = relocResult.memoryMap;
 
                 if (!relocResult.success) {
                     result.message = "Relocation failed: " + relocResult.message;
@@ -201,50 +528,8 @@ namespace sidblaster {
 
                 result.success = true;
 
-                // Step 2: Create trace of original SID
-                if (!sid->loadSID(inputFile.string())) {
-                    result.message = "Failed to load original SID file";
-                    return result;
-                }
-                SIDEmulator originalEmulator(cpu, sid);
-                SIDEmulator::EmulationOptions options;
-                options.frames = DEFAULT_SID_EMULATION_FRAMES;
-                options.traceEnabled = true;
-                options.traceLogPath = originalTrace.string();
-                cpu->reset();
-                if (!originalEmulator.runEmulation(options)) {
-                    result.message = "Failed to emulate original SID file";
-                    return result;
-                }
-
-                // Step 3: Verify the relocated SID
-                if (!sid->loadSID(outputFile.string())) {
-                    result.message = "Failed to load relocated SID file";
-                    return result;
-                }
-                SIDEmulator relocatedEmulator(cpu, sid);
-                options.traceLogPath = relocatedTrace.string();
-                cpu->reset();
-                if (!relocatedEmulator.runEmulation(options)) {
-                    result.message = "Relocation succeeded but failed to emulate relocated SID file";
-                    return result;
-                }
-
-                result.verified = true;
-
-                // Step 4: Compare trace files
-                result.outputsMatch = TraceLogger::compareTraceLogs(
-                    originalTrace.string(),
-                    relocatedTrace.string(),
-                    diffReport.string());
-
-                if (result.outputsMatch) {
-                    result.message = "Relocation and verification successful";
-                }
-                else {
-                    result.message = "Relocation succeeded but verification failed - outputs differ";
-                }
-
+                // Step 2: Emulate both tunes and compare their SID writes
+                verifyRelocation(cpu, sid, inputFile, outputFile, result);
                 return result;
             }
             catch (const std::exception& e) {
@@ -262,6 +547,11 @@ namespace sidblaster {
             std::string kickCommand = kickAssPath + " \"" + asmFile.string() + "\" -o \"" +
                 prgFile.string() + "\"";
 
+            StageTimer stage("assemble");
+            stage.setCategory("tool");
+            stage.setDetail(kickCommand);
+            stage.addOutputFile(prgFile);
+
             Logger::debug("Assembling: " + kickCommand);
             const int result = std::system(kickCommand.c_str());
 
@@ -287,6 +577,9 @@ namespace sidblaster {
             u8 thirdSIDAddress,
             u16 version) {
 
+            StageTimer stage("write SID");
+            stage.addOutputFile(sidFile);
+
             // Read the PRG file
             std::ifstream prg(prgFile, std::ios::binary | std::ios::ate);
             if (!prg) {
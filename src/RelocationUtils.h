@@ -2,7 +2,9 @@
 
 #include "Common.h"
 #include <filesystem>
+#include <span>
 #include <string>
+#include <vector>
 
 namespace fs = std::filesystem;
 class CPU6510;
@@ -25,6 +27,18 @@ namespace sidblaster {
             u16 relocationAddress = 0;    ///< Target address for relocation (initialized to 0)
             std::string kickAssPath;      ///< Path to KickAss.jar
             bool verbose = false;         ///< Verbose logging (initialized to false)
+            bool compact = false;         ///< Remove unused bytes instead of zeroing them
+            std::vector<std::pair<u16, u16>> windows; ///< Free memory windows to scatter the tune into (empty: one block at relocationAddress)
+        };
+
+        /**
+         * @struct MemoryMapBlock
+         * @brief Where one block of the original tune ends up after relocation
+         */
+        struct MemoryMapBlock {
+            u16 originalStart = 0;        ///< First address in the original tune
+            u16 originalEnd = 0;          ///< Last address in the original tune
+            u16 newStart = 0;             ///< First address in the relocated tune
         };
 
         /**
@@ -40,6 +54,8 @@ namespace sidblaster {
             u16 newInit;                  ///< New init address
             u16 newPlay;                  ///< New play address
             int unusedBytesRemoved;       ///< Number of unused bytes removed
+            int bytesSaved = 0;           ///< Bytes left out by compaction
+            std::vector<MemoryMapBlock> memoryMap; ///< Kept blocks and where they moved to
             std::string message;          ///< Additional info/error message
         };
 
@@ -62,6 +78,8 @@ namespace sidblaster {
             std::string originalTrace;   // Path to original trace file
             std::string relocatedTrace;  // Path to relocated trace file
             std::string diffReport;      // Path to difference report file
+            int bytesSaved = 0;          // Bytes left out by compaction
+            std::vector<MemoryMapBlock> memoryMap; // Kept blocks and where they moved to
             std::string message;         // Detailed message
         };
 
@@ -79,8 +97,39 @@ namespace sidblaster {
             const fs::path& outputFile,
             u16 relocationAddress,
             const fs::path& tempDir,
-            const std::string& kickAssPath = "");
+            const std::string& kickAssPath = "",
+            bool compact = false,
+            std::span<const std::pair<u16, u16>> windows = {});
+
+
+        /**
+         * @struct RelocationTarget
+         * @brief One output of a multi-target relocation
+         */
+        struct RelocationTarget {
+            u16 address = 0;              ///< Target load address
+            fs::path outputFile;          ///< SID file to write
+        };
 
+        /**
+         * @brief Relocate a SID file to several addresses from one analysis
+         * @param cpu CPU instance for disassembly
+         * @param sid SID loader for file handling
+         * @param params Relocation parameters (outputFile, relocationAddress and windows are not used)
+         * @param targets Addresses to relocate to and the files to write
+         * @param verify Whether to verify each output against the original
+         * @return One result per target, in the same order
+         *
+         * The tune is loaded, emulated and analyzed once, and an assembly file
+         * is written for each target. The targets are then assembled and
+         * verified at the same time, one thread each.
+         */
+        std::vector<RelocationVerificationResult> relocateSIDToTargets(
+            CPU6510* cpu,
+            SIDLoader* sid,
+            const RelocationParams& params,
+            std::span<const RelocationTarget> targets,
+            bool verify);
 
         /**
          * @brief Assemble an ASM file to PRG
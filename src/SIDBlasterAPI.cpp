@@ -0,0 +1,295 @@
+// ==================================
+//             SIDBlaster
+//
+//  Raistlin / Genesis Project (G*P)
+// ==================================
+#include "SIDBlasterAPI.h"
+
+#include "cpu6510.h"
+#include "RelocationUtils.h"
+#include "SIDEmulator.h"
+#include "SIDLoader.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <string>
+#include <vector>
+
+/**
+ * @brief A loaded tune: the SID file bytes plus the CPU holding it in memory
+ */
+struct SIDBlasterTune {
+    std::vector<u8> file;                 // SID file contents (relocation reloads from these)
+    std::unique_ptr<CPU6510> cpu;         // CPU with the tune in memory
+    std::unique_ptr<SIDLoader> sid;       // Loader that parsed the file
+};
+
+namespace {
+
+    thread_local std::string lastError_;  // Message of the last failure on this thread
+
+    /**
+     * @brief Record an error message and return its status code
+     */
+    int fail(int status, std::string message) {
+        lastError_ = std::move(message);
+        return status;
+    }
+
+    /**
+     * @brief Translate an exception escaping the core into a status code
+     *
+     * Must be called from a catch block.
+     */
+    int failFromException() {
+        try {
+            throw;
+        }
+        catch (const std::bad_alloc&) {
+            return fail(SIDBLASTER_ERROR_MEMORY, "Out of memory");
+        }
+        catch (const std::exception& e) {
+            return fail(SIDBLASTER_ERROR_INTERNAL, e.what());
+        }
+        catch (...) {
+            return fail(SIDBLASTER_ERROR_INTERNAL, "Unknown error");
+        }
+    }
+
+    /**
+     * @brief Copy bytes into a buffer the caller releases with sidblaster_free_buffer
+     */
+    int returnBuffer(const std::vector<u8>& bytes, uint8_t** data, size_t* size) {
+        auto* buffer = static_cast<uint8_t*>(std::malloc(std::max<size_t>(bytes.size(), 1)));
+        if (!buffer) {
+            return fail(SIDBLASTER_ERROR_MEMORY, "Out of memory");
+        }
+        std::copy(bytes.begin(), bytes.end(), buffer);
+        *data = buffer;
+        *size = bytes.size();
+        return SIDBLASTER_OK;
+    }
+
+    /**
+     * @brief Copy a fixed-size header string, adding the missing terminator
+     */
+    template <size_t DestSize, size_t SrcSize>
+    void copyHeaderString(char (&dest)[DestSize], const char (&src)[SrcSize]) {
+        static_assert(DestSize > SrcSize, "No room for the terminator");
+        std::memcpy(dest, src, SrcSize);
+        dest[SrcSize] = '\0';
+    }
+
+    /**
+     * @brief Load SID file contents into a CPU
+     */
+    bool loadTune(CPU6510& cpu, SIDLoader& sid, const std::vector<u8>& file) {
+        cpu.reset();
+        sid.setCPU(&cpu);
+        return sid.loadSIDFromBuffer(file);
+    }
+
+    /**
+     * @brief Create a directory of its own under the system temp path
+     */
+    fs::path makeTempDirectory() {
+        static std::atomic<unsigned> counter{ 0 };
+        const fs::path base = fs::temp_directory_path();
+        for (;;) {
+            const fs::path dir = base / ("sidblaster-" + std::to_string(std::rand()) + "-" +
+                std::to_string(counter.fetch_add(1)));
+            if (fs::create_directory(dir)) {
+                return dir;
+            }
+        }
+    }
+
+    /**
+     * @brief Removes a temp directory when leaving scope
+     */
+    struct TempDirectory {
+        fs::path path;
+
+        ~TempDirectory() {
+            std::error_code ec;
+            fs::remove_all(path, ec);
+        }
+    };
+
+} // namespace
+
+extern "C" {
+
+    int sidblaster_api_version(void) {
+        return SIDBLASTER_API_VERSION;
+    }
+
+    const char* sidblaster_last_error(void) {
+        return lastError_.c_str();
+    }
+
+    SIDBlasterTune* sidblaster_load(const uint8_t* data, size_t size) {
+        if (!data || size == 0) {
+            fail(SIDBLASTER_ERROR_ARGUMENT, "No SID data");
+            return nullptr;
+        }
+
+        try {
+            auto tune = std::make_unique<SIDBlasterTune>();
+            tune->file.assign(data, data + size);
+            tune->cpu = std::make_unique<CPU6510>();
+            tune->sid = std::make_unique<SIDLoader>();
+            if (!loadTune(*tune->cpu, *tune->sid, tune->file)) {
+                fail(SIDBLASTER_ERROR_LOAD, "Not a supported SID file (PSID v1-4 expected)");
+                return nullptr;
+            }
+            return tune.release();
+        }
+        catch (...) {
+            failFromException();
+            return nullptr;
+        }
+    }
+
+    void sidblaster_free(SIDBlasterTune* tune) {
+        delete tune;
+    }
+
+    int sidblaster_get_info(const SIDBlasterTune* tune, SIDBlasterInfo* info) {
+        if (!tune || !info) {
+            return fail(SIDBLASTER_ERROR_ARGUMENT, "Null tune or info");
+        }
+
+        const SIDHeader& header = tune->sid->getHeader();
+        *info = {};
+        info->loadAddress = tune->sid->getLoadAddress();
+        info->initAddress = tune->sid->getInitAddress();
+        info->playAddress = tune->sid->getPlayAddress();
+        info->dataSize = tune->sid->getDataSize();
+        info->songs = header.songs;
+        info->startSong = header.startSong;
+        info->version = header.version;
+        info->flags = header.flags;
+        copyHeaderString(info->name, header.name);
+        copyHeaderString(info->author, header.author);
+        copyHeaderString(info->copyright, header.copyright);
+        return SIDBLASTER_OK;
+    }
+
+    int sidblaster_analyze(SIDBlasterTune* tune, int frames, SIDBlasterAnalysis* analysis) {
+        if (!tune || !analysis || frames < 0) {
+            return fail(SIDBLASTER_ERROR_ARGUMENT, "Null tune or analysis, or negative frame count");
+        }
+
+        try {
+            sidblaster::SIDEmulator emulator(tune->cpu.get(), tune->sid.get());
+            sidblaster::SIDEmulator::EmulationOptions options;
+            options.frames = frames > 0 ? frames : DEFAULT_SID_EMULATION_FRAMES;
+            options.worstFrameCount = 1;
+            if (!emulator.runEmulation(options)) {
+                return fail(SIDBLASTER_ERROR_EMULATION, "Init or play routine did not return");
+            }
+
+            const auto [averageCycles, maxCycles] = emulator.getCycleStats();
+            const auto& worstFrames = emulator.getWorstFrames();
+            *analysis = {};
+            analysis->frames = options.frames;
+            analysis->averageCycles = averageCycles;
+            analysis->maxCycles = maxCycles;
+            analysis->worstFrame = worstFrames.empty() ? 0 : worstFrames.front().frame;
+            return SIDBLASTER_OK;
+        }
+        catch (...) {
+            return failFromException();
+        }
+    }
+
+    int sidblaster_get_trace(SIDBlasterTune* tune, int frames, uint8_t** data, size_t* size) {
+        if (!tune || !data || !size || frames < 0) {
+            return fail(SIDBLASTER_ERROR_ARGUMENT, "Null tune or output, or negative frame count");
+        }
+
+        try {
+            sidblaster::SIDEmulator emulator(tune->cpu.get(), tune->sid.get());
+            sidblaster::SIDEmulator::EmulationOptions options;
+            options.frames = frames > 0 ? frames : DEFAULT_SID_EMULATION_FRAMES;
+
+            std::vector<u8> trace;
+            for (const auto& view : emulator.frames(options)) {
+                if (view.phase != sidblaster::SIDEmulator::FramePhase::Play) {
+                    continue;
+                }
+                for (const auto& write : view.writes) {
+                    const u8 record[4] = {
+                        static_cast<u8>(write.addr & 0xFF), static_cast<u8>(write.addr >> 8), write.value, 0 };
+                    trace.insert(trace.end(), std::begin(record), std::end(record));
+                }
+                trace.insert(trace.end(), 4, 0xFF);
+            }
+            if (emulator.frameStreamFailed()) {
+                return fail(SIDBLASTER_ERROR_EMULATION, "Init or play routine did not return");
+            }
+
+            return returnBuffer(trace, data, size);
+        }
+        catch (...) {
+            return failFromException();
+        }
+    }
+
+    int sidblaster_relocate(SIDBlasterTune* tune, uint16_t address, const char* kickAssCommand,
+        uint8_t** data, size_t* size) {
+        if (!tune || !data || !size) {
+            return fail(SIDBLASTER_ERROR_ARGUMENT, "Null tune or output");
+        }
+
+        try {
+            const TempDirectory tempDir{ makeTempDirectory() };
+            const fs::path inputFile = tempDir.path / "tune.sid";
+            const fs::path outputFile = tempDir.path / "tune-relocated.sid";
+
+            std::ofstream(inputFile, std::ios::binary).write(
+                reinterpret_cast<const char*>(tune->file.data()), static_cast<std::streamsize>(tune->file.size()));
+
+            // Relocation disassembles from a fresh copy so the tune's own memory is left alone
+            CPU6510 cpu;
+            SIDLoader sid;
+            if (!loadTune(cpu, sid, tune->file)) {
+                return fail(SIDBLASTER_ERROR_LOAD, "Failed to reload the tune");
+            }
+
+            sidblaster::util::RelocationParams params;
+            params.inputFile = inputFile;
+            params.outputFile = outputFile;
+            params.tempDir = tempDir.path;
+            params.relocationAddress = address;
+            params.kickAssPath = kickAssCommand ? kickAssCommand : "java -jar KickAss.jar -silentMode";
+
+            const sidblaster::util::RelocationResult result = sidblaster::util::relocateSID(&cpu, &sid, params);
+            if (!result.success) {
+                return fail(SIDBLASTER_ERROR_RELOCATION, result.message);
+            }
+
+            std::ifstream in(outputFile, std::ios::binary);
+            const std::vector<u8> relocated{ std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>() };
+            if (relocated.empty()) {
+                return fail(SIDBLASTER_ERROR_RELOCATION, "Relocation produced no output");
+            }
+            return returnBuffer(relocated, data, size);
+        }
+        catch (...) {
+            return failFromException();
+        }
+    }
+
+    void sidblaster_free_buffer(uint8_t* data) {
+        std::free(data);
+    }
+
+} // extern "C"
@@ -0,0 +1,175 @@
+// ==================================
+//             SIDBlaster
+//
+//  Raistlin / Genesis Project (G*P)
+// ==================================
+#pragma once
+
+/**
+ * @file SIDBlasterAPI.h
+ * @brief C interface of the sidblaster library
+ *
+ * A small, stable C API over the SIDBlaster core for embedding in other tools
+ * (players, trackers, web services). Everything works on memory buffers:
+ * tunes are loaded from the bytes of a SID file, and traces and relocated
+ * tunes come back as buffers owned by the caller.
+ *
+ * Functions return SIDBLASTER_OK (0) or a negative status code; the text of
+ * the last error on the calling thread is available from sidblaster_last_error().
+ * Buffers returned by the library must be released with sidblaster_free_buffer().
+ * A tune may be used by one thread at a time; different tunes are independent.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(SIDBLASTER_SHARED)
+#  if defined(_WIN32)
+#    if defined(SIDBLASTER_BUILDING_LIBRARY)
+#      define SIDBLASTER_API __declspec(dllexport)
+#    else
+#      define SIDBLASTER_API __declspec(dllimport)
+#    endif
+#  else
+#    define SIDBLASTER_API __attribute__((visibility("default")))
+#  endif
+#else
+#  define SIDBLASTER_API
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @brief Version of this API; bumped on incompatible changes */
+#define SIDBLASTER_API_VERSION 1
+
+/**
+ * @brief Status codes
+ */
+typedef enum SIDBlasterStatus {
+    SIDBLASTER_OK = 0,                    /**< Success */
+    SIDBLASTER_ERROR_ARGUMENT = -1,       /**< Null or out-of-range argument */
+    SIDBLASTER_ERROR_LOAD = -2,           /**< Data is not a supported (PSID) SID file */
+    SIDBLASTER_ERROR_EMULATION = -3,      /**< Init or play routine did not return */
+    SIDBLASTER_ERROR_RELOCATION = -4,     /**< Relocation failed (see sidblaster_last_error) */
+    SIDBLASTER_ERROR_MEMORY = -5,         /**< Out of memory */
+    SIDBLASTER_ERROR_INTERNAL = -6        /**< Unexpected failure */
+} SIDBlasterStatus;
+
+/** @brief Opaque handle to a loaded tune */
+typedef struct SIDBlasterTune SIDBlasterTune;
+
+/**
+ * @brief Header information of a loaded tune
+ */
+typedef struct SIDBlasterInfo {
+    uint16_t loadAddress;                 /**< C64 load address */
+    uint16_t initAddress;                 /**< Init routine */
+    uint16_t playAddress;                 /**< Play routine */
+    uint16_t dataSize;                    /**< Size of the music data in bytes */
+    uint16_t songs;                       /**< Number of songs */
+    uint16_t startSong;                   /**< Default song (1-based) */
+    uint16_t version;                     /**< PSID version (1-4) */
+    uint16_t flags;                       /**< PSID v2+ flags */
+    char name[33];                        /**< Title, null-terminated */
+    char author[33];                      /**< Author, null-terminated */
+    char copyright[33];                   /**< Release info, null-terminated */
+} SIDBlasterInfo;
+
+/**
+ * @brief Result of sidblaster_analyze
+ */
+typedef struct SIDBlasterAnalysis {
+    int32_t frames;                       /**< Measured frames emulated */
+    uint64_t averageCycles;               /**< Average cycles per frame */
+    uint64_t maxCycles;                   /**< Cycles of the most expensive frame */
+    int32_t worstFrame;                   /**< Index of the most expensive frame */
+} SIDBlasterAnalysis;
+
+/**
+ * @brief Get the API version the library was built with
+ * @return SIDBLASTER_API_VERSION of the library
+ */
+SIDBLASTER_API int sidblaster_api_version(void);
+
+/**
+ * @brief Get the text of the last error on the calling thread
+ * @return Error message (empty if none); valid until the next call on this thread
+ */
+SIDBLASTER_API const char* sidblaster_last_error(void);
+
+/**
+ * @brief Load a tune from the contents of a SID file
+ * @param data SID file contents (copied; may be released after the call)
+ * @param size Size of data in bytes
+ * @return Tune handle, or NULL on failure
+ */
+SIDBLASTER_API SIDBlasterTune* sidblaster_load(const uint8_t* data, size_t size);
+
+/**
+ * @brief Release a tune
+ * @param tune Tune handle (NULL is ignored)
+ */
+SIDBLASTER_API void sidblaster_free(SIDBlasterTune* tune);
+
+/**
+ * @brief Get the header information of a tune
+ * @param tune Tune handle
+ * @param info Receives the information
+ * @return Status code
+ */
+SIDBLASTER_API int sidblaster_get_info(const SIDBlasterTune* tune, SIDBlasterInfo* info);
+
+/**
+ * @brief Emulate a tune and measure its play routine
+ * @param tune Tune handle
+ * @param frames Measured frames (0 = library default)
+ * @param analysis Receives the measurements
+ * @return Status code
+ *
+ * Runs the same sequence as the command line tool: init, warm-up frames,
+ * init again, then the measured frames. The tune's memory is restored
+ * afterwards, so calls can be repeated.
+ */
+SIDBLASTER_API int sidblaster_analyze(SIDBlasterTune* tune, int frames, SIDBlasterAnalysis* analysis);
+
+/**
+ * @brief Record the SID register writes of a tune
+ * @param tune Tune handle
+ * @param frames Measured frames (0 = library default)
+ * @param data Receives the trace (release with sidblaster_free_buffer)
+ * @param size Receives the trace size in bytes
+ * @return Status code
+ *
+ * The trace uses the binary trace-file format: 4-byte records of address
+ * (little-endian), value and a zero byte, with FF FF FF FF after each
+ * measured frame. Writes of the init calls and warm-up frames are omitted.
+ */
+SIDBLASTER_API int sidblaster_get_trace(SIDBlasterTune* tune, int frames, uint8_t** data, size_t* size);
+
+/**
+ * @brief Relocate a tune to a new load address
+ * @param tune Tune handle
+ * @param address New load address
+ * @param kickAssCommand Assembler command line (NULL = "java -jar KickAss.jar -silentMode")
+ * @param data Receives the relocated SID file (release with sidblaster_free_buffer)
+ * @param size Receives its size in bytes
+ * @return Status code
+ *
+ * Relocation reassembles the disassembled tune with KickAss, so it runs an
+ * external process and uses a private directory under the system temp path
+ * (removed before returning).
+ */
+SIDBLASTER_API int sidblaster_relocate(SIDBlasterTune* tune, uint16_t address, const char* kickAssCommand,
+    uint8_t** data, size_t* size);
+
+/**
+ * @brief Release a buffer returned by the library
+ * @param data Buffer (NULL is ignored)
+ */
+SIDBLASTER_API void sidblaster_free_buffer(uint8_t* data);
+
+#ifdef __cplusplus
+}
+#endif
@@ -11,6 +11,7 @@
 #include <fstream>
 #include <iomanip>
 #include <iostream>
+#include <mutex>
 #include <sstream>
 #include <unordered_map>
 #include <ctime>
@@ -104,6 +105,62 @@ namespace sidblaster {
             }
         }
 
+        /**
+         * @brief Parse a comma-separated list of addresses
+         *
+         * Each entry takes any format parseHex() accepts.
+         *
+         * @param str String to parse, e.g. "$1000,$2000"
+         * @return Parsed values in order, or std::nullopt if any of them failed to parse
+         */
+        std::optional<std::vector<u16>> parseHexList(std::string_view str) {
+            std::vector<u16> values;
+            for (;;) {
+                const auto comma = str.find(',');
+                const auto value = parseHex(str.substr(0, comma));
+                if (!value) {
+                    return std::nullopt;
+                }
+                values.push_back(*value);
+                if (comma == std::string_view::npos) {
+                    return values;
+                }
+                str.remove_prefix(comma + 1);
+            }
+        }
+
+        /**
+         * @brief Parse a comma-separated list of address ranges
+         *
+         * Each entry is two addresses in any format parseHex() accepts, joined
+         * by a dash. Both ends are included, and the first must not be above
+         * the last.
+         *
+         * @param str String to parse, e.g. "$0A00-$1FFF,$E000-$FFF0"
+         * @return Parsed first and last addresses in order, or std::nullopt if any of them failed to parse
+         */
+        std::optional<std::vector<std::pair<u16, u16>>> parseHexRangeList(std::string_view str) {
+            std::vector<std::pair<u16, u16>> ranges;
+            for (;;) {
+                const auto comma = str.find(',');
+                const std::string_view entry = str.substr(0, comma);
+                const auto dash = entry.find('-');
+                if (dash == std::string_view::npos) {
+                    return std::nullopt;
+                }
+                const auto first = parseHex(entry.substr(0, dash));
+                const auto last = parseHex(entry.substr(dash + 1));
+                if (!first || !last || *first > *last) {
+                    return std::nullopt;
+                }
+                ranges.emplace_back(*first, *last);
+                if (comma == std::string_view::npos) {
+                    return ranges;
+                }
+                str.remove_prefix(comma + 1);
+            }
+        }
+
         /**
          * @brief Pad a string to a specific width with spaces
          *
@@ -250,6 +307,10 @@ namespace sidblaster {
             std::stringstream fullMessage;
             fullMessage << "[" << timestampStr.str() << "] [" << levelStr << "] " << message;
 
+            // Relocation targets are built on several threads at once
+            static std::mutex mutex;
+            std::lock_guard<std::mutex> lock(mutex);
+
             // Write to file if enabled
             if (logFile_) {
                 std::ofstream file(logFile_.value(), std::ios::app);
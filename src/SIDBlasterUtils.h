@@ -13,6 +13,7 @@
 #include <string>
 #include <string_view>
 #include <unordered_map>
+#include <vector>
 
 /**
  * @file SIDBlasterUtils.h
@@ -55,6 +56,20 @@ namespace sidblaster {
          */
         std::optional<u16> parseHex(std::string_view str);
 
+        /**
+         * @brief Parse a comma-separated list of addresses
+         * @param str String to parse, e.g. "$1000,$2000"
+         * @return Parsed values in order, or std::nullopt if any of them failed to parse
+         */
+        std::optional<std::vector<u16>> parseHexList(std::string_view str);
+
+        /**
+         * @brief Parse a comma-separated list of address ranges
+         * @param str String to parse, e.g. "$0A00-$1FFF,$E000-$FFF0"
+         * @return Parsed first and last addresses in order, or std::nullopt if any of them failed to parse
+         */
+        std::optional<std::vector<std::pair<u16, u16>>> parseHexRangeList(std::string_view str);
+
         /**
          * @brief Pad a string to a specific width with spaces
          * @param str String to pad
@@ -124,6 +139,15 @@ namespace sidblaster {
              */
             static void setLogLevel(Level level);
 
+            /**
+             * @brief Check whether messages of a level are logged
+             * @param level Message severity
+             * @return True if the level is at or above the minimum level
+             *
+             * Lets hot paths skip building messages that would be discarded.
+             */
+            static bool isEnabled(Level level) { return level >= minLevel_; }
+
             /**
              * @brief Log a message
              * @param level Message severity
@@ -2,7 +2,13 @@
 #include "cpu6510.h"
 #include "SIDLoader.h"
 #include "SIDBlasterUtils.h"
+#include "PipelineStats.h"
 
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <optional>
 #include <set>
 
 namespace sidblaster {
@@ -17,6 +23,9 @@ namespace sidblaster {
             return false;
         }
 
+        util::StageTimer stage(options.traceEnabled ? "emulate (trace)" :
+            options.registerTrackingEnabled ? "emulate (tracking)" : "emulate", cpu_);
+
         // Temporarily disable register tracking for init
         bool originalTrackingEnabled = options.registerTrackingEnabled;
         bool temporaryTrackingEnabled = false;
@@ -52,6 +61,9 @@ namespace sidblaster {
         // Create a backup of memory
         sid_->backupMemory();
 
+        // Suspicious conditions seen by the CPU are counted and reported once at the end
+        cpu_->clearDiagnostics();
+
         // Initialize the SID
         const u16 initAddr = sid_->getInitAddress();
         const u16 playAddr = sid_->getPlayAddress();
@@ -60,18 +72,29 @@ namespace sidblaster {
             ", Play: $" + util::wordToHex(playAddr) +
             ", Frames: " + std::to_string(options.frames));
 
+        // Emulation phases, each recorded as a nested stage
+        std::optional<util::StageTimer> phase;
+        const auto beginPhase = [&phase, this](const char* name) {
+            phase.emplace(name, cpu_);
+            phase->setCategory("emulation");
+        };
+
         // Execute the init routine once
+        beginPhase("init");
         cpu_->resetRegistersAndFlags();
         updateSIDCallback(false);
         cpu_->executeFunction(initAddr);
 
         // Run a short playback period to identify initial memory patterns
         // This helps with memory copies performed during initialization
-        const int preAnalysisFrames = 30000;
+        const int preAnalysisFrames = options.warmUpFrames;
+        beginPhase("warm-up");
+        phase->setFrames(preAnalysisFrames);
         for (int frame = 0; frame < preAnalysisFrames; ++frame) {
             for (int call = 0; call < options.callsPerFrame; ++call) {
                 cpu_->resetRegistersAndFlags();
                 if (!cpu_->executeFunction(playAddr)) {
+                    cpu_->getDiagnostics().logSummary();
                     return false;
                 }
             }
@@ -87,6 +110,7 @@ namespace sidblaster {
         }
 
         // Re-run the init routine to reset the player state
+        beginPhase("init");
         cpu_->resetRegistersAndFlags();
         updateSIDCallback(false);
         cpu_->executeFunction(initAddr);
@@ -100,6 +124,13 @@ namespace sidblaster {
         totalCycles_ = 0;
         maxCyclesPerFrame_ = 0;
         framesExecuted_ = 0;
+        playAddress_ = playAddr;
+        worstFrames_.clear();
+        worstFrames_.reserve(static_cast<size_t>(std::max(0, options.worstFrameCount)) + 1);
+        budgetOverruns_.clear();
+        if (options.captureWorstFrameSnapshots) {
+            callSnapshots_.resize(std::max(1, options.callsPerFrame));
+        }
 
         // Now enable register tracking if requested in the options
         if (options.registerTrackingEnabled) {
@@ -108,19 +139,56 @@ namespace sidblaster {
             updateSIDCallback(true);
         }
 
+        // Profile the measured frames only, so init and pre-analysis don't skew the results
+        if (!options.profilePath.empty()) {
+            profiler_ = std::make_unique<RasterProfiler>();
+            cpu_->setOnSubroutineCallCallback([this](u16 target, u8 sp, u64 cycles) {
+                profiler_->onCall(target, sp, cycles);
+                });
+            cpu_->setOnSubroutineReturnCallback([this](u8 sp, u64 cycles) {
+                profiler_->onReturn(sp, cycles);
+                });
+        }
+        else {
+            profiler_.reset();
+        }
+
+        if (options.heatMapEnabled) {
+            cpu_->setHeatMapEnabled(true);
+        }
+
         // Get initial cycle count
         u64 lastCycles = cpu_->getCycles();
 
         // Call play routine for the specified number of frames
+        beginPhase("frames");
         bool bGood = true;
         for (int frame = 0; frame < options.frames; ++frame) {
             // Execute play routine (multiple times per frame if requested)
+            FrameCost cost;
+            cost.frame = frame;
             for (int call = 0; call < options.callsPerFrame; ++call) {
                 cpu_->resetRegistersAndFlags();
+                if (options.captureWorstFrameSnapshots) {
+                    cpu_->captureSnapshot(callSnapshots_[call]);
+                }
+                if (profiler_) {
+                    profiler_->beginCall(playAddr, cpu_->getSP(), cpu_->getCycles());
+                }
+                const u64 callStart = cpu_->getCycles();
                 bGood = cpu_->executeFunction(playAddr);
+                if (profiler_) {
+                    profiler_->endCall(cpu_->getCycles());
+                }
                 if (!bGood) {
                     break;
                 }
+
+                const u64 callCycles = cpu_->getCycles() - callStart;
+                if (callCycles > cost.callCycles) {
+                    cost.call = call;
+                    cost.callCycles = callCycles;
+                }
             }
 
             if (!bGood) {
@@ -136,6 +204,9 @@ namespace sidblaster {
             totalCycles_ += frameCycles;
             lastCycles = curCycles;
 
+            cost.frameCycles = frameCycles;
+            recordFrameCost(std::move(cost), options);
+
             // Mark end of frame in trace log and write tracker
             if (options.traceEnabled && traceLogger_) {
                 traceLogger_->logFrameMarker();
@@ -145,14 +216,52 @@ namespace sidblaster {
                 writeTracker_.endFrame();
             }
 
+            if (profiler_) {
+                profiler_->endFrame();
+            }
+
             framesExecuted_++;
         }
+        phase->setFrames(static_cast<u64>(framesExecuted_));
+        phase.reset();
+        stage.setFrames(static_cast<u64>(preAnalysisFrames + framesExecuted_));
+
+        // Export the heat map
+        if (options.heatMapEnabled) {
+            cpu_->setHeatMapEnabled(false);
+
+            if (!options.heatMapPath.empty()) {
+                std::filesystem::path csvPath = options.heatMapPath;
+                csvPath.replace_extension(".csv");
+
+                const HeatMap* heatMap = cpu_->getHeatMap();
+                if (heatMap->writeBinary(options.heatMapPath) && heatMap->writeCsv(csvPath.string())) {
+                    util::Logger::info("Wrote heat map: " + options.heatMapPath + " and " + csvPath.string());
+                }
+                else {
+                    util::Logger::error("Failed to write heat map: " + options.heatMapPath);
+                }
+            }
+        }
+
+        // Write the rastertime profile
+        if (profiler_) {
+            cpu_->setOnSubroutineCallCallback(nullptr);
+            cpu_->setOnSubroutineReturnCallback(nullptr);
+
+            std::filesystem::path foldedPath = options.profilePath;
+            foldedPath.replace_extension(".folded");
+            profiler_->writeReport(options.profilePath);
+            profiler_->writeFoldedStacks(foldedPath.string());
+        }
 
         // Analyze register write patterns if tracking was enabled
         if (temporaryTrackingEnabled) {
             writeTracker_.analyzePattern();
         }
 
+        cpu_->getDiagnostics().logSummary();
+
         // Log cycle stats
         const u64 avgCycles = options.frames > 0 ? totalCycles_ / options.frames : 0;
         util::Logger::debug("SID emulation complete - Average cycles per frame: " +
@@ -164,6 +273,190 @@ namespace sidblaster {
         return true;
     }
 
+    util::Generator<SIDEmulator::FrameView> SIDEmulator::frames(EmulationOptions options) {
+        streamFailed_ = false;
+        if (!cpu_ || !sid_) {
+            util::Logger::error("Invalid CPU or SID loader for emulation");
+            streamFailed_ = true;
+            co_return;
+        }
+
+        // Undo everything below however the consumer leaves the stream
+        struct StreamGuard {
+            CPU6510* cpu;
+            SIDLoader* sid;
+            ~StreamGuard() {
+                cpu->setOnSIDWriteCallback(nullptr);
+                cpu->getDiagnostics().logSummary();
+                sid->restoreMemory();
+            }
+        };
+
+        sid_->backupMemory();
+        cpu_->clearDiagnostics();
+        const StreamGuard guard{ cpu_, sid_ };
+
+        frameWrites_.clear();
+        frameWrites_.reserve(256);
+        cpu_->setOnSIDWriteCallback([this](u16 addr, u8 value) {
+            frameWrites_.push_back({ addr, value });
+            });
+
+        const u16 initAddr = sid_->getInitAddress();
+        const u16 playAddr = sid_->getPlayAddress();
+        const int callsPerFrame = std::max(1, options.callsPerFrame);
+
+        // Run one frame's calls and describe them in view
+        FrameView view;
+        const auto runFrame = [this, &view](FramePhase phase, int frame, u16 address, int calls) {
+            frameWrites_.clear();
+            view.phase = phase;
+            view.frame = frame;
+            view.calls = 0;
+            const u64 startCycles = cpu_->getCycles();
+            bool good = true;
+            while (good && view.calls < calls) {
+                cpu_->resetRegistersAndFlags();
+                good = cpu_->executeFunction(address);
+                ++view.calls;
+            }
+            view.cycles = cpu_->getCycles() - startCycles;
+            view.writes = frameWrites_;
+            return good;
+        };
+
+        // Init failures are not fatal, as in runEmulation
+        runFrame(FramePhase::Init, 0, initAddr, 1);
+        co_yield view;
+
+        for (int frame = 0; frame < options.warmUpFrames; ++frame) {
+            if (!runFrame(FramePhase::WarmUp, frame, playAddr, callsPerFrame)) {
+                streamFailed_ = true;
+                co_return;
+            }
+            co_yield view;
+        }
+
+        runFrame(FramePhase::Init, 1, initAddr, 1);
+        co_yield view;
+
+        for (int frame = 0; options.frames <= 0 || frame < options.frames; ++frame) {
+            if (!runFrame(FramePhase::Play, frame, playAddr, callsPerFrame)) {
+                streamFailed_ = true;
+                co_return;
+            }
+            co_yield view;
+        }
+    }
+
+    void SIDEmulator::recordFrameCost(FrameCost cost, const EmulationOptions& options) {
+        if (options.cycleBudget > 0 && cost.frameCycles > options.cycleBudget) {
+            budgetOverruns_.push_back(cost);
+        }
+
+        const size_t keep = static_cast<size_t>(std::max(0, options.worstFrameCount));
+        if (keep == 0 || (worstFrames_.size() >= keep && cost.frameCycles <= worstFrames_.back().frameCycles)) {
+            return;
+        }
+
+        if (options.captureWorstFrameSnapshots) {
+            cost.snapshot = std::make_shared<CPUSnapshot>(callSnapshots_[cost.call]);
+        }
+
+        // Descending by cost; earlier frames stay ahead of later ones with the same cost
+        const auto pos = std::upper_bound(worstFrames_.begin(), worstFrames_.end(), cost.frameCycles,
+            [](u64 cycles, const FrameCost& other) { return cycles > other.frameCycles; });
+        worstFrames_.insert(pos, std::move(cost));
+        if (worstFrames_.size() > keep) {
+            worstFrames_.pop_back();
+        }
+    }
+
+    bool SIDEmulator::writeWorstFrames(const std::string& filename) const {
+        std::ofstream report(filename);
+        if (!report) {
+            util::Logger::error("Failed to create worst frame report: " + filename);
+            return false;
+        }
+
+        std::filesystem::path snapshotPath = filename;
+        snapshotPath.replace_extension(".snap");
+
+        report << "SIDBlaster worst-case frames\n";
+        report << "----------------------------\n";
+        report << "Play address: $" << util::wordToHex(playAddress_) << "\n";
+        report << "Snapshots:    " << snapshotPath.string() << "\n\n";
+        report << "Rank |  Frame | Call | Frame cycles | Call cycles\n";
+        report << "-----+--------+------+--------------+------------\n";
+        for (size_t i = 0; i < worstFrames_.size(); ++i) {
+            const auto& cost = worstFrames_[i];
+            report << std::setw(4) << (i + 1) << " | " << std::setw(6) << cost.frame << " | "
+                << std::setw(4) << cost.call << " | " << std::setw(12) << cost.frameCycles << " | "
+                << std::setw(11) << cost.callCycles << "\n";
+        }
+
+        if (!budgetOverruns_.empty()) {
+            report << "\nFrames over budget: " << budgetOverruns_.size() << "\n\n";
+            report << " Frame | Call | Frame cycles | Call cycles\n";
+            report << "-------+------+--------------+------------\n";
+            for (const auto& cost : budgetOverruns_) {
+                report << std::setw(6) << cost.frame << " | " << std::setw(4) << cost.call << " | "
+                    << std::setw(12) << cost.frameCycles << " | " << std::setw(11) << cost.callCycles << "\n";
+            }
+        }
+
+        // Snapshot layout (little-endian): "SBSN", u16 version, u16 play address, u32 count,
+        // then per frame: u32 frame, u32 call, u64 frame cycles, u64 call cycles,
+        // u16 PC, u8 SP, A, X, Y, P, u64 CPU cycles, 64K memory
+        std::ofstream snapshots(snapshotPath, std::ios::binary);
+        if (!snapshots) {
+            util::Logger::error("Failed to create snapshot file: " + snapshotPath.string());
+            return false;
+        }
+
+        const auto putLE = [&snapshots](u64 value, int bytes) {
+            for (int i = 0; i < bytes; ++i) {
+                snapshots.put(static_cast<char>((value >> (i * 8)) & 0xFF));
+            }
+        };
+
+        u32 count = 0;
+        for (const auto& cost : worstFrames_) {
+            count += cost.snapshot ? 1 : 0;
+        }
+
+        snapshots.write("SBSN", 4);
+        putLE(1, 2);
+        putLE(playAddress_, 2);
+        putLE(count, 4);
+        for (const auto& cost : worstFrames_) {
+            if (!cost.snapshot) {
+                continue;
+            }
+            const CPUSnapshot& state = *cost.snapshot;
+            putLE(static_cast<u32>(cost.frame), 4);
+            putLE(static_cast<u32>(cost.call), 4);
+            putLE(cost.frameCycles, 8);
+            putLE(cost.callCycles, 8);
+            putLE(state.pc, 2);
+            putLE(state.sp, 1);
+            putLE(state.a, 1);
+            putLE(state.x, 1);
+            putLE(state.y, 1);
+            putLE(state.status, 1);
+            putLE(state.cycles, 8);
+            snapshots.write(reinterpret_cast<const char*>(state.memory.data()), state.memory.size());
+        }
+
+        if (!report || !snapshots) {
+            util::Logger::error("Failed to write worst frame report: " + filename);
+            return false;
+        }
+
+        util::Logger::info("Wrote worst frame report: " + filename + " (" + std::to_string(count) + " snapshots)");
+        return true;
+    }
+
     std::pair<u64, u64> SIDEmulator::getCycleStats() const {
         const u64 avgCycles = framesExecuted_ > 0 ? totalCycles_ / framesExecuted_ : 0;
         return { avgCycles, maxCyclesPerFrame_ };
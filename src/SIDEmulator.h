@@ -2,14 +2,19 @@
 #pragma once
 
 #include "Common.h"
+#include "Generator.h"
 #include "app/TraceLogger.h"
+#include "RasterProfiler.h"
 #include "SIDWriteTracker.h"
 
 #include <functional>
 #include <memory>
+#include <span>
+#include <vector>
 
 class CPU6510;
 class SIDLoader;
+struct CPUSnapshot;
 
 namespace sidblaster {
 
@@ -22,17 +27,74 @@ namespace sidblaster {
      */
     class SIDEmulator {
     public:
+        /**
+         * @struct FrameCost
+         * @brief Cycle cost of one emulated frame
+         */
+        struct FrameCost {
+            int frame = 0;            ///< Frame index (0 = first measured frame)
+            int call = 0;             ///< Most expensive play call within the frame
+            u64 frameCycles = 0;      ///< Cycles used by the whole frame
+            u64 callCycles = 0;       ///< Cycles used by that call
+            std::shared_ptr<const CPUSnapshot> snapshot; ///< State at the start of that call (if captured)
+        };
+
+        /**
+         * @struct SIDWrite
+         * @brief One write to a SID register
+         */
+        struct SIDWrite {
+            u16 addr = 0;             ///< Register address
+            u8 value = 0;             ///< Value written
+
+            bool operator==(const SIDWrite&) const = default;
+        };
+
+        /**
+         * @enum FramePhase
+         * @brief Part of the emulation sequence a streamed frame belongs to
+         */
+        enum class FramePhase {
+            Init,                     ///< A call of the init routine
+            WarmUp,                   ///< A warm-up frame (before the second init)
+            Play                      ///< A measured frame
+        };
+
+        /**
+         * @struct FrameView
+         * @brief One frame yielded by frames()
+         *
+         * The write span refers to the emulator's buffer and is only valid until
+         * the stream is advanced.
+         */
+        struct FrameView {
+            FramePhase phase = FramePhase::Play;  ///< Sequence phase
+            int frame = 0;                        ///< Index within the phase
+            int calls = 0;                        ///< Routine calls executed
+            u64 cycles = 0;                       ///< Cycles used by those calls
+            std::span<const SIDWrite> writes;     ///< SID writes, in order
+        };
+
+        static constexpr int WarmUpFrames = 30000;   ///< Play frames run before the second init
+
         /**
          * @struct EmulationOptions
          * @brief Configuration options for SID emulation
          */
         struct EmulationOptions {
             int frames = DEFAULT_SID_EMULATION_FRAMES;   ///< Number of frames to emulate
+            int warmUpFrames = WarmUpFrames;             ///< Play frames run before the second init
             bool traceEnabled = false;                   ///< Whether to generate trace logs
             TraceFormat traceFormat = TraceFormat::Binary; ///< Format for trace logs
             std::string traceLogPath;                    ///< Path for trace log (if enabled)
             int callsPerFrame = 1;                       ///< Calls to play routine per frame
             bool registerTrackingEnabled = false;        ///< Whether to track register write order
+            std::string profilePath;                     ///< Rastertime profile report path (profiling off if empty)
+            bool heatMapEnabled = false;                 ///< Whether to collect per-address execution/access counts
+            std::string heatMapPath;                     ///< Heat map export path (binary; CSV alongside), if any
+            int worstFrameCount = 5;                     ///< Number of most expensive frames to keep
+            bool captureWorstFrameSnapshots = false;     ///< Whether to keep a CPU snapshot for each worst frame
+            u64 cycleBudget = 0;                         ///< Frames using more cycles are reported (0 = no budget)
         };
 
         /**
@@ -49,12 +111,50 @@ namespace sidblaster {
          */
         bool runEmulation(const EmulationOptions& options);
 
+        /**
+         * @brief Stream the emulation frame by frame
+         * @param options Emulation options (only frames, warmUpFrames and callsPerFrame are used; frames <= 0 streams without end)
+         * @return Lazy sequence of frames
+         *
+         * Runs the same sequence as runEmulation (init, warm-up frames, init,
+         * measured frames) but leaves tracing, tracking and statistics to the
+         * consumer. Emulation only advances as the consumer pulls frames and
+         * stops as soon as it stops pulling; memory is restored when the
+         * sequence is finished or destroyed.
+         */
+        util::Generator<FrameView> frames(EmulationOptions options);
+
+        /**
+         * @brief Check whether the last frame stream ended because a routine failed
+         * @return True if init or play did not return
+         */
+        bool frameStreamFailed() const { return streamFailed_; }
+
         /**
          * @brief Get cycle count per frame statistics
          * @return Pair of average and maximum cycles per frame
          */
         std::pair<u64, u64> getCycleStats() const;
 
+        /**
+         * @brief Get the most expensive frames
+         * @return Frames in descending order of cost
+         */
+        const std::vector<FrameCost>& getWorstFrames() const { return worstFrames_; }
+
+        /**
+         * @brief Get every frame that exceeded the cycle budget
+         * @return Frames in emulation order (empty if no budget was set)
+         */
+        const std::vector<FrameCost>& getBudgetOverruns() const { return budgetOverruns_; }
+
+        /**
+         * @brief Write the worst frames as a text report plus a binary snapshot file
+         * @param filename Report filename (snapshots go to the same name with a .snap extension)
+         * @return True if both files were written successfully
+         */
+        bool writeWorstFrames(const std::string& filename) const;
+
         /**
          * @brief Get the register write tracker
          * @return Reference to the write tracker
@@ -76,7 +176,24 @@ namespace sidblaster {
         u64 maxCyclesPerFrame_ = 0;    ///< Maximum cycles used in a frame
         int framesExecuted_ = 0;       ///< Number of frames executed
 
+        u16 playAddress_ = 0;          ///< Play routine the frame costs refer to
+
+        std::vector<FrameCost> worstFrames_;      ///< Most expensive frames, descending
+        std::vector<FrameCost> budgetOverruns_;   ///< Frames over the cycle budget
+        std::vector<CPUSnapshot> callSnapshots_;  ///< State at the start of each call in the current frame
+
+        std::vector<SIDWrite> frameWrites_;       ///< SID writes of the frame being streamed
+        bool streamFailed_ = false;               ///< Whether the last frame stream ended on a failed call
+
+        /**
+         * @brief Record the cost of a finished frame
+         * @param cost Frame cost (without snapshot)
+         * @param options Emulation options
+         */
+        void recordFrameCost(FrameCost cost, const EmulationOptions& options);
+
         SIDWriteTracker writeTracker_; ///< Tracks SID register write order
+        std::unique_ptr<RasterProfiler> profiler_; ///< Per-subroutine rastertime profiler (if enabled)
 
     };
 
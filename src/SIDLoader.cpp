@@ -6,6 +6,7 @@
 #include "cpu6510.h"
 #include "SIDLoader.h"
 #include "SIDBlasterUtils.h"
+#include "PipelineStats.h"
 
 #include <algorithm>
 #include <cstring>
@@ -72,6 +73,8 @@ void SIDLoader::setLoadAddress(u16 address) {
  * @return true if loading succeeded, false otherwise
  */
 bool SIDLoader::loadSID(const std::string& filename) {
+    sidblaster::util::StageTimer stage("load");
+
     if (!cpu_) {
         std::cerr << "CPU not set!\n";
         return false;
@@ -100,6 +103,42 @@ bool SIDLoader::loadSID(const std::string& filename) {
         return false;
     }
 
+    return parseSID(buffer, filename);
+}
+
+/**
+ * @brief Load a SID file from memory
+ *
+ * @param data Contents of a SID file
+ * @param name Name used in messages
+ * @return true if loading succeeded, false otherwise
+ */
+bool SIDLoader::loadSIDFromBuffer(std::span<const u8> data, const std::string& name) {
+    sidblaster::util::StageTimer stage("load");
+
+    if (!cpu_) {
+        std::cerr << "CPU not set!\n";
+        return false;
+    }
+
+    if (data.empty()) {
+        std::cerr << "SID data is empty: " << name << "\n";
+        return false;
+    }
+
+    return parseSID(data, name);
+}
+
+/**
+ * @brief Parse SID file contents and load the music data into memory
+ *
+ * @param buffer Contents of a SID file
+ * @param filename Name used in messages
+ * @return true if loading succeeded, false otherwise
+ */
+bool SIDLoader::parseSID(std::span<const u8> buffer, const std::string& filename) {
+    const size_t fileSize = buffer.size();
+
     // Check if file is large enough to contain a header
     if (fileSize < sizeof(SIDHeader)) {
         std::cerr << "SID file too small to contain a valid header!\n";
@@ -163,7 +202,7 @@ bool SIDLoader::loadSID(const std::string& filename) {
 
     // Handle embedded load address if needed
     if (header_.loadAddress == 0) {
-        if (fileSize < header_.dataOffset + 2) {
+        if (fileSize < static_cast<size_t>(header_.dataOffset) + 2) {
             std::cerr << "SID file corrupt (missing embedded load address)!\n";
             return false;
         }
@@ -175,6 +214,10 @@ bool SIDLoader::loadSID(const std::string& filename) {
     }
 
     // Calculate data size
+    if (fileSize <= header_.dataOffset) {
+        std::cerr << "SID file contains no music data!\n";
+        return false;
+    }
     dataSize_ = static_cast<u16>(fileSize - header_.dataOffset);
 
     if (dataSize_ <= 0) {
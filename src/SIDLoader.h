@@ -10,6 +10,7 @@
 
 #include <cstring>
 #include <memory>
+#include <span>
 #include <string>
 #include <string_view>
 #include <vector>
@@ -106,6 +107,16 @@ public:
      */
     bool loadSID(const std::string& filename);
 
+    /**
+     * @brief Load a SID file from memory
+     * @param data Contents of a SID file
+     * @param name Name used in messages (e.g. the original filename)
+     * @return true if loading succeeded, false otherwise
+     *
+     * Same as loadSID, without touching the file system.
+     */
+    bool loadSIDFromBuffer(std::span<const u8> data, const std::string& name = "<memory>");
+
     /**
      * @brief Get the SID file format version
      * @return Version number (1-4)
@@ -197,6 +208,14 @@ public:
     bool restoreMemory();
 
 private:
+    /**
+     * @brief Parse SID file contents and load the music data into memory
+     * @param buffer Contents of a SID file
+     * @param filename Name used in messages
+     * @return true if loading succeeded, false otherwise
+     */
+    bool parseSID(std::span<const u8> buffer, const std::string& filename);
+
     /**
      * @brief Copy music data to CPU memory
      * @param data Pointer to the music data
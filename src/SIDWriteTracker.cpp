@@ -18,9 +18,11 @@ namespace sidblaster {
         // Only track actual SID registers (0x00-0x18)
         if (reg <= 0x18) {
             // Record this register in the current frame sequence if not already there
-            if (std::find(currentFrameSequence_.begin(), currentFrameSequence_.end(), reg)
-                == currentFrameSequence_.end()) {
-                currentFrameSequence_.push_back(reg);
+            const u32 bit = 1u << reg;
+            if (!(currentMask_ & bit)) {
+                currentMask_ |= bit;
+                currentOrder_[currentLength_++] = reg;
+                currentHash_ = (currentHash_ ^ (reg + 1u)) * 0x100000001B3ull;
             }
 
             // Mark this register as used
@@ -32,17 +34,61 @@ namespace sidblaster {
     }
 
     void SIDWriteTracker::endFrame() {
-        // If we have writes in this frame, add to the sequence list
-        if (!currentFrameSequence_.empty()) {
-            frameSequences_.push_back(currentFrameSequence_);
-            currentFrameSequence_.clear();
+        // If we have writes in this frame, count it against its write order
+        if (currentLength_ > 0) {
+            const int sequence = findOrAddSequence();
+            if (sequence >= 0) {
+                sequences_[sequence].frameCount++;
+            }
+            else {
+                untrackedFrames_++;
+            }
+
+            // Frames after the settling period must all match the first frame
+            if (frameCount_ == 0) {
+                firstSequence_ = sequence;
+            }
+            else if (frameCount_ >= SettleFrames && (sequence < 0 || sequence != firstSequence_)) {
+                settledMismatch_ = true;
+            }
+
+            currentMask_ = 0;
+            currentHash_ = 0;
+            currentLength_ = 0;
             frameCount_++;
         }
     }
 
+    int SIDWriteTracker::findOrAddSequence() {
+        for (size_t i = 0; i < sequences_.size(); i++) {
+            const auto& seq = sequences_[i];
+            if (seq.hash == currentHash_ && seq.mask == currentMask_ && seq.length == currentLength_ &&
+                std::equal(seq.order.begin(), seq.order.begin() + seq.length, currentOrder_.begin())) {
+                return static_cast<int>(i);
+            }
+        }
+
+        if (sequences_.size() >= MaxDistinctSequences) {
+            return -1;
+        }
+
+        SequenceStats seq;
+        seq.mask = currentMask_;
+        seq.hash = currentHash_;
+        seq.order = currentOrder_;
+        seq.length = currentLength_;
+        sequences_.push_back(seq);
+        return static_cast<int>(sequences_.size() - 1);
+    }
+
     void SIDWriteTracker::reset() {
-        frameSequences_.clear();
-        currentFrameSequence_.clear();
+        sequences_.clear();
+        untrackedFrames_ = 0;
+        currentMask_ = 0;
+        currentHash_ = 0;
+        currentLength_ = 0;
+        firstSequence_ = -1;
+        settledMismatch_ = false;
         writeOrder_.clear();
         consistentPattern_ = false;
         frameCount_ = 0;
@@ -54,25 +100,19 @@ namespace sidblaster {
 
     bool SIDWriteTracker::analyzePattern() {
         // Need at least a few frames to detect a pattern
-        if (frameSequences_.size() < 10) {
+        if (frameCount_ < SettleFrames) {
             return false;
         }
 
-        // Check if all frames follow the same pattern
-        bool samePattern = true;
-        const auto& firstSeq = frameSequences_[0];
+        const int dominantFrames = getDominantFrameCount();
+        util::Logger::info("SID register write order: " + std::to_string(sequences_.size()) +
+            " distinct order(s), dominant order followed in " + std::to_string(dominantFrames) +
+            " of " + std::to_string(frameCount_) + " frames");
 
-        // Check the pattern from frame 10 onwards (skip initialization frames)
-        for (size_t i = 10; i < frameSequences_.size(); i++) {
-            if (frameSequences_[i] != firstSeq) {
-                samePattern = false;
-                break;
-            }
-        }
-
-        // If all frames after the tenth have the same pattern, we have a consistent order
-        if (samePattern && !firstSeq.empty()) {
-            writeOrder_ = firstSeq;
+        // If all frames after the settling period match the first one, we have a consistent order
+        if (!settledMismatch_ && firstSequence_ >= 0) {
+            const auto& firstSeq = sequences_[firstSequence_];
+            writeOrder_.assign(firstSeq.order.begin(), firstSeq.order.begin() + firstSeq.length);
             consistentPattern_ = true;
             return true;
         }
@@ -95,6 +135,28 @@ namespace sidblaster {
         return false;
     }
 
+    std::vector<u8> SIDWriteTracker::getDominantOrder() const {
+        const SequenceStats* best = nullptr;
+        for (const auto& seq : sequences_) {
+            if (!best || seq.frameCount > best->frameCount) {
+                best = &seq;
+            }
+        }
+
+        if (!best) {
+            return {};
+        }
+        return std::vector<u8>(best->order.begin(), best->order.begin() + best->length);
+    }
+
+    int SIDWriteTracker::getDominantFrameCount() const {
+        int best = 0;
+        for (const auto& seq : sequences_) {
+            best = std::max(best, seq.frameCount);
+        }
+        return best;
+    }
+
     std::string SIDWriteTracker::getWriteOrderString() const {
         std::stringstream ss;
 
@@ -120,7 +182,17 @@ namespace sidblaster {
 
         ss << "SID Register Usage Statistics:\n";
         ss << "-----------------------------\n";
-        ss << "Total frames analyzed: " << frameCount_ << "\n\n";
+        ss << "Total frames analyzed: " << frameCount_ << "\n";
+        ss << "Distinct write orders: " << sequences_.size();
+        if (untrackedFrames_ > 0) {
+            ss << " (+" << untrackedFrames_ << " frames with untracked orders)";
+        }
+        ss << "\n";
+        ss << "Dominant write order:  ";
+        for (u8 reg : getDominantOrder()) {
+            ss << "$" << util::byteToHex(reg) << " ";
+        }
+        ss << "(" << getDominantFrameCount() << " frames)\n\n";
 
         ss << "Register | Used | Write Count | Avg Writes/Frame\n";
         ss << "---------+------+-------------+----------------\n";
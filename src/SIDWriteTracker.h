@@ -34,24 +34,59 @@ namespace sidblaster {
         // Check if we found a consistent pattern
         bool hasConsistentPattern() const { return consistentPattern_; }
 
+        // Get the write order followed by the most frames (empty if no frames were recorded)
+        std::vector<u8> getDominantOrder() const;
+
+        // Get the number of frames that followed the dominant order
+        int getDominantFrameCount() const;
+
+        // Get the number of distinct write orders seen
+        int getDistinctOrderCount() const { return static_cast<int>(sequences_.size()); }
+
         // Get statistics about register usage
         std::string getRegisterUsageStats() const;
 
     private:
-        // Store write sequences per frame
-        std::vector<std::vector<u8>> frameSequences_;
+        static constexpr int NumRegisters = 0x19;
+        static constexpr size_t MaxDistinctSequences = 64;   // Further orders are only counted
+        static constexpr int SettleFrames = 10;               // Frames skipped before checking consistency
+
+        // One distinct per-frame write order and how many frames used it
+        struct SequenceStats {
+            u32 mask = 0;                           // Registers written (bit per register)
+            u64 hash = 0;                           // Rolling hash of the order
+            std::array<u8, NumRegisters> order{};   // First-write order of the registers
+            u8 length = 0;                          // Number of registers in the order
+            int frameCount = 0;                     // Frames that followed this order
+        };
+
+        // Find the current frame's order in the table, adding it if there is room
+        int findOrAddSequence();
+
+        // Distinct write orders, in first-seen order
+        std::vector<SequenceStats> sequences_;
+
+        // Frames whose order did not fit in the table
+        int untrackedFrames_ = 0;
 
         // Current frame's sequence
-        std::vector<u8> currentFrameSequence_;
+        u32 currentMask_ = 0;
+        u64 currentHash_ = 0;
+        std::array<u8, NumRegisters> currentOrder_{};
+        u8 currentLength_ = 0;
+
+        // Table entry used by the first frame, and whether any settled frame differed from it
+        int firstSequence_ = -1;
+        bool settledMismatch_ = false;
 
         // The detected consistent order (if any)
         std::vector<u8> writeOrder_;
 
         // Track which registers are written to
-        std::array<bool, 0x19> registersUsed_ = { false };
+        std::array<bool, NumRegisters> registersUsed_ = { false };
 
         // Count writes to each register
-        std::array<int, 0x19> registerWriteCounts_ = { 0 };
+        std::array<int, NumRegisters> registerWriteCounts_ = { 0 };
 
         // Whether we found a consistent pattern
         bool consistentPattern_ = false;
@@ -60,4 +95,4 @@ namespace sidblaster {
         int frameCount_ = 0;
     };
 
-} // namespace sidblaster
\ No newline at end of file
+} // namespace sidblaster
@@ -41,6 +41,9 @@ namespace sidblaster {
             // Create temp directory if it doesn't exist
             fs::create_directories(options.tempDir);
 
+            // Per-instruction index histograms refine indexed-operand labels
+            cpu_->setIndexHistogramEnabled(util::ConfigManager::getBool("indexHistogram", false));
+
             // Set up tracing if enabled
             if (options.enableTracing && !options.traceLogPath.empty()) {
                 traceLogger_ = std::make_unique<TraceLogger>(options.traceLogPath, options.traceFormat);
@@ -76,12 +79,17 @@ namespace sidblaster {
 
                 // Enable register tracking specifically for player generation
                 emulationOptions.registerTrackingEnabled = true;
+                emulationOptions.cycleBudget = options.cycleBudget;
+                emulationOptions.captureWorstFrameSnapshots = !options.worstFramesPath.empty();
 
                 // Run emulation to analyze SID patterns
                 util::Logger::info("Analyzing SID register write patterns...");
                 if (!emulator.runEmulation(emulationOptions)) {
                     util::Logger::warning("SID pattern analysis failed - continuing without pattern info");
                 }
+                else if (!checkFrameCosts(emulator, options)) {
+                    return false;
+                }
             }
 
             // Determine if we need emulation based on the command type
@@ -224,9 +232,24 @@ namespace sidblaster {
         emulationOptions.frames = options.frames > 0 ?
             options.frames : util::Configuration::getInt("emulationFrames", DEFAULT_SID_EMULATION_FRAMES);
 
+        // -frames also shortens the warm-up; a trace keeps the full warm-up so its frames do not move
+        if (!options.enableTracing) {
+            emulationOptions.warmUpFrames = std::min(emulationOptions.frames, SIDEmulator::WarmUpFrames);
+            // The static pass cannot follow computed jumps, so a short run can miss code
+            if (emulationOptions.frames < DEFAULT_SID_EMULATION_FRAMES) {
+                util::Logger::warning("Analyzing only " + std::to_string(emulationOptions.frames) +
+                    " frames: code the tune reaches later, or only through a computed jump, is written as data", true);
+            }
+        }
+
         emulationOptions.traceEnabled = options.enableTracing;
         emulationOptions.traceFormat = options.traceFormat;
         emulationOptions.traceLogPath = options.traceLogPath;
+        emulationOptions.profilePath = options.profilePath;
+        emulationOptions.heatMapEnabled = !options.heatMapPath.empty() || options.heatMapComments;
+        emulationOptions.heatMapPath = options.heatMapPath;
+        emulationOptions.cycleBudget = options.cycleBudget;
+        emulationOptions.captureWorstFrameSnapshots = !options.worstFramesPath.empty();
 
         // Don't enable register tracking by default
         emulationOptions.registerTrackingEnabled = false;
@@ -237,6 +260,10 @@ namespace sidblaster {
             return false;
         }
 
+        if (!checkFrameCosts(emulator, options)) {
+            return false;
+        }
+
         // Get SID info
         const u16 sidLoad = sid_->getLoadAddress();
         const u16 sidInit = sid_->getInitAddress();
@@ -259,6 +286,48 @@ namespace sidblaster {
         return true;
     }
 
+    bool CommandProcessor::checkFrameCosts(const SIDEmulator& emulator, const ProcessingOptions& options) {
+        const auto& worstFrames = emulator.getWorstFrames();
+        if (!worstFrames.empty()) {
+            const auto& worst = worstFrames.front();
+            util::Logger::info("Most expensive frame: " + std::to_string(worst.frame) +
+                " (" + std::to_string(worst.frameCycles) + " cycles, call " + std::to_string(worst.call) +
+                " used " + std::to_string(worst.callCycles) + ")");
+        }
+
+        if (!options.worstFramesPath.empty() && !emulator.writeWorstFrames(options.worstFramesPath)) {
+            return false;
+        }
+
+        if (options.cycleBudget == 0) {
+            return true;
+        }
+
+        const auto& overruns = emulator.getBudgetOverruns();
+        if (overruns.empty()) {
+            util::Logger::info("All frames within cycle budget of " + std::to_string(options.cycleBudget));
+            return true;
+        }
+
+        // Only the first few go to the console; the report lists them all
+        constexpr size_t MaxListed = 32;
+        for (size_t i = 0; i < std::min(overruns.size(), MaxListed); ++i) {
+            const auto& cost = overruns[i];
+            util::Logger::error("Frame " + std::to_string(cost.frame) + " used " +
+                std::to_string(cost.frameCycles) + " cycles (budget " + std::to_string(options.cycleBudget) +
+                ", most expensive call " + std::to_string(cost.call) + " used " + std::to_string(cost.callCycles) + ")");
+        }
+        if (overruns.size() > MaxListed) {
+            util::Logger::error("... and " + std::to_string(overruns.size() - MaxListed) + " more" +
+                (options.worstFramesPath.empty() ? " (use -worstframes to list them all)" : ""));
+        }
+
+        util::Logger::error(std::to_string(overruns.size()) + " frame(s) exceeded the cycle budget of " +
+            std::to_string(options.cycleBudget) + " cycles (worst: " +
+            std::to_string(worstFrames.empty() ? 0 : worstFrames.front().frameCycles) + ")");
+        return false;
+    }
+
     int CommandProcessor::calculatePlayCallsPerFrame(u8 CIATimerLo, u8 CIATimerHi) {
         const uint32_t speedBits = sid_->getHeader().speed;
         int count = 0;
@@ -566,6 +635,7 @@ namespace sidblaster {
         const u16 newSidInit = outputSidLoad + (sid_->getInitAddress() - sidLoad);
         const u16 newSidPlay = outputSidLoad + (sid_->getPlayAddress() - sidLoad);
 
+        disassembler_->setExecutionCountComments(options.heatMapComments);
         int unusedBytes = disassembler_->generateAsmFile(
             options.outputFile.string(), outputSidLoad, newSidInit, newSidPlay);
 
@@ -17,6 +17,8 @@ class SIDLoader;
 
 namespace sidblaster {
 
+    class SIDEmulator;
+
     /**
      * @class CommandProcessor
      * @brief Main processor for SID file operations
@@ -66,6 +68,13 @@ namespace sidblaster {
             TraceFormat traceFormat = TraceFormat::Binary;  ///< Trace format
             int frames = DEFAULT_SID_EMULATION_FRAMES;    ///< Number of frames to emulate
 
+            // Profiling options
+            std::string profilePath;               ///< Rastertime profile report path (empty = disabled)
+            std::string heatMapPath;               ///< Heat map export path (empty = no export)
+            bool heatMapComments = false;          ///< Whether to add execution counts to disassembly
+            u64 cycleBudget = 0;                   ///< Maximum cycles per frame (0 = no budget)
+            std::string worstFramesPath;           ///< Worst frame report path (empty = no report)
+
             bool analyzeRegisterOrder = false;   ///< Whether to analyze SID register write order
         };
 
@@ -86,6 +95,12 @@ namespace sidblaster {
          */
         bool processFile(const ProcessingOptions& options);
 
+        /**
+         * @brief Get the CPU of the last processed file
+         * @return CPU, holding the memory access flags of the analysis
+         */
+        const CPU6510& getCPU() const { return *cpu_; }
+
     private:
         std::unique_ptr<CPU6510> cpu_;             ///< CPU instance
         std::unique_ptr<SIDLoader> sid_;           ///< SID loader instance
@@ -114,6 +129,14 @@ namespace sidblaster {
          */
         bool analyzeMusic(const ProcessingOptions& options);
 
+        /**
+         * @brief Report the most expensive frames and check them against the cycle budget
+         * @param emulator Emulator that has finished running
+         * @param options Processing options
+         * @return True if no frame exceeded the budget and the worst frame report (if any) was written
+         */
+        bool checkFrameCosts(const SIDEmulator& emulator, const ProcessingOptions& options);
+
         /**
          * @brief Generate output file
          * @param options Processing options
@@ -0,0 +1,112 @@
+// FileWatcher.cpp
+#include "FileWatcher.h"
+#include "../SIDBlasterUtils.h"
+
+#include <thread>
+
+#ifdef __linux__
+#include <cerrno>
+#include <climits>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace sidblaster {
+
+    FileWatcher::FileWatcher(fs::path file)
+        : file_(std::move(file)) {
+
+        updateStamp();
+
+#ifdef __linux__
+        // Watch the directory: saves often replace the file rather than rewrite it
+        const fs::path dir = file_.has_parent_path() ? file_.parent_path() : fs::path(".");
+        inotifyFd_ = inotify_init1(IN_CLOEXEC);
+        if (inotifyFd_ >= 0 &&
+            inotify_add_watch(inotifyFd_, dir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0) {
+            close(inotifyFd_);
+            inotifyFd_ = -1;
+        }
+        if (inotifyFd_ < 0) {
+            util::Logger::warning("inotify not available for " + dir.string() + ", polling instead");
+        }
+#endif
+    }
+
+    FileWatcher::~FileWatcher() {
+#ifdef __linux__
+        if (inotifyFd_ >= 0) {
+            close(inotifyFd_);
+        }
+#endif
+    }
+
+    bool FileWatcher::updateStamp() {
+        std::error_code ec;
+        const auto writeTime = fs::last_write_time(file_, ec);
+        if (ec) {
+            return false;   // Missing while being replaced; look again later
+        }
+        const auto size = fs::file_size(file_, ec);
+        if (ec) {
+            return false;
+        }
+
+        const bool changed = writeTime != lastWriteTime_ || size != lastSize_;
+        lastWriteTime_ = writeTime;
+        lastSize_ = size;
+        return changed;
+    }
+
+    bool FileWatcher::waitForChange() {
+#ifdef __linux__
+        if (inotifyFd_ >= 0) {
+            const std::string name = file_.filename().string();
+            alignas(inotify_event) char buffer[sizeof(inotify_event) + NAME_MAX + 1];
+
+            bool seen = false;
+            for (;;) {
+                // Block for the first event, then collect the rest of the burst
+                pollfd pfd{ inotifyFd_, POLLIN, 0 };
+                const int ready = poll(&pfd, 1, seen ? static_cast<int>(SettleTime.count()) : -1);
+                if (ready < 0) {
+                    if (errno == EINTR) {
+                        continue;
+                    }
+                    return false;
+                }
+                if (ready == 0) {
+                    updateStamp();
+                    return true;
+                }
+
+                const ssize_t length = read(inotifyFd_, buffer, sizeof(buffer));
+                if (length <= 0) {
+                    if (length < 0 && errno == EINTR) {
+                        continue;
+                    }
+                    return false;
+                }
+                for (ssize_t offset = 0; offset < length;) {
+                    const auto* event = reinterpret_cast<const inotify_event*>(buffer + offset);
+                    if (event->len > 0 && name == event->name) {
+                        seen = true;
+                    }
+                    offset += sizeof(inotify_event) + event->len;
+                }
+            }
+        }
+#endif
+
+        // Poll until the stamp moves, then until it holds still
+        while (!updateStamp()) {
+            std::this_thread::sleep_for(PollInterval);
+        }
+        do {
+            std::this_thread::sleep_for(SettleTime);
+        } while (updateStamp());
+        return true;
+    }
+
+} // namespace sidblaster
@@ -0,0 +1,62 @@
+// FileWatcher.h
+#pragma once
+
+#include "../Common.h"
+
+#include <chrono>
+#include <filesystem>
+
+namespace fs = std::filesystem;
+
+namespace sidblaster {
+
+    /**
+     * @class FileWatcher
+     * @brief Waits for a file to be saved again
+     *
+     * On Linux the file's directory is watched with inotify, so both writes in
+     * place and the write-then-rename saves most editors and trackers do are
+     * seen as soon as the file is closed. Elsewhere the file's modification
+     * time and size are polled.
+     */
+    class FileWatcher {
+    public:
+        /**
+         * @brief Constructor
+         * @param file File to watch (it may be missing for a while during a save)
+         */
+        explicit FileWatcher(fs::path file);
+
+        /**
+         * @brief Destructor
+         */
+        ~FileWatcher();
+
+        FileWatcher(const FileWatcher&) = delete;
+        FileWatcher& operator=(const FileWatcher&) = delete;
+
+        /**
+         * @brief Block until the file has been saved
+         * @return False if the file can no longer be watched
+         *
+         * Saves that follow each other within the settle time are reported once.
+         */
+        bool waitForChange();
+
+        static constexpr std::chrono::milliseconds SettleTime{ 50 };     ///< Quiet time that ends a burst of saves
+        static constexpr std::chrono::milliseconds PollInterval{ 200 };  ///< Polling period without inotify
+
+    private:
+        fs::path file_;                       ///< Watched file
+        int inotifyFd_ = -1;                  ///< inotify instance (-1 when polling)
+        fs::file_time_type lastWriteTime_{};  ///< Modification time when last seen (polling)
+        std::uintmax_t lastSize_ = 0;         ///< Size when last seen (polling)
+
+        /**
+         * @brief Record the file's current modification time and size
+         * @return True if they differ from the previous ones
+         */
+        bool updateStamp();
+    };
+
+} // namespace sidblaster
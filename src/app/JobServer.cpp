@@ -0,0 +1,543 @@
+// JobServer.cpp
+#include "JobServer.h"
+#include "../CommandLineParser.h"
+#include "../SIDBlasterUtils.h"
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <set>
+#include <sstream>
+#include <string_view>
+#include <utility>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace sidblaster {
+
+    namespace {
+
+        /**
+         * @brief A scalar JSON value (jobs are flat objects)
+         */
+        struct JsonValue {
+            enum class Kind { String, Number, True, False, Null };
+
+            Kind kind = Kind::Null;
+            std::string text;           // Decoded string, or the number as written
+        };
+
+        /**
+         * @brief Reads one flat JSON object
+         */
+        class JsonObjectReader {
+        public:
+            explicit JsonObjectReader(const std::string& text) : text_(text) {}
+
+            /**
+             * @brief Parse the object into its members, in order
+             * @return True if the text is a flat JSON object
+             */
+            bool read(std::vector<std::pair<std::string, JsonValue>>& members, std::string& error) {
+                if (!expect('{')) {
+                    error = "Job must be a JSON object";
+                    return false;
+                }
+                if (!expect('}')) {
+                    do {
+                        std::string key;
+                        JsonValue value;
+                        if (!readString(key) || !expect(':')) {
+                            error = "Malformed member at offset " + std::to_string(pos_);
+                            return false;
+                        }
+                        if (!readValue(value)) {
+                            error = "Unsupported value for \"" + key + "\" (only strings, numbers, true, false and null)";
+                            return false;
+                        }
+                        members.emplace_back(std::move(key), std::move(value));
+                    } while (expect(','));
+
+                    if (!expect('}')) {
+                        error = "Expected '}' at offset " + std::to_string(pos_);
+                        return false;
+                    }
+                }
+                skipSpace();
+                if (pos_ != text_.size()) {
+                    error = "Unexpected text after the job object";
+                    return false;
+                }
+                return true;
+            }
+
+        private:
+            const std::string& text_;
+            size_t pos_ = 0;
+
+            void skipSpace() {
+                while (pos_ < text_.size() && std::isspace(static_cast<unsigned char>(text_[pos_]))) {
+                    ++pos_;
+                }
+            }
+
+            bool expect(char c) {
+                skipSpace();
+                if (pos_ < text_.size() && text_[pos_] == c) {
+                    ++pos_;
+                    return true;
+                }
+                return false;
+            }
+
+            bool readLiteral(const char* literal) {
+                const std::string_view word(literal);
+                if (text_.compare(pos_, word.size(), word) != 0) {
+                    return false;
+                }
+                pos_ += word.size();
+                return true;
+            }
+
+            static void appendUtf8(std::string& out, u32 code) {
+                if (code < 0x80) {
+                    out += static_cast<char>(code);
+                }
+                else if (code < 0x800) {
+                    out += static_cast<char>(0xC0 | (code >> 6));
+                    out += static_cast<char>(0x80 | (code & 0x3F));
+                }
+                else if (code < 0x10000) {
+                    out += static_cast<char>(0xE0 | (code >> 12));
+                    out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+                    out += static_cast<char>(0x80 | (code & 0x3F));
+                }
+                else {
+                    out += static_cast<char>(0xF0 | (code >> 18));
+                    out += static_cast<char>(0x80 | ((code >> 12) & 0x3F));
+                    out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+                    out += static_cast<char>(0x80 | (code & 0x3F));
+                }
+            }
+
+            bool readHex4(u32& code) {
+                if (pos_ + 4 > text_.size()) {
+                    return false;
+                }
+                code = 0;
+                for (int i = 0; i < 4; ++i) {
+                    const char c = text_[pos_++];
+                    code <<= 4;
+                    if (c >= '0' && c <= '9') code |= c - '0';
+                    else if (c >= 'a' && c <= 'f') code |= c - 'a' + 10;
+                    else if (c >= 'A' && c <= 'F') code |= c - 'A' + 10;
+                    else return false;
+                }
+                return true;
+            }
+
+            bool readString(std::string& out) {
+                if (!expect('"')) {
+                    return false;
+                }
+                while (pos_ < text_.size()) {
+                    const char c = text_[pos_++];
+                    if (c == '"') {
+                        return true;
+                    }
+                    if (static_cast<unsigned char>(c) < 0x20) {
+                        return false;
+                    }
+                    if (c != '\\') {
+                        out += c;
+                        continue;
+                    }
+                    if (pos_ >= text_.size()) {
+                        return false;
+                    }
+                    switch (text_[pos_++]) {
+                    case '"':  out += '"'; break;
+                    case '\\': out += '\\'; break;
+                    case '/':  out += '/'; break;
+                    case 'b':  out += '\b'; break;
+                    case 'f':  out += '\f'; break;
+                    case 'n':  out += '\n'; break;
+                    case 'r':  out += '\r'; break;
+                    case 't':  out += '\t'; break;
+                    case 'u': {
+                        u32 code = 0;
+                        if (!readHex4(code)) {
+                            return false;
+                        }
+                        // Surrogate pair
+                        if (code >= 0xD800 && code < 0xDC00) {
+                            u32 low = 0;
+                            if (!readLiteral("\\u") || !readHex4(low) || low < 0xDC00 || low >= 0xE000) {
+                                return false;
+                            }
+                            code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+                        }
+                        appendUtf8(out, code);
+                        break;
+                    }
+                    default:
+                        return false;
+                    }
+                }
+                return false;
+            }
+
+            bool readNumber(std::string& out) {
+                const size_t start = pos_;
+                if (pos_ < text_.size() && text_[pos_] == '-') {
+                    ++pos_;
+                }
+                while (pos_ < text_.size() &&
+                    (std::isdigit(static_cast<unsigned char>(text_[pos_])) ||
+                        (text_[pos_] != '\0' && std::strchr(".eE+-", text_[pos_])))) {
+                    ++pos_;
+                }
+                out = text_.substr(start, pos_ - start);
+                return !out.empty() && out != "-";
+            }
+
+            bool readValue(JsonValue& value) {
+                skipSpace();
+                if (pos_ >= text_.size()) {
+                    return false;
+                }
+                const char c = text_[pos_];
+                if (c == '"') {
+                    value.kind = JsonValue::Kind::String;
+                    return readString(value.text);
+                }
+                if (c == '-' || std::isdigit(static_cast<unsigned char>(c))) {
+                    value.kind = JsonValue::Kind::Number;
+                    return readNumber(value.text);
+                }
+                if (readLiteral("true")) {
+                    value.kind = JsonValue::Kind::True;
+                    return true;
+                }
+                if (readLiteral("false")) {
+                    value.kind = JsonValue::Kind::False;
+                    return true;
+                }
+                if (readLiteral("null")) {
+                    value.kind = JsonValue::Kind::Null;
+                    return true;
+                }
+                return false;
+            }
+        };
+
+        /**
+         * @brief Escape a string for inclusion in JSON
+         */
+        std::string jsonString(const std::string& text) {
+            std::string escaped = "\"";
+            for (char c : text) {
+                switch (c) {
+                case '"':  escaped += "\\\""; break;
+                case '\\': escaped += "\\\\"; break;
+                case '\n': escaped += "\\n"; break;
+                case '\r': escaped += "\\r"; break;
+                case '\t': escaped += "\\t"; break;
+                default:
+                    if (static_cast<unsigned char>(c) < 0x20) {
+                        std::ostringstream code;
+                        code << "\\u" << std::hex << std::setw(4) << std::setfill('0') << static_cast<int>(c);
+                        escaped += code.str();
+                    }
+                    else {
+                        escaped += c;
+                    }
+                }
+            }
+            return escaped + "\"";
+        }
+
+#ifdef _WIN32
+        int duplicateFd(int fd) { return _dup(fd); }
+        int redirectFd(int from, int to) { return _dup2(from, to); }
+        int closeFd(int fd) { return _close(fd); }
+#else
+        int duplicateFd(int fd) { return dup(fd); }
+        int redirectFd(int from, int to) { return dup2(from, to); }
+        int closeFd(int fd) { return close(fd); }
+#endif
+
+        /**
+         * @brief Points std::cout at a buffer for the lifetime of the object
+         *
+         * Tools run through std::system (KickAss, Exomizer) write to file
+         * descriptor 1 directly, so that is sent to stderr until released.
+         */
+        class CoutCapture {
+        public:
+            CoutCapture() : previous_(std::cout.rdbuf(captured_.rdbuf())) {
+                std::fflush(stdout);
+                savedStdout_ = duplicateFd(1);
+                if (savedStdout_ >= 0 && redirectFd(2, 1) < 0) {
+                    closeFd(savedStdout_);
+                    savedStdout_ = -1;
+                }
+            }
+            ~CoutCapture() { release(); }
+
+            CoutCapture(const CoutCapture&) = delete;
+            CoutCapture& operator=(const CoutCapture&) = delete;
+
+            /**
+             * @brief Restore std::cout and stdout, and return what was written to std::cout
+             */
+            std::string release() {
+                if (previous_) {
+                    std::cout.flush();
+                    std::cout.rdbuf(previous_);
+                    previous_ = nullptr;
+                }
+                if (savedStdout_ >= 0) {
+                    std::fflush(stdout);
+                    redirectFd(savedStdout_, 1);
+                    closeFd(savedStdout_);
+                    savedStdout_ = -1;
+                }
+                return captured_.str();
+            }
+
+        private:
+            std::ostringstream captured_;
+            std::streambuf* previous_;
+            int savedStdout_ = -1;      // Duplicate of the real stdout while it points at stderr
+        };
+
+        // Options that configure the whole server rather than one job
+        const std::set<std::string> ServerOptions = {
+            "log", "logfile", "verbose", "stats", "timeline", "serve", "watch", "help", "h"
+        };
+
+        // Commands and the key holding each command's own value ("" if it has none)
+        const std::vector<std::pair<std::string, std::string>> JobCommands = {
+            { "relocate", "address" },
+            { "disassemble", "" },
+            { "trace", "tracelog" },
+            { "player", "player" },
+        };
+
+    } // namespace
+
+    JobServer::JobServer(std::string programName, Executor execute)
+        : programName_(std::move(programName)),
+        execute_(std::move(execute)) {
+    }
+
+    bool JobServer::parseJob(const std::string& line, std::string& id,
+        std::vector<std::string>& args, std::string& error) {
+
+        id = "null";
+        args.clear();
+
+        std::vector<std::pair<std::string, JsonValue>> members;
+        if (!JsonObjectReader(line).read(members, error)) {
+            return false;
+        }
+
+        // Echo the id as written, whatever the outcome
+        for (const auto& [key, value] : members) {
+            if (key == "id") {
+                if (value.kind == JsonValue::Kind::String) {
+                    id = jsonString(value.text);
+                }
+                else if (value.kind == JsonValue::Kind::Number) {
+                    id = value.text;
+                }
+            }
+        }
+
+        std::set<std::string> seen;
+        for (const auto& member : members) {
+            if (!seen.insert(member.first).second) {
+                error = "Duplicate key \"" + member.first + "\"";
+                return false;
+            }
+        }
+
+        const auto find = [&members](const std::string& key) -> const JsonValue* {
+            const auto it = std::find_if(members.begin(), members.end(),
+                [&key](const auto& member) { return member.first == key; });
+            return it != members.end() ? &it->second : nullptr;
+        };
+
+        const JsonValue* command = find("command");
+        if (!command || command->kind != JsonValue::Kind::String) {
+            error = "Job needs a \"command\" string";
+            return false;
+        }
+        if (command->text == "quit") {
+            return true;
+        }
+
+        const auto jobCommand = std::find_if(JobCommands.begin(), JobCommands.end(),
+            [command](const auto& entry) { return entry.first == command->text; });
+        if (jobCommand == JobCommands.end()) {
+            error = "Unknown command \"" + command->text + "\" (expected relocate, disassemble, trace, player or quit)";
+            return false;
+        }
+        const std::string& valueKey = jobCommand->second;
+
+        // The command itself, with its value if it has one
+        std::string commandArg = "-" + command->text;
+        if (const JsonValue* value = valueKey.empty() ? nullptr : find(valueKey)) {
+            if (value->kind != JsonValue::Kind::String && value->kind != JsonValue::Kind::Number) {
+                error = "\"" + valueKey + "\" must be a string or number";
+                return false;
+            }
+            commandArg += "=" + value->text;
+        }
+        else if (command->text == "relocate") {
+            error = "relocate needs an \"address\"";
+            return false;
+        }
+        args.push_back(commandArg);
+
+        // Everything else is an option
+        for (const auto& [key, value] : members) {
+            if (key == "id" || key == "command" || key == "input" || key == "output" || key == valueKey) {
+                continue;
+            }
+            if (ServerOptions.count(key) != 0) {
+                error = "\"" + key + "\" applies to the whole server and cannot be set per job";
+                return false;
+            }
+            if (std::any_of(JobCommands.begin(), JobCommands.end(),
+                [&key](const auto& entry) { return entry.first == key; })) {
+                error = "\"" + key + "\" is a command; a job runs only its \"command\"";
+                return false;
+            }
+
+            switch (value.kind) {
+            case JsonValue::Kind::True:
+                args.push_back("-" + key);
+                break;
+            case JsonValue::Kind::False:
+                break;
+            case JsonValue::Kind::String:
+            case JsonValue::Kind::Number:
+                args.push_back("-" + key + "=" + value.text);
+                break;
+            case JsonValue::Kind::Null:
+                error = "\"" + key + "\" is null";
+                return false;
+            }
+        }
+
+        // Then the files, in command line order
+        const JsonValue* input = find("input");
+        const JsonValue* output = find("output");
+        for (const JsonValue* file : { input, output }) {
+            if (!file) {
+                continue;
+            }
+            if (file->kind != JsonValue::Kind::String || file->text.empty() || file->text[0] == '-') {
+                error = "\"input\" and \"output\" must be file names";
+                return false;
+            }
+        }
+        if (output && !input) {
+            error = "Job has an \"output\" but no \"input\"";
+            return false;
+        }
+        if (input) {
+            args.push_back(input->text);
+        }
+        if (output) {
+            args.push_back(output->text);
+        }
+        return true;
+    }
+
+    bool JobServer::runJob(const std::string& line, std::ostream& out, bool& quit) {
+        const auto start = std::chrono::steady_clock::now();
+
+        std::string id;
+        std::vector<std::string> args;
+        std::string error;
+        std::string commandName;
+        std::string output;
+        int exitCode = 1;
+
+        if (parseJob(line, id, args, error)) {
+            if (args.empty()) {
+                quit = true;
+                exitCode = 0;
+                commandName = "quit";
+            }
+            else {
+                commandName = args.front().substr(1, args.front().find('=') - 1);
+                const CommandClass command = CommandLineParser(programName_, args).parse();
+
+                // Anything the command prints goes into the result, not the result stream
+                CoutCapture capture;
+                try {
+                    exitCode = execute_(command);
+                }
+                catch (const std::exception& e) {
+                    error = e.what();
+                    exitCode = 1;
+                }
+                output = capture.release();
+            }
+        }
+
+        const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        std::ostringstream result;
+        result << "{\"id\":" << id
+            << ",\"command\":" << (commandName.empty() ? std::string("null") : jsonString(commandName))
+            << ",\"ok\":" << (exitCode == 0 ? "true" : "false")
+            << ",\"exitCode\":" << exitCode
+            << ",\"ms\":" << std::fixed << std::setprecision(3) << ms;
+        if (!output.empty()) {
+            result << ",\"output\":" << jsonString(output);
+        }
+        if (!error.empty()) {
+            result << ",\"error\":" << jsonString(error);
+        }
+        result << "}";
+
+        out << result.str() << "\n";
+        out.flush();
+
+        util::Logger::info("Job " + id + " (" + (commandName.empty() ? "invalid" : commandName) +
+            ") finished with exit code " + std::to_string(exitCode));
+        return exitCode == 0;
+    }
+
+    int JobServer::run(std::istream& in, std::ostream& out) {
+        int failures = 0;
+        bool quit = false;
+        std::string line;
+        while (!quit && std::getline(in, line)) {
+            if (!line.empty() && line.back() == '\r') {
+                line.pop_back();
+            }
+            if (line.find_first_not_of(" \t") == std::string::npos) {
+                continue;
+            }
+            if (!runJob(line, out, quit)) {
+                ++failures;
+            }
+        }
+        return failures;
+    }
+
+} // namespace sidblaster
@@ -0,0 +1,79 @@
+// JobServer.h
+#pragma once
+
+#include "../CommandClass.h"
+
+#include <functional>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+namespace sidblaster {
+
+    /**
+     * @class JobServer
+     * @brief Runs newline-delimited JSON jobs from a stream (the -serve mode)
+     *
+     * Each input line is one flat JSON object describing a command, e.g.
+     *
+     *   {"id": 1, "command": "relocate", "address": "$2000", "input": "a.sid", "output": "b.sid"}
+     *
+     * "command" is relocate, disassemble, trace or player. "input" and "output"
+     * are the file arguments, and the command's own value goes in "address"
+     * (relocate), "player" (player) or "tracelog" (trace). Every other key is a
+     * command line option: true gives -key, false leaves it out and strings or
+     * numbers give -key=value. Options that configure the whole process (log,
+     * verbose, stats, timeline) are rejected.
+     *
+     * Jobs run one at a time in the order received. Each produces one JSON line
+     * with the echoed id, the exit code, the time taken and anything the job
+     * printed to stdout. The server stops at end of input or on {"command": "quit"}.
+     */
+    class JobServer {
+    public:
+        /**
+         * @brief Runs a parsed command and returns its exit code
+         */
+        using Executor = std::function<int(const CommandClass&)>;
+
+        /**
+         * @brief Constructor
+         * @param programName Program name, as passed to CommandLineParser
+         * @param execute Runs a command (the same path as the command line)
+         */
+        JobServer(std::string programName, Executor execute);
+
+        /**
+         * @brief Process jobs until the input ends or a quit job arrives
+         * @param in Job stream
+         * @param out Result stream
+         * @return Number of jobs that failed
+         */
+        int run(std::istream& in, std::ostream& out);
+
+        /**
+         * @brief Translate a job line into command line arguments
+         * @param line JSON object
+         * @param id Receives the job's id as JSON text ("null" if none)
+         * @param args Receives the arguments (empty for a quit job)
+         * @param error Receives the reason on failure
+         * @return True if the job is valid
+         */
+        static bool parseJob(const std::string& line, std::string& id,
+            std::vector<std::string>& args, std::string& error);
+
+    private:
+        std::string programName_;     ///< Program name for the argument parser
+        Executor execute_;            ///< Command runner
+
+        /**
+         * @brief Run one job line and write its result line
+         * @param line JSON object
+         * @param out Result stream
+         * @param quit Set when the job asks the server to stop
+         * @return True if the job succeeded
+         */
+        bool runJob(const std::string& line, std::ostream& out, bool& quit);
+    };
+
+} // namespace sidblaster
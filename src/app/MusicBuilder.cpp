@@ -6,6 +6,7 @@
 #include "MusicBuilder.h"
 #include "../SIDBlasterUtils.h"
 #include "../ConfigManager.h"
+#include "../PipelineStats.h"
 #include "../cpu6510.h"
 #include "../SIDLoader.h"
 
@@ -78,7 +79,7 @@ namespace sidblaster {
 
                 // Configure emulation options
                 SIDEmulator::EmulationOptions options;
-                options.frames = 100; // Just need a short run to identify key patterns
+                options.frames = HelpfulDataFrames; // Just need a short run to identify key patterns
                 options.registerTrackingEnabled = true; // Track register write order
 
                 // Run the emulation
@@ -101,35 +102,7 @@ namespace sidblaster {
                 return false;
             }
 
-            // Apply compression if requested
-            if (options.compress) {
-                if (!compressPrg(tempPlayerPrgFile, outputFile, options.playerAddress, options)) {
-                    // Fallback to uncompressed if compression fails
-                    util::Logger::warning(std::string("Compression failed on ") + tempPlayerPrgFile.string());
-                    try {
-                        fs::copy_file(tempPlayerPrgFile, outputFile,
-                            fs::copy_options::overwrite_existing);
-                        return true;
-                    }
-                    catch (const std::exception& e) {
-                        util::Logger::error(std::string("Failed to copy uncompressed PRG: ") + e.what());
-                        return false;
-                    }
-                }
-                return true;
-            }
-            else {
-                // Copy uncompressed file to output
-                try {
-                    fs::copy_file(tempPlayerPrgFile, outputFile,
-                        fs::copy_options::overwrite_existing);
-                    return true;
-                }
-                catch (const std::exception& e) {
-                    util::Logger::error(std::string("Failed to copy uncompressed PRG: ") + e.what());
-                    return false;
-                }
-            }
+            return writeOutput(tempPlayerPrgFile, outputFile, options);
         }
         else {
             // Pure music without player
@@ -340,6 +313,11 @@ namespace sidblaster {
             sourceFile.string() + " -o " +
             outputFile.string();
 
+        util::StageTimer stage("assemble");
+        stage.setCategory("tool");
+        stage.setDetail(kickCommand);
+        stage.addOutputFile(outputFile);
+
         util::Logger::debug("Assembling: " + kickCommand);
         const int result = std::system(kickCommand.c_str());
 
@@ -352,6 +330,42 @@ namespace sidblaster {
         return true;
     }
 
+    bool MusicBuilder::writeOutput(
+        const fs::path& linkedPrg,
+        const fs::path& outputFile,
+        const BuildOptions& options) {
+
+        // Apply compression if requested
+        if (options.compress) {
+            if (!compressPrg(linkedPrg, outputFile, options.playerAddress, options)) {
+                // Fallback to uncompressed if compression fails
+                util::Logger::warning(std::string("Compression failed on ") + linkedPrg.string());
+                try {
+                    fs::copy_file(linkedPrg, outputFile,
+                        fs::copy_options::overwrite_existing);
+                    return true;
+                }
+                catch (const std::exception& e) {
+                    util::Logger::error(std::string("Failed to copy uncompressed PRG: ") + e.what());
+                    return false;
+                }
+            }
+            return true;
+        }
+        else {
+            // Copy uncompressed file to output
+            try {
+                fs::copy_file(linkedPrg, outputFile,
+                    fs::copy_options::overwrite_existing);
+                return true;
+            }
+            catch (const std::exception& e) {
+                util::Logger::error(std::string("Failed to copy uncompressed PRG: ") + e.what());
+                return false;
+            }
+        }
+    }
+
     bool MusicBuilder::compressPrg(
         const fs::path& inputPrg,
         const fs::path& outputPrg,
@@ -382,6 +396,11 @@ namespace sidblaster {
         }
 
         // Execute the compression command
+        util::StageTimer stage("compress");
+        stage.setCategory("tool");
+        stage.setDetail(compressCommand);
+        stage.addOutputFile(outputPrg);
+
         util::Logger::debug("Compressing with command: " + compressCommand);
         const int result = std::system(compressCommand.c_str());
 
@@ -395,6 +414,9 @@ namespace sidblaster {
     }
 
     bool MusicBuilder::extractPrgFromSid(const fs::path& sidFile, const fs::path& outputPrg) {
+        util::StageTimer stage("extract PRG");
+        stage.addOutputFile(outputPrg);
+
         // Read the SID file
         std::ifstream input(sidFile, std::ios::binary);
         if (!input) {
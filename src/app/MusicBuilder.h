@@ -52,6 +52,8 @@ namespace sidblaster {
             fs::path tempDir = "temp";     ///< Temporary directory
         };
 
+        static constexpr int HelpfulDataFrames = 100;   ///< Frames analyzed for the helpful data file
+
         /**
          * @brief Constructor
          * @param cpu Pointer to CPU6510 instance
@@ -83,6 +85,18 @@ namespace sidblaster {
             const fs::path& sidFile,
             const fs::path& outputPrg);
 
+        /**
+         * @brief Write a linked player PRG to the output file
+         * @param linkedPrg Uncompressed PRG built by the assembler
+         * @param outputFile Output file path
+         * @param options Build options (compression settings)
+         * @return True if the output was written
+         */
+        static bool writeOutput(
+            const fs::path& linkedPrg,
+            const fs::path& outputFile,
+            const BuildOptions& options);
+
     private:
         const CPU6510* cpu_;  ///< Pointer to CPU
         const SIDLoader* sid_;  ///< Pointer to SID loader
@@ -134,7 +148,7 @@ namespace sidblaster {
          * @param options Build options
          * @return True if compression was successful
          */
-        bool compressPrg(
+        static bool compressPrg(
             const fs::path& inputPrg,
             const fs::path& outputPrg,
             u16 loadAddress,
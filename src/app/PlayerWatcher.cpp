@@ -0,0 +1,294 @@
+// PlayerWatcher.cpp
+#include "PlayerWatcher.h"
+#include "FileWatcher.h"
+#include "MusicBuilder.h"
+#include "../cpu6510.h"
+#include "../SIDBlasterUtils.h"
+#include "../SIDEmulator.h"
+#include "../SIDLoader.h"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+
+namespace sidblaster {
+
+    namespace {
+
+        /**
+         * @brief Read a whole file
+         * @param path File to read
+         * @param data Receives the contents
+         * @return True if the file could be read
+         */
+        bool readFile(const fs::path& path, std::vector<u8>& data) {
+            std::ifstream file(path, std::ios::binary);
+            if (!file) {
+                return false;
+            }
+            data.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+            return !file.bad();
+        }
+
+        /**
+         * @brief Write a whole file
+         * @param path File to write
+         * @param data Contents
+         * @return True if the file was written
+         */
+        bool writeFile(const fs::path& path, const std::vector<u8>& data) {
+            std::ofstream file(path, std::ios::binary | std::ios::trunc);
+            file.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+            return static_cast<bool>(file);
+        }
+
+        bool isExecuted(u8 flags) {
+            return (flags & static_cast<u8>(MemoryAccessFlag::Execute)) != 0;
+        }
+
+    } // anonymous namespace
+
+    PlayerWatcher::PlayerWatcher(CommandProcessor::ProcessingOptions options)
+        : options_(std::move(options)),
+        linkedPrgFile_(options_.tempDir / (options_.inputFile.stem().string() + "-player.prg")) {
+    }
+
+    int PlayerWatcher::run() {
+        FileWatcher watcher(options_.inputFile);
+
+        std::vector<u8> file;
+        if (!readFile(options_.inputFile, file)) {
+            util::Logger::error("Cannot read " + options_.inputFile.string());
+            return 1;
+        }
+        if (fullBuild(file)) {
+            std::cout << "Built " << options_.outputFile.string() << std::endl;
+        }
+        else {
+            util::Logger::error("Build failed, waiting for the next save");
+        }
+        std::cout << "Watching " << options_.inputFile.string() << " (Ctrl+C to stop)" << std::endl;
+
+        while (watcher.waitForChange()) {
+            if (!readFile(options_.inputFile, file)) {
+                continue;   // Replaced again before we could read it; the next event follows
+            }
+            if (haveCache_ && file == built_.file) {
+                continue;
+            }
+
+            const auto start = std::chrono::steady_clock::now();
+            std::string kind = "full rebuild";
+
+            bool relinked = false;
+            if (haveCache_) {
+                CPU6510 cpu;
+                SIDLoader sid;
+                TuneImage current;
+                if (loadImage(file, cpu, sid, current) &&
+                    classifyChange(built_, current, memoryAccess_) == Change::DataOnly &&
+                    staysInAnalyzedCode(cpu, sid, memoryAccess_, CoverageFrames) &&
+                    writesOnlyAnalyzedMemory(cpu, memoryAccess_) &&
+                    registerWriteOrder(file) == registerOrder_) {
+                    relinked = relink(current);
+                    kind = "music data only, new code checked for " + std::to_string(CoverageFrames) + " frames";
+                }
+            }
+
+            const bool success = relinked || fullBuild(file);
+            const auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::steady_clock::now() - start).count();
+            if (success) {
+                std::cout << "Rebuilt " << options_.outputFile.string() << " in " << ms << " ms (" << kind << ")" << std::endl;
+            }
+            else {
+                util::Logger::error("Rebuild failed after " + std::to_string(ms) + " ms, waiting for the next save");
+            }
+        }
+
+        util::Logger::error("Stopped watching " + options_.inputFile.string());
+        return 1;
+    }
+
+    bool PlayerWatcher::loadImage(std::vector<u8> file, CPU6510& cpu, SIDLoader& sid, TuneImage& image) {
+        cpu.reset();
+        sid.setCPU(&cpu);
+        if (!sid.loadSIDFromBuffer(file)) {
+            return false;
+        }
+
+        image.loadAddress = sid.getLoadAddress();
+        image.dataOffset = sid.getHeader().dataOffset;
+        image.dataSize = sid.getDataSize();
+        image.file = std::move(file);
+        return static_cast<size_t>(image.dataOffset) + image.dataSize <= image.file.size();
+    }
+
+    PlayerWatcher::Change PlayerWatcher::classifyChange(const TuneImage& previous, const TuneImage& current,
+        std::span<const u8> memoryAccess) {
+
+        if (previous.file == current.file) {
+            return Change::None;
+        }
+
+        // Moved or resized music, or edited header fields, changes what gets linked
+        if (previous.file.size() != current.file.size() ||
+            previous.loadAddress != current.loadAddress ||
+            previous.dataOffset != current.dataOffset ||
+            previous.dataSize != current.dataSize ||
+            !std::equal(previous.file.begin(), previous.file.begin() + previous.dataOffset, current.file.begin())) {
+            return Change::Full;
+        }
+
+        const auto oldMusic = previous.music();
+        const auto newMusic = current.music();
+        for (size_t i = 0; i < oldMusic.size(); ++i) {
+            const size_t address = previous.loadAddress + i;
+            if (oldMusic[i] != newMusic[i] && (address >= memoryAccess.size() || isExecuted(memoryAccess[address]))) {
+                return Change::Full;
+            }
+        }
+        return Change::DataOnly;
+    }
+
+    bool PlayerWatcher::staysInAnalyzedCode(CPU6510& cpu, const SIDLoader& sid,
+        std::span<const u8> memoryAccess, int frames) {
+
+        // Suspicious conditions are reported as for a full emulation, however the check ends
+        struct DiagnosticsReport {
+            CPU6510& cpu;
+            ~DiagnosticsReport() {
+                cpu.getDiagnostics().logSummary();
+                cpu.clearDiagnostics();
+            }
+        };
+        cpu.clearDiagnostics();
+        const DiagnosticsReport report{ cpu };
+
+        // New data can steer the player into code the analysis never saw
+        // (an effect used for the first time), which the cached analysis would miss
+        cpu.resetRegistersAndFlags();
+        if (!cpu.executeFunction(sid.getInitAddress())) {
+            return false;
+        }
+        const int calls = frames * std::max(1, sid.getNumPlayCallsPerFrame());
+        for (int call = 0; call < calls; ++call) {
+            cpu.resetRegistersAndFlags();
+            if (!cpu.executeFunction(sid.getPlayAddress())) {
+                return false;
+            }
+        }
+
+        const auto access = cpu.getMemoryAccess();
+        for (size_t address = 0; address < access.size(); ++address) {
+            if (isExecuted(access[address]) &&
+                (address >= memoryAccess.size() || !isExecuted(memoryAccess[address]))) {
+                util::Logger::debug("New code executed at $" + util::wordToHex(static_cast<u16>(address)));
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool PlayerWatcher::writesOnlyAnalyzedMemory(const CPU6510& cpu, std::span<const u8> memoryAccess) {
+        const u8 write = static_cast<u8>(MemoryAccessFlag::Write);
+        const auto access = cpu.getMemoryAccess();
+        for (size_t address = 0; address < access.size(); ++address) {
+            if ((access[address] & write) && (address >= memoryAccess.size() || !(memoryAccess[address] & write))) {
+                util::Logger::debug("New memory written at $" + util::wordToHex(static_cast<u16>(address)));
+                return false;
+            }
+        }
+        return true;
+    }
+
+    std::string PlayerWatcher::registerWriteOrder(const std::vector<u8>& file) {
+        // The short run the player build makes for its helpful data. Both orders
+        // compared come from here, so a short warm-up keeps a save fast
+        CPU6510 cpu;
+        SIDLoader sid;
+        TuneImage image;
+        if (!loadImage(file, cpu, sid, image)) {
+            return {};
+        }
+        SIDEmulator emulator(&cpu, &sid);
+        SIDEmulator::EmulationOptions options;
+        options.frames = MusicBuilder::HelpfulDataFrames;
+        options.warmUpFrames = MusicBuilder::HelpfulDataFrames;
+        options.registerTrackingEnabled = true;
+        if (!emulator.runEmulation(options) || !emulator.getWriteTracker().hasConsistentPattern()) {
+            return {};
+        }
+        return emulator.getWriteTracker().getWriteOrderString();
+    }
+
+    bool PlayerWatcher::patchLinkedPrg(std::vector<u8>& prg, u16 loadAddress,
+        std::span<const u8> oldMusic, std::span<const u8> newMusic) {
+
+        if (prg.size() < 2 || oldMusic.size() != newMusic.size()) {
+            return false;
+        }
+        const u16 prgAddress = static_cast<u16>(prg[0] | (prg[1] << 8));
+        if (loadAddress < prgAddress) {
+            return false;
+        }
+        const size_t offset = 2 + static_cast<size_t>(loadAddress - prgAddress);
+        if (offset + oldMusic.size() > prg.size() ||
+            !std::equal(oldMusic.begin(), oldMusic.end(), prg.begin() + offset)) {
+            return false;
+        }
+
+        std::copy(newMusic.begin(), newMusic.end(), prg.begin() + offset);
+        return true;
+    }
+
+    bool PlayerWatcher::fullBuild(std::vector<u8> file) {
+        haveCache_ = false;
+
+        CommandProcessor processor;
+        if (!processor.processFile(options_)) {
+            return false;
+        }
+
+        // Without the parsed tune or the linked PRG, the next save is a full rebuild too
+        CPU6510 cpu;
+        SIDLoader sid;
+        if (!loadImage(std::move(file), cpu, sid, built_) || !readFile(linkedPrgFile_, linkedPrg_)) {
+            return true;
+        }
+        const auto access = processor.getCPU().getMemoryAccess();
+        memoryAccess_.assign(access.begin(), access.end());
+        registerOrder_ = registerWriteOrder(built_.file);
+        haveCache_ = true;
+        return true;
+    }
+
+    bool PlayerWatcher::relink(const TuneImage& current) {
+        std::vector<u8> prg = linkedPrg_;
+        if (!patchLinkedPrg(prg, current.loadAddress, built_.music(), current.music())) {
+            util::Logger::debug("Linked PRG does not hold the previous music data");
+            return false;
+        }
+        if (!writeFile(linkedPrgFile_, prg)) {
+            util::Logger::error("Cannot write " + linkedPrgFile_.string());
+            return false;
+        }
+
+        MusicBuilder::BuildOptions buildOptions;
+        buildOptions.playerAddress = options_.playerAddress;
+        buildOptions.compress = options_.compress;
+        buildOptions.compressorType = options_.compressorType;
+        buildOptions.exomizerPath = options_.exomizerPath;
+        if (!MusicBuilder::writeOutput(linkedPrgFile_, options_.outputFile, buildOptions)) {
+            return false;
+        }
+
+        // The analysis still describes the code, so only the tune and PRG move on
+        linkedPrg_ = std::move(prg);
+        built_ = current;
+        return true;
+    }
+
+} // namespace sidblaster
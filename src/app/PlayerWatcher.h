@@ -0,0 +1,160 @@
+// PlayerWatcher.h
+#pragma once
+
+#include "../Common.h"
+#include "CommandProcessor.h"
+
+#include <span>
+#include <string>
+#include <vector>
+
+class CPU6510;
+class SIDLoader;
+
+namespace sidblaster {
+
+    /**
+     * @class PlayerWatcher
+     * @brief Rebuilds a player PRG every time its SID file is saved (-player -watch)
+     *
+     * The first build is a normal -player build. Its analysis is kept: the
+     * memory access flags of the full emulation, and the linked (uncompressed)
+     * player PRG. When the SID is saved again, the new music data is compared
+     * with the previous version:
+     *
+     * - header or size changed, or a changed byte was executed: full rebuild;
+     * - only never-executed bytes (data tables) changed: the new tune is run
+     *   for a few frames, and if it executes nothing the full analysis did not,
+     *   writes nowhere new and keeps its SID register write order (both go
+     *   into the player's helpful data), the new music is patched into the
+     *   linked PRG, which is then only recompressed. Emulation and KickAss
+     *   are skipped.
+     */
+    class PlayerWatcher {
+    public:
+        /**
+         * @brief How a saved SID differs from the previous build
+         */
+        enum class Change {
+            None,       ///< Same bytes
+            DataOnly,   ///< Only bytes that were never executed changed
+            Full        ///< Anything else
+        };
+
+        /**
+         * @struct TuneImage
+         * @brief A SID file and where its music data lives
+         */
+        struct TuneImage {
+            std::vector<u8> file;         ///< SID file contents
+            u16 loadAddress = 0;          ///< C64 load address
+            u16 dataOffset = 0;           ///< Offset of the music data in the file
+            u16 dataSize = 0;             ///< Size of the music data
+
+            /**
+             * @brief Get the music data
+             * @return Bytes loaded at loadAddress
+             */
+            std::span<const u8> music() const { return std::span<const u8>(file).subspan(dataOffset, dataSize); }
+        };
+
+        static constexpr int CoverageFrames = 500;   ///< Frames the new tune is checked for new code
+
+        /**
+         * @brief Constructor
+         * @param options Processing options of the -player command
+         */
+        explicit PlayerWatcher(CommandProcessor::ProcessingOptions options);
+
+        /**
+         * @brief Build, then rebuild on every save until the file cannot be watched
+         * @return Exit code
+         */
+        int run();
+
+        /**
+         * @brief Parse a SID file into a CPU
+         * @param file SID file contents
+         * @param cpu CPU to load the music into
+         * @param sid Loader to parse with
+         * @param image Receives the file and its layout
+         * @return True if the file is a loadable SID
+         */
+        static bool loadImage(std::vector<u8> file, CPU6510& cpu, SIDLoader& sid, TuneImage& image);
+
+        /**
+         * @brief Compare a saved SID with the previous build
+         * @param previous Tune of the previous build
+         * @param current Saved tune
+         * @param memoryAccess Memory access flags of the previous build's analysis
+         * @return Kind of change
+         */
+        static Change classifyChange(const TuneImage& previous, const TuneImage& current,
+            std::span<const u8> memoryAccess);
+
+        /**
+         * @brief Check that a loaded tune only runs code the analysis saw
+         * @param cpu CPU holding the tune
+         * @param sid Loader of the tune
+         * @param memoryAccess Memory access flags of the previous build's analysis
+         * @param frames Play calls to check
+         * @return True if every executed byte was executed before
+         */
+        static bool staysInAnalyzedCode(CPU6510& cpu, const SIDLoader& sid,
+            std::span<const u8> memoryAccess, int frames);
+
+        /**
+         * @brief Check that a tune only wrote to memory the analysis saw written
+         * @param cpu CPU that ran the tune (see staysInAnalyzedCode)
+         * @param memoryAccess Memory access flags of the previous build's analysis
+         * @return True if every written byte was written before
+         *
+         * The written addresses are the AddressesThatChange list of the
+         * helpful data; addresses the new tune no longer writes may stay in it.
+         */
+        static bool writesOnlyAnalyzedMemory(const CPU6510& cpu, std::span<const u8> memoryAccess);
+
+        /**
+         * @brief Get the SID register write order the player build would find
+         * @param file SID file contents
+         * @return Write order as written to the helpful data, or empty if there is no consistent one
+         */
+        static std::string registerWriteOrder(const std::vector<u8>& file);
+
+        /**
+         * @brief Replace the music data inside a linked player PRG
+         * @param prg Linked PRG (two-byte load address, then data)
+         * @param loadAddress Address the music data was linked at
+         * @param oldMusic Music data that was linked
+         * @param newMusic Music data to put in its place (same size)
+         * @return False if the PRG does not hold oldMusic at loadAddress
+         */
+        static bool patchLinkedPrg(std::vector<u8>& prg, u16 loadAddress,
+            std::span<const u8> oldMusic, std::span<const u8> newMusic);
+
+    private:
+        CommandProcessor::ProcessingOptions options_;  ///< Options of every build
+        fs::path linkedPrgFile_;                       ///< Uncompressed PRG written by the player build
+
+        bool haveCache_ = false;                       ///< Whether the fields below describe the output
+        TuneImage built_;                              ///< Tune of the last build
+        std::vector<u8> memoryAccess_;                 ///< Access flags of the last full analysis
+        std::vector<u8> linkedPrg_;                    ///< Uncompressed PRG of the last build
+        std::string registerOrder_;                    ///< SID register write order of the last build
+
+        /**
+         * @brief Run a normal -player build and cache its analysis
+         * @param file SID file contents the build is expected to see
+         * @return True if the build succeeded
+         */
+        bool fullBuild(std::vector<u8> file);
+
+        /**
+         * @brief Patch the new music into the cached PRG and write the output
+         * @param current Saved tune
+         * @return True if the output was written
+         */
+        bool relink(const TuneImage& current);
+    };
+
+} // namespace sidblaster
@@ -1,17 +1,46 @@
 ﻿// SIDBlasterApp.cpp
 #include "SIDBlasterApp.h"
 #include "CommandProcessor.h"
+#include "JobServer.h"
+#include "PlayerWatcher.h"
 #include "RelocationUtils.h"
 #include "../SIDBlasterUtils.h"
 #include "../ConfigManager.h"
+#include "../PipelineStats.h"
 #include "../cpu6510.h"
 #include "../SIDLoader.h"
 #include "../SIDEmulator.h"
+#include <algorithm>
 #include <iostream>
 #include <filesystem>
 
 namespace sidblaster {
 
+    namespace {
+
+        /**
+         * @brief Print what compaction saved and where each block of the tune went
+         * @param compact Whether unused bytes were removed
+         * @param bytesSaved Bytes left out of the relocated tune
+         * @param memoryMap Kept blocks, in address order
+         * @param indent Prefix for every line
+         */
+        void printMemoryMap(bool compact, int bytesSaved, const std::vector<util::MemoryMapBlock>& memoryMap, const std::string& indent) {
+            if (compact) {
+                std::cout << indent << "Compacted: " << bytesSaved << " unused bytes removed" << std::endl;
+            }
+            else {
+                std::cout << indent << "Memory map:" << std::endl;
+            }
+            for (const auto& block : memoryMap) {
+                const u16 newEnd = static_cast<u16>(block.newStart + (block.originalEnd - block.originalStart));
+                std::cout << indent << "  $" << util::wordToHex(block.originalStart) << "-$" << util::wordToHex(block.originalEnd)
+                    << " -> $" << util::wordToHex(block.newStart) << "-$" << util::wordToHex(newEnd) << std::endl;
+            }
+        }
+
+    } // anonymous namespace
+
     SIDBlasterApp::SIDBlasterApp(int argc, char** argv)
         : cmdParser_(argc, argv),
         command_(CommandClass::Type::Unknown) {
@@ -31,22 +60,49 @@ namespace sidblaster {
         // Initialize configuration system
         util::ConfigManager::initialize(configFile);
 
+        // Parse command line into command object (logging depends on -verbose and -log)
+        command_ = cmdParser_.parse();
+
         // Initialize logging
         initializeLogging();
 
-        // Parse command line into command object
-        command_ = cmdParser_.parse();
+        // Collect per-stage timings if they will be reported
+        const std::string statsFile = command_.getParameter("stats", "");
+        const std::string timelineFile = command_.getParameter("timeline", "");
+        const bool reportStats = command_.getType() != CommandClass::Type::Help &&
+            (verbose_ || !statsFile.empty() || !timelineFile.empty());
+        if (reportStats) {
+            util::PipelineStats::enable();
+        }
 
         // Execute the command
-        return executeCommand();
+        const int result = executeCommand();
+
+        if (reportStats) {
+            if (verbose_) {
+                // stdout carries the job results in serve mode
+                std::ostream& out = command_.getType() == CommandClass::Type::Serve ? std::cerr : std::cout;
+                out << std::endl;
+                util::PipelineStats::printTable(out);
+            }
+            if (!statsFile.empty()) {
+                util::PipelineStats::writeJson(statsFile);
+            }
+            if (!timelineFile.empty()) {
+                util::PipelineStats::writeTimeline(timelineFile);
+            }
+        }
+
+        return result;
     }
 
     void SIDBlasterApp::setupCommandLine() {
         // Command type flags - updated with new simplified syntax
         cmdParser_.addFlagDefinition("player", "Link SID music with a player (convert .sid to playable .prg)", "Commands");
-        cmdParser_.addFlagDefinition("relocate", "Relocate a SID file to a new address (use -relocate=<address>)", "Commands");
+        cmdParser_.addFlagDefinition("relocate", "Relocate a SID file to a new address (use -relocate=<address>[,<address>...] or -relocate=<first>-<last>[,...] to scatter it into free memory)", "Commands");
         cmdParser_.addFlagDefinition("disassemble", "Disassemble a SID file to assembly code", "Commands");
         cmdParser_.addFlagDefinition("trace", "Trace SID register writes during emulation", "Commands");
+        cmdParser_.addFlagDefinition("serve", "Run JSON jobs from stdin, one result line per job on stdout", "Commands");
 
         // Remove old options and add new ones
         std::string defaultPlayerName = util::ConfigManager::getPlayerName();
@@ -61,12 +117,22 @@ namespace sidblaster {
         cmdParser_.addOptionDefinition("exomizer", "path", "Path to Exomizer", "General",
             util::ConfigManager::getExomizerPath());
 
+        cmdParser_.addOptionDefinition("profile", "file", "Write a per-subroutine rastertime profile", "General");
+        cmdParser_.addOptionDefinition("heatmap", "file", "Write per-address execution and access counts", "General");
+        cmdParser_.addFlagDefinition("heatcomments", "Add execution counts to disassembly comments", "General");
+        cmdParser_.addOptionDefinition("budget", "cycles", "Fail if any frame exceeds this many cycles", "General");
+        cmdParser_.addOptionDefinition("worstframes", "file", "Write the most expensive frames with CPU snapshots", "General");
+        cmdParser_.addOptionDefinition("stats", "file", "Write per-stage timing and resource usage as JSON", "General");
+        cmdParser_.addOptionDefinition("timeline", "file", "Write a Chrome/Perfetto trace of stages and emulation phases", "General");
+
         // Flags
         cmdParser_.addFlagDefinition("verbose", "Enable verbose logging", "General");
         cmdParser_.addFlagDefinition("help", "Display this help message", "General");
         cmdParser_.addFlagDefinition("force", "Force overwrite of output file", "General");
         cmdParser_.addFlagDefinition("nocompress", "Disable compression for PRG output", "General");
         cmdParser_.addFlagDefinition("noverify", "Skip verification after relocation", "Relocation");
+        cmdParser_.addFlagDefinition("compact", "Remove unused bytes when relocating instead of zeroing them", "Relocation");
+        cmdParser_.addFlagDefinition("watch", "Rebuild the player PRG whenever the SID file is saved", "Player");
 
         // Add example usages
         cmdParser_.addExample(
@@ -77,10 +143,26 @@ namespace sidblaster {
             "SIDBlaster -player=SimpleBitmap music.sid player.prg",
             "Links music.sid with SimpleBitmap player");
 
+        cmdParser_.addExample(
+            "SIDBlaster -player -watch music.sid music.prg",
+            "Rebuilds music.prg whenever music.sid is saved");
+
         cmdParser_.addExample(
             "SIDBlaster -relocate=$2000 music.sid relocated.sid",
             "Relocates music.sid to $2000 and saves as relocated.sid");
 
+        cmdParser_.addExample(
+            "SIDBlaster -relocate=$1000,$8000 music.sid relocated.sid",
+            "Relocates music.sid to $1000 and $8000 from one analysis, saving relocated-1000.sid and relocated-8000.sid");
+
+        cmdParser_.addExample(
+            "SIDBlaster -relocate=$2000 -compact music.sid relocated.sid",
+            "Relocates music.sid to $2000, leaving out the bytes the tune never uses");
+
+        cmdParser_.addExample(
+            "SIDBlaster -relocate=$0A00-$1FFF,$E000-$FFF0 music.sid relocated.sid",
+            "Splits music.sid up to fit into the free memory at $0A00-$1FFF and $E000-$FFF0, also writing the segments to relocated.asm");
+
         cmdParser_.addExample(
             "SIDBlaster -disassemble music.sid music.asm",
             "Disassembles music.sid to assembly code in music.asm");
@@ -92,6 +174,14 @@ namespace sidblaster {
         cmdParser_.addExample(
             "SIDBlaster -trace=music.log music.sid",
             "Traces SID register writes to music.log in text format");
+
+        cmdParser_.addExample(
+            "SIDBlaster -profile=music.txt -disassemble music.sid music.asm",
+            "Disassembles music.sid and writes a rastertime profile to music.txt and music.folded");
+
+        cmdParser_.addExample(
+            "SIDBlaster -budget=4000 -disassemble music.sid music.asm",
+            "Disassembles music.sid and fails if any frame uses more than 4000 cycles");
     }
 
     void SIDBlasterApp::initializeLogging() {
@@ -129,6 +219,8 @@ namespace sidblaster {
             return processDisassembly();
         case CommandClass::Type::Trace:
             return processTrace();
+        case CommandClass::Type::Serve:
+            return processServe();
         default:
             // Show help when no valid command is specified
             std::cout << "Unknown command or no command specified" << std::endl << std::endl;
@@ -183,6 +275,24 @@ namespace sidblaster {
         options.traceFormat = (traceFormat == "text") ?
             TraceFormat::Text : TraceFormat::Binary;
 
+        // Rastertime profile of the play routine
+        options.profilePath = command_.getParameter("profile", "");
+
+        // Flat per-address execution and access counts
+        options.heatMapPath = command_.getParameter("heatmap", "");
+        options.heatMapComments = command_.hasFlag("heatcomments");
+
+        // Per-frame cycle budget (a bare -budget means one whole frame)
+        if (command_.hasParameter("budget")) {
+            options.cycleBudget = static_cast<u64>(std::max(0, command_.getIntParameter("budget", 0)));
+        }
+        else if (command_.hasFlag("budget")) {
+            options.cycleBudget = static_cast<u64>(
+                util::ConfigManager::getDouble("cyclesPerLine", 63.0) *
+                util::ConfigManager::getDouble("linesPerFrame", 312.0));
+        }
+        options.worstFramesPath = command_.getParameter("worstframes", "");
+
         // Get frames to emulate from command line or config
         options.frames = command_.getIntParameter("frames",
             util::ConfigManager::getInt("emulationFrames", DEFAULT_SID_EMULATION_FRAMES));
@@ -236,6 +346,11 @@ namespace sidblaster {
         options.playerName = command_.getParameter("playerName", util::ConfigManager::getPlayerName());
         options.playerAddress = command_.getHexParameter("playeraddr", util::ConfigManager::getPlayerAddress());
 
+        if (command_.hasFlag("watch")) {
+            PlayerWatcher watcher(options);
+            return watcher.run();
+        }
+
         // Create and run command processor
         CommandProcessor processor;
         bool success = processor.processFile(options);
@@ -258,7 +373,43 @@ namespace sidblaster {
             return 1;
         }
 
-        // [Existing validation code remains the same]
+        // Ranges are free memory windows to scatter the tune into
+        const std::string relocateParameter = command_.getParameter("relocateaddr");
+        std::vector<std::pair<u16, u16>> windows;
+        if (relocateParameter.find('-') != std::string::npos) {
+            const auto ranges = util::parseHexRangeList(relocateParameter);
+            if (!ranges) {
+                std::cout << "Error: Invalid memory windows \"" << relocateParameter
+                    << "\" (use -relocate=<first>-<last>,<first>-<last>,...)" << std::endl;
+                return 1;
+            }
+            for (size_t i = 0; i < ranges->size(); ++i) {
+                for (size_t j = 0; j < i; ++j) {
+                    if ((*ranges)[i].first <= (*ranges)[j].second && (*ranges)[j].first <= (*ranges)[i].second) {
+                        std::cout << "Error: Memory windows $" << util::wordToHex((*ranges)[j].first) << "-$"
+                            << util::wordToHex((*ranges)[j].second) << " and $" << util::wordToHex((*ranges)[i].first)
+                            << "-$" << util::wordToHex((*ranges)[i].second) << " overlap" << std::endl;
+                        return 1;
+                    }
+                }
+            }
+            windows = *ranges;
+        }
+
+        // A list of addresses shares one analysis between its outputs
+        u16 relocAddress = windows.empty() ? 0 : windows.front().first;
+        if (windows.empty()) {
+            const auto addresses = util::parseHexList(relocateParameter);
+            if (!addresses) {
+                std::cout << "Error: Invalid relocation address \"" << relocateParameter
+                    << "\" (use -relocate=<address> or -relocate=<address>,<address>,...)" << std::endl;
+                return 1;
+            }
+            if (addresses->size() > 1) {
+                return processRelocationTargets(inputFile, outputFile, *addresses);
+            }
+            relocAddress = addresses->front();
+        }
 
         // Create CPU and SID Loader
         auto cpu = std::make_unique<CPU6510>();
@@ -267,11 +418,9 @@ namespace sidblaster {
         auto sid = std::make_unique<SIDLoader>();
         sid->setCPU(cpu.get());
 
-        // Get relocation address
-        u16 relocAddress = command_.getHexParameter("relocateaddr", 0);
-
         // Determine if verification should be skipped (can add a flag for this)
         bool skipVerify = command_.hasFlag("noverify");
+        const bool compact = command_.hasFlag("compact");
 
         if (skipVerify) {
             // Original relocation code without verification
@@ -282,6 +431,8 @@ namespace sidblaster {
             params.relocationAddress = relocAddress;
             params.kickAssPath = command_.getParameter("kickass", util::ConfigManager::getKickAssPath());
             params.verbose = command_.hasFlag("verbose");
+            params.compact = compact;
+            params.windows = windows;
 
             // Ensure temp directory exists
             try {
@@ -300,6 +451,9 @@ namespace sidblaster {
                     " (Load: $" + util::wordToHex(result.newLoad) +
                     ", Init: $" + util::wordToHex(result.newInit) +
                     ", Play: $" + util::wordToHex(result.newPlay) + ")", true);
+                if (compact || !windows.empty()) {
+                    printMemoryMap(compact, result.bytesSaved, result.memoryMap, "");
+                }
                 return 0;
             }
             else {
@@ -319,16 +473,25 @@ namespace sidblaster {
             }
 
             // Let the user know we're relocating with verification
-            std::cout << "Relocating " << inputFile.string() << " to $" << util::wordToHex(relocAddress)
-                << " with verification..." << std::endl;
+            if (windows.empty()) {
+                std::cout << "Relocating " << inputFile.string() << " to $" << util::wordToHex(relocAddress)
+                    << " with verification..." << std::endl;
+            }
+            else {
+                std::cout << "Scattering " << inputFile.string() << " into " << windows.size()
+                    << " memory windows with verification..." << std::endl;
+            }
 
             // Perform relocation with verification
             util::RelocationVerificationResult result = util::relocateAndVerifySID(
                 cpu.get(), sid.get(), inputFile, outputFile, relocAddress, tempDir,
-                command_.getParameter("kickass", util::ConfigManager::getKickAssPath()));
+                command_.getParameter("kickass", util::ConfigManager::getKickAssPath()), compact, windows);
 
             // Display results to user
             if (result.success) {
+                if (compact || !windows.empty()) {
+                    printMemoryMap(compact, result.bytesSaved, result.memoryMap, "");
+                }
                 if (result.verified) {
                     if (result.outputsMatch) {
                         std::cout << "Success: Relocation successful and verified!" << std::endl;
@@ -360,6 +523,74 @@ namespace sidblaster {
         }
     }
 
+    int SIDBlasterApp::processRelocationTargets(const fs::path& inputFile, const fs::path& outputFile,
+        const std::vector<u16>& addresses) {
+
+        std::vector<util::RelocationTarget> targets;
+        for (const u16 address : addresses) {
+            for (const auto& target : targets) {
+                if (target.address == address) {
+                    std::cout << "Error: $" << util::wordToHex(address) << " is listed more than once" << std::endl;
+                    return 1;
+                }
+            }
+
+            // relocated.sid -> relocated-1000.sid, relocated-2000.sid, ...
+            util::RelocationTarget target;
+            target.address = address;
+            target.outputFile = outputFile.parent_path() /
+                (outputFile.stem().string() + "-" + util::wordToHex(address) + outputFile.extension().string());
+            targets.push_back(target);
+        }
+
+        util::RelocationParams params;
+        params.inputFile = inputFile;
+        params.tempDir = fs::path("temp");
+        params.kickAssPath = command_.getParameter("kickass", util::ConfigManager::getKickAssPath());
+        params.verbose = command_.hasFlag("verbose");
+        params.compact = command_.hasFlag("compact");
+
+        const bool verify = !command_.hasFlag("noverify");
+        std::cout << "Relocating " << inputFile.string() << " to " << targets.size() << " addresses"
+            << (verify ? " with verification..." : "...") << std::endl;
+
+        auto cpu = std::make_unique<CPU6510>();
+        cpu->reset();
+        auto sid = std::make_unique<SIDLoader>();
+        sid->setCPU(cpu.get());
+
+        const auto results = util::relocateSIDToTargets(cpu.get(), sid.get(), params, targets, verify);
+
+        int failures = 0;
+        for (size_t i = 0; i < targets.size(); ++i) {
+            const auto& result = results[i];
+            std::cout << "  $" << util::wordToHex(targets[i].address) << " -> " << targets[i].outputFile.string() << ": ";
+            if (!result.success) {
+                std::cout << "failed - " << result.message << std::endl;
+                ++failures;
+            }
+            else if (!verify) {
+                std::cout << "relocated" << std::endl;
+            }
+            else if (!result.verified) {
+                std::cout << "relocated, but verification not completed - " << result.message << std::endl;
+                ++failures;
+            }
+            else if (result.outputsMatch) {
+                std::cout << "relocated and verified" << std::endl;
+            }
+            else {
+                std::cout << "verification failed, difference report saved to " << result.diffReport << std::endl;
+                ++failures;
+            }
+            if (params.compact && result.success) {
+                printMemoryMap(true, result.bytesSaved, result.memoryMap, "    ");
+            }
+        }
+
+        return failures == 0 ? 0 : 1;
+    }
+
     int SIDBlasterApp::processDisassembly() {
         // Validate input file
         fs::path inputFile = fs::path(command_.getInputFile());
@@ -487,4 +718,20 @@ namespace sidblaster {
         }
     }
 
+    int SIDBlasterApp::processServe() {
+        util::Logger::info("Serving jobs from stdin");
+
+        // Configuration and logging stay initialized; each job runs like a command line
+        const CommandClass serveCommand = command_;
+        JobServer server(cmdParser_.getProgramName(), [this](const CommandClass& job) {
+            command_ = job;
+            return executeCommand();
+            });
+        const int failures = server.run(std::cin, std::cout);
+        command_ = serveCommand;
+
+        util::Logger::info("Job server finished, " + std::to_string(failures) + " failed job(s)");
+        return failures == 0 ? 0 : 1;
+    }
+
 } // namespace sidblaster
\ No newline at end of file
@@ -7,6 +7,7 @@
 #include "TraceLogger.h"
 #include <memory>
 #include <string>
+#include <vector>
 
 namespace sidblaster {
 
@@ -77,6 +78,16 @@ namespace sidblaster {
          */
         int processRelocation();
 
+        /**
+         * @brief Relocate one SID file to several addresses (-relocate=<address>,<address>,...)
+         * @param inputFile SID file to relocate
+         * @param outputFile Output name; each target inserts its address before the extension
+         * @param addresses Target addresses
+         * @return Exit code (0 if every target succeeded, non-zero otherwise)
+         */
+        int processRelocationTargets(const fs::path& inputFile, const fs::path& outputFile,
+            const std::vector<u16>& addresses);
+
         /**
          * @brief Process a disassembly command (SID to ASM)
          * @return Exit code (0 on success, non-zero on failure)
@@ -88,6 +99,12 @@ namespace sidblaster {
          * @return Exit code (0 on success, non-zero on failure)
          */
         int processTrace();
+
+        /**
+         * @brief Process a serve command (run JSON jobs from stdin)
+         * @return Exit code (0 if every job succeeded, non-zero otherwise)
+         */
+        int processServe();
     };
 
 } // namespace sidblaster
\ No newline at end of file
@@ -5,6 +5,7 @@
 // ==================================
 #include "TraceLogger.h"
 #include "../SIDBlasterUtils.h"
+#include "../PipelineStats.h"
 #include <map>
 
 namespace sidblaster {
@@ -95,6 +96,9 @@ namespace sidblaster {
         const std::string& relocatedLog,
         const std::string& reportFile) {
 
+        util::StageTimer stage("verify");
+        stage.addOutputFile(reportFile);
+
         std::ifstream original(originalLog, std::ios::binary);
         std::ifstream relocated(relocatedLog, std::ios::binary);
         std::ofstream report(reportFile);
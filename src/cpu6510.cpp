@@ -186,6 +186,17 @@ void CPU6510::setCycles(u64 newCycles) {
     pImpl_->setCycles(newCycles);
 }
 
+/**
+ * @brief Get the number of instructions executed since construction
+ *
+ * Delegates to the implementation class.
+ *
+ * @return The instruction count
+ */
+u64 CPU6510::getInstructionCount() const {
+    return pImpl_->getInstructionCount();
+}
+
 /**
  * @brief Reset the CPU cycle counter to zero
  *
@@ -267,93 +278,143 @@ std::pair<u8, u8> CPU6510::getIndexRange(u16 pc) const {
 }
 
 /**
- * @brief Get a span of CPU memory
+ * @brief Enable or disable per-instruction index histograms
  *
  * Delegates to the implementation class.
  *
- * @return Span of memory data
+ * @param enabled Whether to count every index value used by each instruction
  */
-std::span<const u8> CPU6510::getMemory() const {
-    return pImpl_->getMemory();
+void CPU6510::setIndexHistogramEnabled(bool enabled) {
+    pImpl_->setIndexHistogramEnabled(enabled);
 }
 
 /**
- * @brief Get a span of memory access flags
+ * @brief Get how often each index value was used by an instruction
  *
  * Delegates to the implementation class.
  *
- * @return Span of memory access flags
+ * @param pc Program counter of the instruction
+ * @return 256 counts, or an empty span if no histogram was recorded
  */
-std::span<const u8> CPU6510::getMemoryAccess() const {
-    return pImpl_->getMemoryAccess();
+std::span<const u32> CPU6510::getIndexHistogram(u16 pc) const {
+    return pImpl_->getIndexHistogram(pc);
 }
 
 /**
- * @brief Get the program counter of the last instruction that wrote to an address
+ * @brief Capture registers and memory
  *
  * Delegates to the implementation class.
  *
- * @param addr Memory address to check
- * @return Program counter of the last instruction that wrote to the address
+ * @param snapshot Snapshot to fill in
  */
-u16 CPU6510::getLastWriteTo(u16 addr) const {
-    return pImpl_->getLastWriteTo(addr);
+void CPU6510::captureSnapshot(CPUSnapshot& snapshot) const {
+    pImpl_->captureSnapshot(snapshot);
 }
 
 /**
- * @brief Get the full last-write-to-address tracking vector
+ * @brief Restore registers and memory from a snapshot
  *
  * Delegates to the implementation class.
  *
- * @return Reference to the vector containing PC values of last write to each memory address
+ * @param snapshot Snapshot to restore
  */
-const std::vector<u16>& CPU6510::getLastWriteToAddr() const {
-    return pImpl_->getLastWriteToAddr();
+void CPU6510::restoreSnapshot(const CPUSnapshot& snapshot) {
+    pImpl_->restoreSnapshot(snapshot);
+}
+
+/**
+ * @brief Start or stop collecting per-address execution and access counts
+ *
+ * Delegates to the implementation class.
+ *
+ * @param enabled Whether to update the heat map
+ */
+void CPU6510::setHeatMapEnabled(bool enabled) {
+    pImpl_->setHeatMapEnabled(enabled);
 }
 
 /**
- * @brief Get the source information for the A register
+ * @brief Get the collected heat map
  *
  * Delegates to the implementation class.
  *
- * @return Register source information for the accumulator
+ * @return Heat map, or nullptr if it was never enabled
  */
-RegisterSourceInfo CPU6510::getRegSourceA() const {
-    return pImpl_->getRegSourceA();
+const HeatMap* CPU6510::getHeatMap() const {
+    return pImpl_->getHeatMap();
 }
 
 /**
- * @brief Get the source information for the X register
+ * @brief Get the conditions counted by executeFunction since the last clear
+ *
+ * @return Diagnostics collector
+ */
+const ExecutionDiagnostics& CPU6510::getDiagnostics() const {
+    return pImpl_->getDiagnostics();
+}
+
+/**
+ * @brief Reset the diagnostics counted by executeFunction
+ */
+void CPU6510::clearDiagnostics() {
+    pImpl_->clearDiagnostics();
+}
+
+/**
+ * @brief Get a span of CPU memory
  *
  * Delegates to the implementation class.
  *
- * @return Register source information for the X index register
+ * @return Span of memory data
  */
-RegisterSourceInfo CPU6510::getRegSourceX() const {
-    return pImpl_->getRegSourceX();
+std::span<const u8> CPU6510::getMemory() const {
+    return pImpl_->getMemory();
 }
 
 /**
- * @brief Get the source information for the Y register
+ * @brief Get a span of memory access flags
  *
  * Delegates to the implementation class.
  *
- * @return Register source information for the Y index register
+ * @return Span of memory access flags
  */
-RegisterSourceInfo CPU6510::getRegSourceY() const {
-    return pImpl_->getRegSourceY();
+std::span<const u8> CPU6510::getMemoryAccess() const {
+    return pImpl_->getMemoryAccess();
 }
 
 /**
- * @brief Get the source information for a memory write
+ * @brief Get the program counter of the last instruction that wrote to an address
  *
  * Delegates to the implementation class.
  *
  * @param addr Memory address to check
- * @return Register source information for the last write to the address
+ * @return Program counter of the last instruction that wrote to the address
+ */
+u16 CPU6510::getLastWriteTo(u16 addr) const {
+    return pImpl_->getLastWriteTo(addr);
+}
+
+/**
+ * @brief Get the full last-write-to-address tracking vector
+ *
+ * Delegates to the implementation class.
+ *
+ * @return Reference to the vector containing PC values of last write to each memory address
+ */
+const std::vector<u16>& CPU6510::getLastWriteToAddr() const {
+    return pImpl_->getLastWriteToAddr();
+}
+
+/**
+ * @brief Get the taint tag of a memory byte
+ *
+ * Delegates to the implementation class.
+ *
+ * @param addr Memory address
+ * @return Origin of the value last stored there by the program
  */
-RegisterSourceInfo CPU6510::getWriteSourceInfo(u16 addr) const {
-    return pImpl_->getWriteSourceInfo(addr);
+TaintTag CPU6510::getTaint(u16 addr) const {
+    return pImpl_->getTaint(addr);
 }
 
 /**
@@ -411,6 +472,24 @@ void CPU6510::setOnVICWriteCallback(MemoryWriteCallback callback) {
     pImpl_->setOnVICWriteCallback(std::move(callback));
 }
 
-const MemoryDataFlow& CPU6510::getMemoryDataFlow() const {
-    return pImpl_->getMemoryDataFlow();
-}
\ No newline at end of file
+/**
+ * @brief Set the callback for subroutine calls
+ *
+ * Delegates to the implementation class.
+ *
+ * @param callback Function to be called after a JSR
+ */
+void CPU6510::setOnSubroutineCallCallback(SubroutineCallCallback callback) {
+    pImpl_->setOnSubroutineCallCallback(std::move(callback));
+}
+
+/**
+ * @brief Set the callback for subroutine returns
+ *
+ * Delegates to the implementation class.
+ *
+ * @param callback Function to be called after an RTS
+ */
+void CPU6510::setOnSubroutineReturnCallback(SubroutineReturnCallback callback) {
+    pImpl_->setOnSubroutineReturnCallback(std::move(callback));
+}
@@ -113,30 +113,24 @@ enum class Instruction {
     SHA, SHX, SHY, XAA
 };
 
-// Source information for register values
-struct RegisterSourceInfo {
-    enum class SourceType { Unknown, Immediate, Memory };
-
-    SourceType type = SourceType::Unknown;
-    u16 address = 0;
-    u8 value = 0;
-    u8 index = 0;
-};
-
-// Index range tracking
-struct IndexRange {
-    int min = std::numeric_limits<int>::max();
-    int max = std::numeric_limits<int>::min();
+/**
+ * @struct TaintTag
+ * @brief Origin of a byte value, carried by every register and memory byte
+ *
+ * A load tags the register with the address it read (or, if that byte was
+ * itself written by the program, with the tag stored there), so copies keep
+ * pointing at the byte in the program that the value came from. Stores,
+ * register transfers and the stack pass tags on unchanged; arithmetic keeps
+ * the tag of the operand most likely to be an address rather than an index.
+ */
+struct TaintTag {
+    static constexpr u8 Valid = 0x01;   ///< The value has a known origin
+    static constexpr u8 Index = 0x02;   ///< The value was last loaded into X or Y
 
-    void update(int offset) {
-        min = std::min(min, offset);
-        max = std::max(max, offset);
-    }
+    u16 origin = 0;   ///< Address the value was first read from
+    u8 flags = 0;     ///< Valid and Index bits
 
-    std::pair<int, int> getRange() const {
-        if (min > max) return { 0, 0 };  // No valid data
-        return { min, max };
-    }
+    bool isValid() const { return (flags & Valid) != 0; }
 };
 
 // Opcode information
@@ -149,14 +143,148 @@ struct OpcodeInfo {
 };
 
 /**
- * @struct MemoryDataFlow
- * @brief Tracks data flow between memory locations
+ * @brief Registers and memory at one point in time
+ *
+ * Restoring a snapshot and calling the same routine reproduces the original
+ * execution exactly, which makes expensive calls replayable in isolation.
+ */
+struct CPUSnapshot {
+    u16 pc = 0;
+    u8 sp = 0;
+    u8 a = 0;
+    u8 x = 0;
+    u8 y = 0;
+    u8 status = 0;
+    u64 cycles = 0;
+    std::array<u8, 65536> memory{};
+};
+
+/**
+ * @brief Per-address execution and access counters
  *
- * Used to analyze how data moves through memory, especially for tracking
- * pointer chains used in indirect addressing.
+ * Flat 64K arrays, allocated when first enabled and only updated while
+ * CPU6510::setHeatMapEnabled(true) is in effect. Execution counts and cycles
+ * are indexed by the address of the instruction's opcode; reads and writes
+ * by the data address accessed.
  */
-struct MemoryDataFlow {
-    std::map<u16, std::vector<u16>> memoryWriteSources;
+class HeatMap {
+public:
+    /**
+     * @brief Allocate (and zero) all counter arrays
+     */
+    void allocate();
+
+    /**
+     * @brief Check whether the counters have been allocated
+     * @return True if allocate() has been called
+     */
+    bool isAllocated() const { return !executions.empty(); }
+
+    /**
+     * @brief Write all non-zero entries in a compact binary format
+     * @param filename Output filename
+     * @return True if the file was written successfully
+     *
+     * Layout (little-endian): "SBHM", u16 version, u32 entry count, then per
+     * entry u16 address, u32 executions, u64 cycles, u32 reads, u32 writes.
+     */
+    bool writeBinary(const std::string& filename) const;
+
+    /**
+     * @brief Write all non-zero entries as CSV
+     * @param filename Output filename
+     * @return True if the file was written successfully
+     */
+    bool writeCsv(const std::string& filename) const;
+
+    std::vector<u32> executions;   // Instructions executed at each PC
+    std::vector<u64> cycles;       // Cycles spent in instructions at each PC
+    std::vector<u32> reads;        // Data reads of each address
+    std::vector<u32> writes;       // Data writes to each address
+};
+
+/**
+ * @brief Suspicious conditions seen by executeFunction
+ *
+ * Each event is counted, and the first few occurrences of each type are kept
+ * with their PC/SP context, so executeFunction never logs from inside its
+ * loop. Owners such as SIDEmulator::runEmulation clear the collector, run
+ * their calls and then log one summary.
+ */
+class ExecutionDiagnostics {
+public:
+    /**
+     * @brief Event types
+     */
+    enum class Event : u8 {
+        LowStack,            // Instruction executed with SP below $A0
+        ZeroPageExecution,   // Call that executed code in zero page (counted once per call)
+        SuspiciousJump,      // JMP/JSR to a zero page address
+        SuspiciousReturn,    // RTS to an address below $0100
+        Count
+    };
+
+    /**
+     * @brief Context of one recorded occurrence
+     */
+    struct Occurrence {
+        u16 pc = 0;        // Address of the instruction
+        u8 sp = 0;         // Stack pointer before it executed
+        u16 target = 0;    // Jump or return address (0 if not applicable)
+    };
+
+    static constexpr size_t MaxRecorded = 4;    // Occurrences kept per event type
+
+    /**
+     * @brief Count an event, keeping its context if it is among the first few
+     * @param event Event type
+     * @param pc Address of the instruction
+     * @param sp Stack pointer
+     * @param target Jump or return address
+     */
+    void record(Event event, u16 pc, u8 sp, u16 target = 0) {
+        const size_t index = static_cast<size_t>(event);
+        if (counts_[index] < MaxRecorded) {
+            recorded_[index][counts_[index]] = { pc, sp, target };
+        }
+        ++counts_[index];
+    }
+
+    /**
+     * @brief Get how often an event occurred
+     * @param event Event type
+     * @return Occurrence count
+     */
+    u64 count(Event event) const { return counts_[static_cast<size_t>(event)]; }
+
+    /**
+     * @brief Get the recorded occurrences of an event
+     * @param event Event type
+     * @return Up to MaxRecorded occurrences, oldest first
+     */
+    std::span<const Occurrence> occurrences(Event event) const;
+
+    /**
+     * @brief Check whether no events were recorded
+     * @return True if every count is zero
+     */
+    bool empty() const;
+
+    /**
+     * @brief Reset all counts
+     */
+    void clear() { counts_.fill(0); }
+
+    /**
+     * @brief Log one warning per event type that occurred
+     */
+    void logSummary() const;
+
+private:
+    static constexpr size_t EventCount = static_cast<size_t>(Event::Count);
+
+    std::array<u64, EventCount> counts_{};                                       // Occurrences per event
+    std::array<std::array<Occurrence, MaxRecorded>, EventCount> recorded_{};     // First occurrences per event
 };
 
 class CPU6510 {
@@ -200,6 +328,7 @@ public:
     u64 getCycles() const;
     void setCycles(u64 newCycles);
     void resetCycles();
+    u64 getInstructionCount() const;    // Instructions executed since construction (never reset)
 
     // Instruction information
     std::string_view getMnemonic(u8 opcode) const;
@@ -211,6 +340,58 @@ public:
     void dumpMemoryAccess(const std::string& filename);
     std::pair<u8, u8> getIndexRange(u16 pc) const;
 
+    /**
+     * @brief Enable or disable per-instruction index histograms
+     * @param enabled Whether to count every index value used by each instruction
+     *
+     * Off by default; min/max index ranges are always tracked.
+     */
+    void setIndexHistogramEnabled(bool enabled);
+
+    /**
+     * @brief Get how often each index value was used by an instruction
+     * @param pc Address of the instruction's operand
+     * @return 256 counts, or an empty span if no histogram was recorded
+     */
+    std::span<const u32> getIndexHistogram(u16 pc) const;
+
+    /**
+     * @brief Capture registers and memory
+     * @param snapshot Snapshot to fill in
+     */
+    void captureSnapshot(CPUSnapshot& snapshot) const;
+
+    /**
+     * @brief Restore registers and memory from a snapshot
+     * @param snapshot Snapshot to restore (access tracking is not affected)
+     */
+    void restoreSnapshot(const CPUSnapshot& snapshot);
+
+    /**
+     * @brief Start or stop collecting per-address execution and access counts
+     * @param enabled Whether to update the heat map
+     *
+     * Counts accumulate across enable/disable cycles.
+     */
+    void setHeatMapEnabled(bool enabled);
+
+    /**
+     * @brief Get the collected heat map
+     * @return Heat map, or nullptr if it was never enabled
+     */
+    const HeatMap* getHeatMap() const;
+
+    /**
+     * @brief Get the conditions counted by executeFunction since the last clear
+     * @return Diagnostics collector
+     */
+    const ExecutionDiagnostics& getDiagnostics() const;
+
+    /**
+     * @brief Reset the diagnostics counted by executeFunction
+     */
+    void clearDiagnostics();
+
     // Memory access
     std::span<const u8> getMemory() const;
     std::span<const u8> getMemoryAccess() const;
@@ -218,26 +399,27 @@ public:
     // Accessors
     u16 getLastWriteTo(u16 addr) const;
     const std::vector<u16>& getLastWriteToAddr() const;
-    RegisterSourceInfo getRegSourceA() const;
-    RegisterSourceInfo getRegSourceX() const;
-    RegisterSourceInfo getRegSourceY() const;
-    RegisterSourceInfo getWriteSourceInfo(u16 addr) const;
 
     /**
-   * @brief Get the memory data flow tracking information
-   * @return Reference to the memory data flow tracking
-   */
-    const MemoryDataFlow& getMemoryDataFlow() const;
-    
+     * @brief Get the taint tag of a memory byte
+     * @param addr Memory address
+     * @return Origin of the value last stored there by the program (invalid if none)
+     */
+    TaintTag getTaint(u16 addr) const;
+
     // Callbacks
     using IndirectReadCallback = std::function<void(u16 pc, u8 zpAddr, u16 targetAddr)>;
     using MemoryWriteCallback = std::function<void(u16 addr, u8 value)>;
+    using SubroutineCallCallback = std::function<void(u16 target, u8 sp, u64 cycles)>;      // After a JSR
+    using SubroutineReturnCallback = std::function<void(u8 sp, u64 cycles)>;               // After an RTS
 
     void setOnIndirectReadCallback(IndirectReadCallback callback);
     void setOnWriteMemoryCallback(MemoryWriteCallback callback);
     void setOnCIAWriteCallback(MemoryWriteCallback callback);
     void setOnSIDWriteCallback(MemoryWriteCallback callback);
     void setOnVICWriteCallback(MemoryWriteCallback callback);
+    void setOnSubroutineCallCallback(SubroutineCallCallback callback);
+    void setOnSubroutineReturnCallback(SubroutineReturnCallback callback);
 
 private:
     // Implementation pointer
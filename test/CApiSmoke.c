@@ -0,0 +1,119 @@
+/* ==================================
+ *             SIDBlaster
+ *
+ *  Raistlin / Genesis Project (G*P)
+ * ==================================
+ *
+ * Smoke test of the C API, compiled as C to keep SIDBlasterAPI.h honest.
+ *
+ * Usage: sidblaster_capi <file.sid>
+ */
+#include "SIDBlasterAPI.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define TRACE_FRAMES 100
+
+static int failed(const char* what) {
+    fprintf(stderr, "%s failed: %s\n", what, sidblaster_last_error());
+    return 1;
+}
+
+static uint8_t* readFile(const char* path, size_t* size) {
+    FILE* file = fopen(path, "rb");
+    uint8_t* data = NULL;
+    long length;
+
+    if (!file) {
+        return NULL;
+    }
+    if (fseek(file, 0, SEEK_END) == 0 && (length = ftell(file)) > 0 && fseek(file, 0, SEEK_SET) == 0) {
+        data = (uint8_t*)malloc((size_t)length);
+        if (data && fread(data, 1, (size_t)length, file) != (size_t)length) {
+            free(data);
+            data = NULL;
+        }
+        *size = (size_t)length;
+    }
+    fclose(file);
+    return data;
+}
+
+int main(int argc, char** argv) {
+    static const uint8_t notASID[] = { 'N', 'O', 'P', 'E' };
+    SIDBlasterTune* tune;
+    SIDBlasterInfo info;
+    SIDBlasterAnalysis analysis;
+    uint8_t* file;
+    uint8_t* trace = NULL;
+    size_t fileSize = 0;
+    size_t traceSize = 0;
+    size_t i;
+    int markers = 0;
+
+    if (argc != 2) {
+        fprintf(stderr, "Usage: sidblaster_capi <file.sid>\n");
+        return 2;
+    }
+
+    if (sidblaster_api_version() != SIDBLASTER_API_VERSION) {
+        fprintf(stderr, "API version mismatch\n");
+        return 1;
+    }
+
+    if (sidblaster_load(notASID, sizeof(notASID)) != NULL || sidblaster_last_error()[0] == '\0') {
+        fprintf(stderr, "Invalid data was accepted\n");
+        return 1;
+    }
+
+    file = readFile(argv[1], &fileSize);
+    if (!file) {
+        fprintf(stderr, "Failed to read %s\n", argv[1]);
+        return 1;
+    }
+    tune = sidblaster_load(file, fileSize);
+    free(file);
+    if (!tune) {
+        return failed("sidblaster_load");
+    }
+
+    if (sidblaster_get_info(tune, &info) != SIDBLASTER_OK) {
+        return failed("sidblaster_get_info");
+    }
+    if (info.dataSize == 0 || info.songs == 0 || info.playAddress == 0 || strlen(info.name) > 32) {
+        fprintf(stderr, "Unexpected header information\n");
+        return 1;
+    }
+
+    if (sidblaster_analyze(tune, TRACE_FRAMES, &analysis) != SIDBLASTER_OK) {
+        return failed("sidblaster_analyze");
+    }
+    if (analysis.frames != TRACE_FRAMES || analysis.maxCycles == 0 || analysis.averageCycles > analysis.maxCycles) {
+        fprintf(stderr, "Unexpected analysis\n");
+        return 1;
+    }
+
+    if (sidblaster_get_trace(tune, TRACE_FRAMES, &trace, &traceSize) != SIDBLASTER_OK) {
+        return failed("sidblaster_get_trace");
+    }
+    for (i = 0; i + 4 <= traceSize; i += 4) {
+        if (trace[i] == 0xFF && trace[i + 1] == 0xFF && trace[i + 2] == 0xFF && trace[i + 3] == 0xFF) {
+            ++markers;
+        }
+        else if (trace[i + 1] < 0xD4 || trace[i + 1] > 0xD7) {
+            fprintf(stderr, "Trace record %u is not a SID write\n", (unsigned)(i / 4));
+            return 1;
+        }
+    }
+    sidblaster_free_buffer(trace);
+    if (traceSize % 4 != 0 || markers != TRACE_FRAMES) {
+        fprintf(stderr, "Trace has %d frames, expected %d\n", markers, TRACE_FRAMES);
+        return 1;
+    }
+
+    sidblaster_free(tune);
+    printf("%s: %u cycles/frame max, %d frames traced\n", info.name, (unsigned)analysis.maxCycles, markers);
+    return 0;
+}
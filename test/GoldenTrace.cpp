@@ -0,0 +1,1443 @@
+// ==================================
+//             SIDBlaster
+//
+//  Raistlin / Genesis Project (G*P)
+// ==================================
+#include "Common.h"
+#include "cpu6510.h"
+#include "Disassembler.h"
+#include "MemoryAnalyzer.h"
+#include "PipelineStats.h"
+#include "RelocationUtils.h"
+#include "SIDBlasterUtils.h"
+#include "SIDEmulator.h"
+#include "SIDLoader.h"
+#include "app/JobServer.h"
+#include "app/PlayerWatcher.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#include <io.h>
+#define dup _dup
+#define dup2 _dup2
+#define close _close
+#else
+#include <unistd.h>
+#endif
+
+/**
+ * @file GoldenTrace.cpp
+ * @brief Golden-trace regression and throughput checks run by CTest
+ *
+ * A tune's behaviour is captured as one 32-bit digest per frame of the SID
+ * register writes its play routine makes (address and value, in order),
+ * starting from the init routine. Relocation must not change any of them.
+ *
+ *   record <sid> <golden>                          Write the golden digest file
+ *   check <sid> <golden>                           Compare a tune against its golden file
+ *   relocate <sid> <golden> <address> <kickass> <tempdir>
+ *                                                  Relocate, then compare the result
+ *   fixture <prg> <sid> <golden> <address>         Unpack a player-linked PRG built from
+ *                                                  <sid> at <address> and compare its music
+ *   allocations <sid-dir>                          Fail if a lean emulation frame allocates
+ *   stream <sid> <tempdir>                         Check SIDEmulator::frames() against runEmulation
+ *   throughput <sid-dir> <baseline> <max-drop-%>   Fail if instructions/sec dropped too far
+ *   recordthroughput <sid-dir> <baseline>          Write the throughput baseline file
+ *   serve                                          Check the -serve job translation and result lines
+ *   watch <sid>                                    Check how -watch sorts saves and patches the PRG
+ *   taint                                          Check where the taint engine traces pointer bytes to
+ *   staticcode                                     Check that static analysis rejects a path that
+ *                                                  decodes across an instruction it already found
+ *   coverage <sid>                                 Check that a short run plus static analysis finds
+ *                                                  all the code a full run executes
+ *   targets <sid> <golden> <addresses> <kickass> <tempdir>
+ *                                                  Check that one analysis written to several addresses
+ *                                                  matches one analysis per address, then relocate to
+ *                                                  all of them at once and compare each result
+ *   compact <sid> <golden> <kickass> <tempdir>     Check that only unused bytes are removed, then
+ *                                                  relocate with -compact and compare the result
+ *   scatter <sid> <golden> <windows> <kickass> <tempdir>
+ *                                                  Check that the segments cover the tune and fit into
+ *                                                  the windows, then scatter it and compare the result
+ *
+ * Exit codes: 0 = pass, 1 = fail, 77 = skipped.
+ */
+
+namespace fs = std::filesystem;
+using namespace sidblaster;
+
+namespace {
+
+    constexpr int GoldenFrames = 1500;        // 30 seconds at 50Hz
+    constexpr int AllocationFrames = 1000;    // Measured frames per tune in the allocation test
+    constexpr int StreamFrames = 500;         // Measured frames per tune in the frame stream test
+    constexpr int StreamWarmUpFrames = 50;    // Warm-up frames in the frame stream test (not the default)
+    constexpr int CoverageFrames = 300;       // Warm-up and measured frames of the short run in the coverage test
+    constexpr int TargetFrames = 300;         // Warm-up and measured frames of the targets, compact and scatter analyses
+    constexpr int ThroughputFrames = 5000;    // Play calls per tune when measuring throughput
+    constexpr int ThroughputRuns = 3;         // Timed runs (the median is used)
+    constexpr u64 MaxUnpackSteps = 50000000;  // Instruction limit for a fixture to unpack itself
+    constexpr int SkipTest = 77;              // CTest SKIP_RETURN_CODE
+
+    /**
+     * @brief A loaded tune with its own CPU
+     */
+    struct Tune {
+        std::unique_ptr<CPU6510> cpu = std::make_unique<CPU6510>();
+        std::unique_ptr<SIDLoader> sid = std::make_unique<SIDLoader>();
+    };
+
+    /**
+     * @brief Check for an RSID file, which SIDBlaster does not emulate
+     * @param file SID file
+     * @return True if the file has the RSID magic ID
+     */
+    bool isRSID(const fs::path& file) {
+        std::ifstream in(file, std::ios::binary);
+        char magic[4] = {};
+        in.read(magic, sizeof(magic));
+        return std::string(magic, sizeof(magic)) == "RSID";
+    }
+
+    /**
+     * @brief Load a SID file into a fresh CPU
+     * @param file SID file
+     * @param tune Receives the loaded tune
+     * @return True if loading succeeded
+     */
+    bool loadTune(const fs::path& file, Tune& tune) {
+        tune.cpu->reset();
+        tune.sid->setCPU(tune.cpu.get());
+        if (!tune.sid->loadSID(file.string())) {
+            std::cerr << "Failed to load " << file.string() << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    /**
+     * @brief Run init and then the play routine, digesting each frame's SID writes
+     * @param cpu CPU with the tune in memory
+     * @param initAddr Init routine
+     * @param playAddr Play routine
+     * @param frames Number of frames
+     * @return One FNV-1a digest per frame
+     */
+    std::vector<u32> digestFrames(CPU6510& cpu, u16 initAddr, u16 playAddr, int frames) {
+        u32 hash = 0;
+        const auto resetHash = [&hash]() { hash = 2166136261u; };
+        const auto mix = [&hash](u8 byte) { hash = (hash ^ byte) * 16777619u; };
+
+        cpu.setOnSIDWriteCallback([&](u16 addr, u8 value) {
+            mix(static_cast<u8>(addr & 0xFF));
+            mix(static_cast<u8>(addr >> 8));
+            mix(value);
+            });
+
+        // Clearing the registers leaves A = 0, so init starts the first song
+        cpu.resetRegistersAndFlags();
+        cpu.executeFunction(initAddr);
+
+        std::vector<u32> digests;
+        digests.reserve(frames);
+        for (int frame = 0; frame < frames; ++frame) {
+            resetHash();
+            cpu.resetRegistersAndFlags();
+            cpu.executeFunction(playAddr);
+            digests.push_back(hash);
+        }
+
+        cpu.setOnSIDWriteCallback(nullptr);
+        return digests;
+    }
+
+    /**
+     * @brief Digest a SID file from its own init and play addresses
+     */
+    bool digestSid(const fs::path& file, int frames, std::vector<u32>& digests) {
+        Tune tune;
+        if (!loadTune(file, tune)) {
+            return false;
+        }
+        digests = digestFrames(*tune.cpu, tune.sid->getInitAddress(), tune.sid->getPlayAddress(), frames);
+        return true;
+    }
+
+    /**
+     * @brief Write a golden digest file
+     */
+    bool writeGolden(const fs::path& file, const std::vector<u32>& digests) {
+        std::ofstream out(file);
+        if (!out) {
+            std::cerr << "Failed to create " << file.string() << std::endl;
+            return false;
+        }
+        out << "# SIDBlaster golden trace: one digest of SID register writes per frame\n";
+        out << "frames " << digests.size() << "\n";
+        out << std::hex << std::uppercase << std::setfill('0');
+        for (u32 digest : digests) {
+            out << std::setw(8) << digest << "\n";
+        }
+        return static_cast<bool>(out);
+    }
+
+    /**
+     * @brief Read a golden digest file
+     */
+    bool readGolden(const fs::path& file, std::vector<u32>& digests) {
+        std::ifstream in(file);
+        if (!in) {
+            std::cerr << "Missing golden file " << file.string() <<
+                " (build the update_golden target to create it)" << std::endl;
+            return false;
+        }
+
+        std::string line;
+        size_t frames = 0;
+        while (std::getline(in, line)) {
+            if (line.empty() || line[0] == '#') {
+                continue;
+            }
+            if (line.rfind("frames ", 0) == 0) {
+                frames = std::stoul(line.substr(7));
+                digests.reserve(frames);
+                continue;
+            }
+            digests.push_back(static_cast<u32>(std::stoul(line, nullptr, 16)));
+        }
+
+        if (digests.size() != frames) {
+            std::cerr << "Corrupt golden file " << file.string() << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    /**
+     * @brief Compare digests against a golden file and report the first difference
+     */
+    bool matchesGolden(const std::vector<u32>& digests, const fs::path& goldenFile, const std::string& what) {
+        std::vector<u32> golden;
+        if (!readGolden(goldenFile, golden)) {
+            return false;
+        }
+
+        const size_t frames = std::min(golden.size(), digests.size());
+        for (size_t frame = 0; frame < frames; ++frame) {
+            if (digests[frame] != golden[frame]) {
+                std::cerr << what << ": SID writes differ from " << goldenFile.filename().string()
+                    << " at frame " << frame << std::endl;
+                return false;
+            }
+        }
+        if (digests.size() != golden.size()) {
+            std::cerr << what << ": " << digests.size() << " frames, golden has " << golden.size() << std::endl;
+            return false;
+        }
+
+        std::cout << what << ": " << frames << " frames match " << goldenFile.filename().string() << std::endl;
+        return true;
+    }
+
+    /**
+     * @brief Parse a hex address with an optional $ or 0x prefix
+     */
+    u16 parseAddress(std::string text) {
+        if (!text.empty() && text[0] == '$') {
+            text.erase(0, 1);
+        }
+        return static_cast<u16>(std::stoul(text, nullptr, 16));
+    }
+
+    int record(const fs::path& sidFile, const fs::path& goldenFile) {
+        if (isRSID(sidFile)) {
+            std::cout << "Skipping RSID file " << sidFile.filename().string() << std::endl;
+            return 0;
+        }
+        std::vector<u32> digests;
+        if (!digestSid(sidFile, GoldenFrames, digests) || !writeGolden(goldenFile, digests)) {
+            return 1;
+        }
+        std::cout << "Recorded " << goldenFile.string() << std::endl;
+        return 0;
+    }
+
+    int check(const fs::path& sidFile, const fs::path& goldenFile) {
+        if (isRSID(sidFile)) {
+            std::cout << "RSID files cannot be emulated, skipping " << sidFile.filename().string() << std::endl;
+            return SkipTest;
+        }
+        std::vector<u32> digests;
+        if (!digestSid(sidFile, GoldenFrames, digests)) {
+            return 1;
+        }
+        return matchesGolden(digests, goldenFile, sidFile.filename().string()) ? 0 : 1;
+    }
+
+    int relocate(const fs::path& sidFile, const fs::path& goldenFile, u16 address,
+        const std::string& kickAss, const fs::path& tempDir) {
+        if (isRSID(sidFile)) {
+            std::cout << "RSID files cannot be emulated, skipping " << sidFile.filename().string() << std::endl;
+            return SkipTest;
+        }
+
+        const fs::path outputFile = tempDir /
+            (sidFile.stem().string() + "-" + util::wordToHex(address) + ".sid");
+
+        Tune tune;
+        util::RelocationParams params;
+        params.inputFile = sidFile;
+        params.outputFile = outputFile;
+        params.tempDir = tempDir;
+        params.relocationAddress = address;
+        params.kickAssPath = kickAss;
+
+        tune.sid->setCPU(tune.cpu.get());
+        tune.cpu->reset();
+        const util::RelocationResult result = util::relocateSID(tune.cpu.get(), tune.sid.get(), params);
+        if (!result.success) {
+            std::cerr << "Relocation to $" << util::wordToHex(address) << " failed: " << result.message << std::endl;
+            return 1;
+        }
+
+        std::vector<u32> digests;
+        if (!digestSid(outputFile, GoldenFrames, digests)) {
+            return 1;
+        }
+        return matchesGolden(digests, goldenFile,
+            sidFile.filename().string() + " at $" + util::wordToHex(address)) ? 0 : 1;
+    }
+
+    int fixture(const fs::path& prgFile, const fs::path& sidFile, const fs::path& goldenFile, u16 address) {
+        // The original tune gives the init and play offsets from the load address
+        Tune original;
+        if (!loadTune(sidFile, original)) {
+            return 1;
+        }
+        const u16 load = original.sid->getLoadAddress();
+        const u16 initAddr = static_cast<u16>(address + (original.sid->getInitAddress() - load));
+        const u16 playAddr = static_cast<u16>(address + (original.sid->getPlayAddress() - load));
+
+        std::ifstream in(prgFile, std::ios::binary);
+        std::vector<u8> prg((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        if (prg.size() < 3) {
+            std::cerr << "Failed to read " << prgFile.string() << std::endl;
+            return 1;
+        }
+
+        // Run the self-extracting decruncher from its BASIC SYS line; it unpacks
+        // the player and music and then hands over to the player
+        const u16 prgLoad = static_cast<u16>(prg[0] | (prg[1] << 8));
+        Tune tune;
+        tune.cpu->reset();
+        tune.cpu->copyMemoryBlock(prgLoad, std::span<const u8>(prg).subspan(2));
+
+        const std::string basic(prg.begin() + 2, prg.end());
+        const size_t sys = basic.find('\x9E');
+        if (sys == std::string::npos) {
+            std::cerr << prgFile.filename().string() << " has no SYS line" << std::endl;
+            return 1;
+        }
+        const u16 entry = static_cast<u16>(std::stoul(basic.substr(sys + 1)));
+        tune.cpu->resetRegistersAndFlags();
+        tune.cpu->setSP(0xFF);
+        tune.cpu->setPC(entry);
+
+        // Unpacking takes far longer than executeFunction allows, so step until
+        // the player calls the relocated init routine
+        u64 steps = 0;
+        while (tune.cpu->getPC() != initAddr) {
+            if (++steps > MaxUnpackSteps) {
+                std::cerr << prgFile.filename().string() << " never called init at $"
+                    << util::wordToHex(initAddr) << std::endl;
+                return 1;
+            }
+            // Players wait for a raster line before starting, so keep one moving
+            const u16 rasterLine = static_cast<u16>((steps / 16) % 312);
+            tune.cpu->writeByte(0xD012, static_cast<u8>(rasterLine));
+            tune.cpu->writeByte(0xD011, static_cast<u8>((tune.cpu->readMemory(0xD011) & 0x7F) | ((rasterLine >> 1) & 0x80)));
+            tune.cpu->step();
+        }
+
+        const auto digests = digestFrames(*tune.cpu, initAddr, playAddr, GoldenFrames);
+        return matchesGolden(digests, goldenFile, prgFile.filename().string()) ? 0 : 1;
+    }
+
+    /**
+     * @brief List the SID files SIDBlaster can emulate in a directory
+     * @param sidDir Directory to scan
+     * @return PSID files in name order
+     */
+    std::vector<fs::path> corpusFiles(const fs::path& sidDir) {
+        std::vector<fs::path> files;
+        for (const auto& entry : fs::directory_iterator(sidDir)) {
+            if (entry.path().extension() == ".sid" && !isRSID(entry.path())) {
+                files.push_back(entry.path());
+            }
+        }
+        std::sort(files.begin(), files.end());
+        return files;
+    }
+
+    int allocations(const fs::path& sidDir) {
+        util::PipelineStats::enable();
+
+        int failures = 0;
+        for (const auto& file : corpusFiles(sidDir)) {
+            Tune tune;
+            if (!loadTune(file, tune)) {
+                return 1;
+            }
+
+            // Lean mode: no trace, tracking, profile or heat map
+            SIDEmulator emulator(tune.cpu.get(), tune.sid.get());
+            SIDEmulator::EmulationOptions options;
+            options.frames = AllocationFrames;
+            if (!emulator.runEmulation(options)) {
+                std::cerr << file.filename().string() << ": emulation failed" << std::endl;
+                return 1;
+            }
+
+            // The "frames" phase covers the measured frames after warm-up
+            const auto& stages = util::PipelineStats::getStages();
+            const auto frames = std::find_if(stages.rbegin(), stages.rend(), [](const auto& stage) {
+                return stage.category == "emulation" && stage.name == "frames";
+                });
+            if (frames == stages.rend()) {
+                std::cerr << "No frames phase was recorded" << std::endl;
+                return 1;
+            }
+
+            if (frames->allocations != 0) {
+                std::cerr << file.filename().string() << ": " << frames->allocations << " allocations ("
+                    << frames->allocatedBytes << " bytes) in " << frames->frames << " frames" << std::endl;
+                ++failures;
+            }
+        }
+
+        if (failures > 0) {
+            return 1;
+        }
+        std::cout << "No heap allocations in " << AllocationFrames << " frames of any tune" << std::endl;
+        return 0;
+    }
+
+    int stream(const fs::path& file, const fs::path& tempDir) {
+        if (isRSID(file)) {
+            std::cout << "RSID files cannot be emulated, skipping " << file.filename().string() << std::endl;
+            return SkipTest;
+        }
+
+        const std::string name = file.filename().string();
+        const fs::path emulatedTrace = tempDir / (file.stem().string() + "-emulated.trace");
+        const fs::path streamedTrace = tempDir / (file.stem().string() + "-streamed.trace");
+
+        // Reference: runEmulation's own trace
+        Tune tune;
+        if (!loadTune(file, tune)) {
+            return 1;
+        }
+
+        SIDEmulator::EmulationOptions options;
+        options.frames = StreamFrames;
+        options.warmUpFrames = StreamWarmUpFrames;
+        options.traceEnabled = true;
+        options.traceLogPath = emulatedTrace.string();
+        {
+            // The trace is complete once the emulator that owns it is gone
+            SIDEmulator emulator(tune.cpu.get(), tune.sid.get());
+            if (!emulator.runEmulation(options)) {
+                std::cerr << name << ": emulation failed" << std::endl;
+                return 1;
+            }
+        }
+
+        // The same trace rebuilt from the frame stream. runEmulation writes no
+        // marker after the first init, so neither does this
+        if (!loadTune(file, tune)) {
+            return 1;
+        }
+        const std::vector<u8> memoryBefore(tune.cpu->getMemory().begin(), tune.cpu->getMemory().end());
+        SIDEmulator emulator(tune.cpu.get(), tune.sid.get());
+        {
+            TraceLogger log(streamedTrace.string(), TraceFormat::Binary);
+            int streamed = 0;
+            for (const auto& frame : emulator.frames(options)) {
+                for (const auto& write : frame.writes) {
+                    log.logSIDWrite(write.addr, write.value);
+                }
+                if (streamed++ > 0) {
+                    log.logFrameMarker();
+                }
+            }
+        }
+
+        std::ifstream emulatedIn(emulatedTrace, std::ios::binary);
+        std::ifstream streamedIn(streamedTrace, std::ios::binary);
+        const std::vector<char> emulatedBytes((std::istreambuf_iterator<char>(emulatedIn)), std::istreambuf_iterator<char>());
+        const std::vector<char> streamedBytes((std::istreambuf_iterator<char>(streamedIn)), std::istreambuf_iterator<char>());
+        if (emulator.frameStreamFailed() || emulatedBytes != streamedBytes) {
+            std::cerr << name << ": frame stream differs from runEmulation's trace" << std::endl;
+            return 1;
+        }
+
+        // Stopping early must leave memory as it was before the stream started
+        {
+            auto frames = emulator.frames(options);
+            int pulled = 0;
+            for (auto it = frames.begin(); it != frames.end() && pulled < 10; ++it) {
+                ++pulled;
+            }
+        }
+        const auto memoryAfter = tune.cpu->getMemory();
+        if (!std::equal(memoryBefore.begin(), memoryBefore.end(), memoryAfter.begin(), memoryAfter.end())) {
+            std::cerr << name << ": memory not restored after stopping the frame stream early" << std::endl;
+            return 1;
+        }
+        std::cout << name << ": frame stream matches runEmulation's trace" << std::endl;
+        return 0;
+    }
+
+    /**
+     * @brief Measure how fast the corpus plays
+     * @param sidDir Directory of SID files
+     * @param rate Receives the median instructions per second
+     * @return True if every tune loaded
+     */
+    bool measureThroughput(const fs::path& sidDir, double& rate) {
+        const std::vector<fs::path> files = corpusFiles(sidDir);
+
+        // Load and initialise everything up front so only play calls are timed
+        std::vector<std::unique_ptr<Tune>> tunes;
+        std::vector<std::unique_ptr<CPUSnapshot>> starts;
+        for (const auto& file : files) {
+            auto tune = std::make_unique<Tune>();
+            if (!loadTune(file, *tune)) {
+                return false;
+            }
+            tune->cpu->resetRegistersAndFlags();
+            tune->cpu->executeFunction(tune->sid->getInitAddress());
+            starts.push_back(std::make_unique<CPUSnapshot>());
+            tune->cpu->captureSnapshot(*starts.back());
+            tunes.push_back(std::move(tune));
+        }
+
+        std::vector<double> rates;
+        for (int run = 0; run < ThroughputRuns; ++run) {
+            u64 instructions = 0;
+            const auto begin = std::chrono::steady_clock::now();
+            for (size_t i = 0; i < tunes.size(); ++i) {
+                CPU6510& cpu = *tunes[i]->cpu;
+                const u16 playAddr = tunes[i]->sid->getPlayAddress();
+                cpu.restoreSnapshot(*starts[i]);
+                const u64 before = cpu.getInstructionCount();
+                for (int frame = 0; frame < ThroughputFrames; ++frame) {
+                    cpu.resetRegistersAndFlags();
+                    cpu.executeFunction(playAddr);
+                }
+                instructions += cpu.getInstructionCount() - before;
+            }
+            const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+            rates.push_back(static_cast<double>(instructions) / seconds);
+        }
+        std::sort(rates.begin(), rates.end());
+        rate = rates[rates.size() / 2];
+        return true;
+    }
+
+    int recordThroughput(const fs::path& sidDir, const fs::path& baselineFile) {
+        double rate = 0.0;
+        if (!measureThroughput(sidDir, rate)) {
+            return 1;
+        }
+        std::ofstream out(baselineFile);
+        out << std::fixed << std::setprecision(0) << rate << "\n";
+        std::cout << "Recorded " << std::fixed << std::setprecision(0) << rate
+            << " instructions/sec to " << baselineFile.string() << std::endl;
+        return out ? 0 : 1;
+    }
+
+    int throughput(const fs::path& sidDir, const fs::path& baselineFile, double maxDropPercent) {
+        // Without a stored baseline there is nothing to compare against
+        std::ifstream in(baselineFile);
+        double baseline = 0.0;
+        if (!(in >> baseline) || baseline <= 0.0) {
+            std::cout << "No throughput baseline in " << baselineFile.string()
+                << ", skipping (record one with the update_throughput_baseline target)" << std::endl;
+            return SkipTest;
+        }
+
+        double rate = 0.0;
+        if (!measureThroughput(sidDir, rate)) {
+            return 1;
+        }
+
+        const double dropPercent = 100.0 * (baseline - rate) / baseline;
+        std::cout << std::fixed << std::setprecision(0) << "Throughput: " << rate << " instructions/sec, baseline "
+            << baseline << std::setprecision(1) << " (" << -dropPercent << "%)" << std::endl;
+        if (dropPercent > maxDropPercent) {
+            std::cerr << "Throughput dropped " << dropPercent << "% (limit " << maxDropPercent << "%)" << std::endl;
+            return 1;
+        }
+        return 0;
+    }
+
+    int serve() {
+        // Each job line, and the result line the server must answer it with
+        struct ServeCase {
+            const char* job;
+            const char* result;
+        };
+        const ServeCase cases[] = {
+            { R"({"id": 1, "command": "relocate", "address": "$2000", "input": "a.sid", "output": "b.sid", "noverify": true})",
+              R"({"id":1,"command":"relocate","ok":true,"exitCode":0,"output":"relocate a.sid b.sid relocateaddr=$2000 +noverify\n"})" },
+            { R"({"id": "t", "command": "trace", "tracelog": "x.txt", "frames": 100, "force": false, "input": "a.sid"})",
+              R"({"id":"t","command":"trace","ok":true,"exitCode":0,"output":"trace a.sid - frames=100 traceformat=text tracelog=x.txt\n"})" },
+            { R"({"command": "player", "input": "caf\u00e9.sid", "output": "c.prg"})",
+              R"({"id":null,"command":"player","ok":false,"exitCode":3,"output":"player café.sid c.prg\n"})" },
+            { R"({"id": 4, "command": "relocate", "input": "a.sid"})",
+              R"({"id":4,"command":null,"ok":false,"exitCode":1,"error":"relocate needs an \"address\""})" },
+            { R"({"id": 5, "command": "trace", "stats": "s.json"})",
+              R"({"id":5,"command":null,"ok":false,"exitCode":1,"error":"\"stats\" applies to the whole server and cannot be set per job"})" },
+            { R"({"id": 6, "command": "disassemble", "input": {"nested": 1}})",
+              R"json({"id":null,"command":null,"ok":false,"exitCode":1,"error":"Unsupported value for \"input\" (only strings, numbers, true, false and null)"})json" },
+            { R"({"id": 7, "command": "quit"})",
+              R"({"id":7,"command":"quit","ok":true,"exitCode":0})" },
+            { R"({"id": 8, "command": "trace", "input": "never.sid"})", nullptr },
+        };
+
+        // A stand-in for the app that prints what it was asked to run
+        JobServer server("SIDBlaster", [](const CommandClass& command) {
+            static const char* const names[] = { "player", "relocate", "disassemble", "trace", "serve", "help", "unknown" };
+            std::cout << names[static_cast<int>(command.getType())] << " " << command.getInputFile() << " "
+                << (command.getOutputFile().empty() ? "-" : command.getOutputFile());
+            for (const char* key : { "frames", "relocateaddr", "traceformat", "tracelog" }) {
+                if (command.hasParameter(key)) {
+                    std::cout << " " << key << "=" << command.getParameter(key);
+                }
+            }
+            if (command.hasFlag("noverify")) {
+                std::cout << " +noverify";
+            }
+            std::cout << std::endl;
+            return command.getType() == CommandClass::Type::Player ? 3 : 0;
+            });
+
+        std::string jobs;
+        for (const ServeCase& serveCase : cases) {
+            jobs += std::string(serveCase.job) + "\n\n";
+        }
+        std::istringstream in(jobs);
+        std::ostringstream out;
+        const int failedJobs = server.run(in, out);
+
+        // The timings vary, so they are dropped before comparing
+        std::istringstream results(out.str());
+        std::string line;
+        int failures = 0;
+        for (const ServeCase& serveCase : cases) {
+            if (!serveCase.result) {
+                break;
+            }
+            if (!std::getline(results, line)) {
+                std::cerr << "No result for job " << serveCase.job << std::endl;
+                return 1;
+            }
+            const size_t ms = line.find(",\"ms\":");
+            if (ms != std::string::npos) {
+                line.erase(ms, line.find_first_of(",}", ms + 1) - ms);
+            }
+            if (line != serveCase.result) {
+                std::cerr << "Job:      " << serveCase.job << "\nExpected: " << serveCase.result
+                    << "\nGot:      " << line << std::endl;
+                ++failures;
+            }
+        }
+        if (std::getline(results, line)) {
+            std::cerr << "Job after quit was run: " << line << std::endl;
+            ++failures;
+        }
+        if (failedJobs != 4) {
+            std::cerr << "Server counted " << failedJobs << " failed jobs, expected 4" << std::endl;
+            ++failures;
+        }
+
+        // A tool a job runs writes to stdout itself; none of it may reach the result stream
+        const fs::path streamFile = fs::temp_directory_path() / "sidblaster-serve-stream.txt";
+        JobServer toolServer("SIDBlaster", [](const CommandClass&) {
+            return std::system("echo tool output");
+            });
+        std::istringstream toolJobs(R"({"id": 9, "command": "disassemble", "input": "a.sid", "output": "a.asm"})");
+        std::cout.flush();
+        std::fflush(stdout);
+        const int realStdout = dup(1);
+        std::FILE* stream = std::fopen(streamFile.string().c_str(), "wb");
+        if (realStdout < 0 || !stream) {
+            std::cerr << "Could not redirect stdout to " << streamFile.string() << std::endl;
+            return 1;
+        }
+        dup2(fileno(stream), 1);
+        toolServer.run(toolJobs, std::cout);
+        std::cout.flush();
+        std::fflush(stdout);
+        dup2(realStdout, 1);
+        close(realStdout);
+        std::fclose(stream);
+
+        std::ifstream streamIn(streamFile, std::ios::binary);
+        const std::string streamText((std::istreambuf_iterator<char>(streamIn)), std::istreambuf_iterator<char>());
+        streamIn.close();
+        fs::remove(streamFile);
+        if (streamText.find("tool output") != std::string::npos || streamText.rfind("{\"id\":9,", 0) != 0 ||
+            std::count(streamText.begin(), streamText.end(), '\n') != 1) {
+            std::cerr << "Result stream of a job that runs a tool:\n" << streamText << std::endl;
+            ++failures;
+        }
+
+        if (failures > 0) {
+            return 1;
+        }
+        std::cout << "Job server results match" << std::endl;
+        return 0;
+    }
+
+    int watch(const fs::path& sidFile) {
+        using Change = PlayerWatcher::Change;
+
+        std::ifstream in(sidFile, std::ios::binary);
+        const std::vector<u8> file((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+
+        // The reference analysis: everything the tune executes in the checked frames
+        Tune tune;
+        PlayerWatcher::TuneImage built;
+        const std::vector<u8> anything(65536, static_cast<u8>(MemoryAccessFlag::Execute));
+        if (!PlayerWatcher::loadImage(file, *tune.cpu, *tune.sid, built) ||
+            !PlayerWatcher::staysInAnalyzedCode(*tune.cpu, *tune.sid, anything, PlayerWatcher::CoverageFrames)) {
+            std::cerr << "Cannot run " << sidFile.string() << std::endl;
+            return 1;
+        }
+        const auto accessFlags = tune.cpu->getMemoryAccess();
+        const std::vector<u8> analysis(accessFlags.begin(), accessFlags.end());
+        const auto executed = [&analysis](u16 address) {
+            return (analysis[address] & static_cast<u8>(MemoryAccessFlag::Execute)) != 0;
+        };
+
+        // A byte the player reads but never executes, and one of its instructions
+        int dataIndex = -1;
+        int codeIndex = -1;
+        for (int i = 0; i < built.dataSize; ++i) {
+            const u16 address = static_cast<u16>(built.loadAddress + i);
+            if (dataIndex < 0 && !executed(address) && (analysis[address] & static_cast<u8>(MemoryAccessFlag::Read))) {
+                dataIndex = i;
+            }
+            if (codeIndex < 0 && executed(address)) {
+                codeIndex = i;
+            }
+        }
+        if (dataIndex < 0 || codeIndex < 0) {
+            std::cerr << "No data table or code found in " << sidFile.string() << std::endl;
+            return 1;
+        }
+
+        const auto edited = [&built](size_t offset) {
+            PlayerWatcher::TuneImage image = built;
+            image.file[offset] ^= 0x01;
+            return image;
+        };
+        const PlayerWatcher::TuneImage dataEdit = edited(built.dataOffset + dataIndex);
+
+        int failures = 0;
+        const auto expect = [&failures](bool passed, const char* what) {
+            if (!passed) {
+                std::cerr << "Failed: " << what << std::endl;
+                ++failures;
+            }
+        };
+
+        expect(PlayerWatcher::classifyChange(built, built, analysis) == Change::None, "unchanged file");
+        expect(PlayerWatcher::classifyChange(built, dataEdit, analysis) == Change::DataOnly, "data table edit");
+        expect(PlayerWatcher::classifyChange(built, edited(built.dataOffset + codeIndex), analysis) == Change::Full,
+            "code edit");
+        expect(PlayerWatcher::classifyChange(built, edited(0x16), analysis) == Change::Full, "header edit");
+
+        PlayerWatcher::TuneImage longer = built;
+        longer.file.push_back(0);
+        ++longer.dataSize;
+        expect(PlayerWatcher::classifyChange(built, longer, analysis) == Change::Full, "longer file");
+
+        // The same tune stays inside its own analysis; with one instruction forgotten it does not
+        Tune rerun;
+        PlayerWatcher::TuneImage image;
+        expect(PlayerWatcher::loadImage(file, *rerun.cpu, *rerun.sid, image) &&
+            PlayerWatcher::staysInAnalyzedCode(*rerun.cpu, *rerun.sid, analysis, PlayerWatcher::CoverageFrames),
+            "coverage of the analyzed tune");
+        std::vector<u8> forgotten = analysis;
+        forgotten[built.loadAddress + codeIndex] = 0;
+        expect(PlayerWatcher::loadImage(file, *rerun.cpu, *rerun.sid, image) &&
+            !PlayerWatcher::staysInAnalyzedCode(*rerun.cpu, *rerun.sid, forgotten, PlayerWatcher::CoverageFrames),
+            "coverage with a forgotten instruction");
+
+        // The same goes for the memory it writes, which the player's helpful data lists
+        expect(PlayerWatcher::loadImage(file, *rerun.cpu, *rerun.sid, image) &&
+            PlayerWatcher::staysInAnalyzedCode(*rerun.cpu, *rerun.sid, analysis, PlayerWatcher::CoverageFrames) &&
+            PlayerWatcher::writesOnlyAnalyzedMemory(*rerun.cpu, analysis),
+            "writes of the analyzed tune");
+        const auto written = std::find_if(analysis.begin(), analysis.end(), [](u8 flags) {
+            return (flags & static_cast<u8>(MemoryAccessFlag::Write)) != 0;
+            });
+        std::vector<u8> unwritten = analysis;
+        if (written != analysis.end()) {
+            unwritten[written - analysis.begin()] &= static_cast<u8>(~static_cast<u8>(MemoryAccessFlag::Write));
+        }
+        expect(written != analysis.end() && !PlayerWatcher::writesOnlyAnalyzedMemory(*rerun.cpu, unwritten),
+            "writes with a forgotten address");
+        const std::string registerOrder = PlayerWatcher::registerWriteOrder(file);
+        expect(!registerOrder.empty() && PlayerWatcher::registerWriteOrder(file) == registerOrder,
+            "register write order of the same tune");
+
+        // A linked PRG: a player page in front of the music, more player code behind it
+        const u16 prgAddress = static_cast<u16>(built.loadAddress - 0x100);
+        std::vector<u8> prg = { static_cast<u8>(prgAddress & 0xFF), static_cast<u8>(prgAddress >> 8) };
+        prg.insert(prg.end(), 0x100, 0xEA);
+        prg.insert(prg.end(), built.music().begin(), built.music().end());
+        prg.insert(prg.end(), 0x20, 0x60);
+        std::vector<u8> expected = prg;
+        expected[2 + 0x100 + dataIndex] ^= 0x01;
+
+        expect(PlayerWatcher::patchLinkedPrg(prg, built.loadAddress, built.music(), dataEdit.music()) && prg == expected,
+            "patch the linked PRG");
+        expect(!PlayerWatcher::patchLinkedPrg(prg, built.loadAddress, built.music(), dataEdit.music()),
+            "patch a PRG that no longer holds the old music");
+        expect(!PlayerWatcher::patchLinkedPrg(prg, static_cast<u16>(prgAddress - 1), dataEdit.music(), built.music()),
+            "patch below the PRG");
+        prg.resize(prg.size() - 0x21);
+        expect(!PlayerWatcher::patchLinkedPrg(prg, built.loadAddress, dataEdit.music(), built.music()),
+            "patch past the end of the PRG");
+
+        if (failures > 0) {
+            return 1;
+        }
+        std::cout << "Watch change detection and PRG patching work" << std::endl;
+        return 0;
+    }
+
+    int taint() {
+        // A pointer built the usual ways: offset with ADC, moved through X and the stack,
+        // copied through a RAM variable, and added to an index
+        static const u8 program[] = {
+            0xA2, 0x00,             // $1000  ldx #$00
+            0xBD, 0x00, 0x11,       // $1002  lda $1100,x
+            0x18,                   // $1005  clc
+            0x6D, 0x02, 0x11,       // $1006  adc $1102
+            0x85, 0xFB,             // $1009  sta $fb
+            0xBD, 0x01, 0x11,       // $100B  lda $1101,x
+            0xAA,                   // $100E  tax
+            0x8A,                   // $100F  txa
+            0x48,                   // $1010  pha
+            0xA9, 0x00,             // $1011  lda #$00
+            0x68,                   // $1013  pla
+            0x85, 0xFC,             // $1014  sta $fc
+            0x8D, 0x80, 0x11,       // $1016  sta $1180
+            0xAD, 0x80, 0x11,       // $1019  lda $1180
+            0x85, 0xFE,             // $101C  sta $fe
+            0xAC, 0x03, 0x11,       // $101E  ldy $1103
+            0x98,                   // $1021  tya
+            0x18,                   // $1022  clc
+            0x6D, 0x00, 0x11,       // $1023  adc $1100
+            0x85, 0xFD,             // $1026  sta $fd
+            0xA9, 0x07,             // $1028  lda #$07
+            0x85, 0x02,             // $102A  sta $02
+            0x60                    // $102C  rts
+        };
+        static const u8 table[] = { 0x00, 0x20, 0x10, 0x04 };   // $1100
+
+        CPU6510 cpu;
+        cpu.reset();
+        for (size_t i = 0; i < std::size(program); ++i) {
+            cpu.writeByte(static_cast<u16>(0x1000 + i), program[i]);
+        }
+        for (size_t i = 0; i < std::size(table); ++i) {
+            cpu.writeByte(static_cast<u16>(0x1100 + i), table[i]);
+        }
+        if (!cpu.executeFunction(0x1000)) {
+            std::cerr << "Test program did not return" << std::endl;
+            return 1;
+        }
+
+        struct TaintCase {
+            u16 address;
+            int origin;     // -1 for no origin
+            const char* what;
+        };
+        static const TaintCase cases[] = {
+            { 0x00FB, 0x1100, "table byte offset with ADC" },
+            { 0x00FC, 0x1101, "table byte moved through X and the stack" },
+            { 0x00FE, 0x1101, "table byte copied through RAM" },
+            { 0x00FD, 0x1100, "index added to a table byte" },
+            { 0x0002, 0x1029, "immediate operand" },
+            { 0x00FF, -1, "byte that was never stored to" },
+        };
+
+        int failures = 0;
+        for (const TaintCase& taintCase : cases) {
+            const TaintTag tag = cpu.getTaint(taintCase.address);
+            const int origin = tag.isValid() ? tag.origin : -1;
+            if (origin != taintCase.origin) {
+                std::cerr << "Failed: " << taintCase.what << " ($" << util::wordToHex(taintCase.address)
+                    << "): origin " << origin << ", expected " << taintCase.origin << std::endl;
+                ++failures;
+            }
+        }
+
+        if (failures > 0) {
+            return 1;
+        }
+        std::cout << "Taint origins match" << std::endl;
+        return 0;
+    }
+
+    int staticCode() {
+        // Both sides of each branch that was never taken are followed. The path
+        // at $1004 is code; the one at $1008 jumps into the middle of it, where
+        // the operand byte $60 would decode as RTS
+        static const u8 program[] = {
+            0xA9, 0x00,             // $1000  lda #$00
+            0xF0, 0x0C,             // $1002  beq $1010 (always taken)
+            0xAD, 0x00, 0x60,       // $1004  lda $6000
+            0x60,                   // $1007  rts
+            0x4C, 0x06, 0x10,       // $1008  jmp $1006
+            0x00, 0x00, 0x00, 0x00, 0x00,
+            0xD0, 0xF6,             // $1010  bne $1008 (never taken)
+            0x60                    // $1012  rts
+        };
+        constexpr u16 ProgramStart = 0x1000;
+
+        CPU6510 cpu;
+        cpu.reset();
+        for (size_t i = 0; i < std::size(program); ++i) {
+            cpu.writeByte(static_cast<u16>(ProgramStart + i), program[i]);
+        }
+        if (!cpu.executeFunction(ProgramStart)) {
+            std::cerr << "Test program did not return" << std::endl;
+            return 1;
+        }
+
+        MemoryAnalyzer analyzer(cpu.getMemory(), cpu.getMemoryAccess(), ProgramStart,
+            static_cast<u16>(ProgramStart + std::size(program)));
+        analyzer.analyzeExecution();
+        const u16 entryPoints[] = { ProgramStart };
+        analyzer.analyzeStaticCode(cpu, entryPoints);
+
+        int failures = 0;
+        for (u16 addr = 0x1004; addr <= 0x100A; ++addr) {
+            const bool isCode = (analyzer.getMemoryType(addr) & MemoryType::Code) != 0;
+            if (isCode != (addr <= 0x1007)) {
+                std::cerr << "Failed: $" << util::wordToHex(addr) << (isCode ? " is" : " is not") << " code" << std::endl;
+                ++failures;
+            }
+        }
+
+        if (failures > 0) {
+            return 1;
+        }
+        std::cout << "Overlapping decode paths are rejected" << std::endl;
+        return 0;
+    }
+
+    /**
+     * @brief Emulate a tune the way a short disassembly run does
+     * @param file SID file
+     * @param frames Warm-up and measured frames
+     * @param tune Receives the emulated tune
+     * @param disassembler If not null, receives a disassembler that recorded the run
+     * @return 0 if the tune ran, SkipTest for RSID files, 1 on failure
+     */
+    int emulateTune(const fs::path& file, int frames, Tune& tune, std::unique_ptr<Disassembler>* disassembler) {
+        if (isRSID(file)) {
+            std::cout << "RSID files cannot be emulated, skipping " << file.filename().string() << std::endl;
+            return SkipTest;
+        }
+        if (!loadTune(file, tune)) {
+            return 1;
+        }
+        // The disassembler hooks the CPU, so it has to exist before the run
+        if (disassembler) {
+            *disassembler = std::make_unique<Disassembler>(*tune.cpu, *tune.sid);
+        }
+
+        SIDEmulator::EmulationOptions options;
+        options.frames = frames;
+        options.warmUpFrames = std::min(frames, SIDEmulator::WarmUpFrames);
+        SIDEmulator emulator(tune.cpu.get(), tune.sid.get());
+        if (!emulator.runEmulation(options)) {
+            std::cerr << file.filename().string() << ": emulation failed" << std::endl;
+            return 1;
+        }
+        return 0;
+    }
+
+    /**
+     * @brief Emulate a tune and classify its memory with static analysis added
+     * @param file SID file
+     * @param frames Warm-up and measured frames
+     * @param types Receives the memory types
+     * @param executed Receives whether each address was executed
+     * @return 0 if the tune ran, otherwise the exit code of emulateTune
+     */
+    int analyzeCoverage(const fs::path& file, int frames, std::vector<MemoryType>& types, std::vector<bool>& executed) {
+        Tune tune;
+        if (const int status = emulateTune(file, frames, tune, nullptr); status != 0) {
+            return status;
+        }
+
+        const u16 loadAddress = tune.sid->getLoadAddress();
+        MemoryAnalyzer analyzer(tune.cpu->getMemory(), tune.cpu->getMemoryAccess(),
+            loadAddress, static_cast<u16>(loadAddress + tune.sid->getDataSize()));
+        analyzer.analyzeExecution();
+        const u16 entryPoints[] = { tune.sid->getInitAddress(), tune.sid->getPlayAddress() };
+        analyzer.analyzeStaticCode(*tune.cpu, entryPoints);
+
+        const auto memoryTypes = analyzer.getMemoryTypes();
+        types.assign(memoryTypes.begin(), memoryTypes.end());
+        const auto access = tune.cpu->getMemoryAccess();
+        executed.resize(access.size());
+        for (size_t addr = 0; addr < access.size(); ++addr) {
+            executed[addr] = (access[addr] & static_cast<u8>(MemoryAccessFlag::Execute)) != 0;
+        }
+        return 0;
+    }
+
+    int coverage(const fs::path& file) {
+        std::vector<MemoryType> fullTypes, shortTypes;
+        std::vector<bool> fullExecuted, shortExecuted;
+        if (const int status = analyzeCoverage(file, DEFAULT_SID_EMULATION_FRAMES, fullTypes, fullExecuted); status != 0) {
+            return status;
+        }
+        if (const int status = analyzeCoverage(file, CoverageFrames, shortTypes, shortExecuted); status != 0) {
+            return status;
+        }
+
+        int missedByEmulation = 0;
+        int missed = 0;
+        int wronglyFound = 0;
+        for (size_t addr = 0; addr < fullExecuted.size(); ++addr) {
+            if (fullExecuted[addr] && !shortExecuted[addr]) {
+                ++missedByEmulation;
+                if (!(shortTypes[addr] & MemoryType::Code)) {
+                    ++missed;
+                }
+            }
+            // What static analysis adds must never be something the full run used as data only
+            if ((shortTypes[addr] & MemoryType::Unexecuted) && (fullTypes[addr] & MemoryType::Accessed) &&
+                !fullExecuted[addr] && !(fullTypes[addr] & MemoryType::Code)) {
+                ++wronglyFound;
+            }
+        }
+
+        const std::string name = file.filename().string();
+        if (missed > 0 || wronglyFound > 0) {
+            std::cerr << name << ": " << missed << " executed bytes not found as code, " << wronglyFound
+                << " data bytes taken for code" << std::endl;
+            return 1;
+        }
+        std::cout << name << ": static analysis found all " << missedByEmulation << " code bytes a "
+            << CoverageFrames << "-frame run missed" << std::endl;
+        return 0;
+    }
+
+    /**
+     * @brief Write the relocated assembly for an address
+     * @return Text of the written file
+     */
+    std::string writeAsm(Disassembler& disassembler, const SIDLoader& sid, const fs::path& asmFile, u16 address) {
+        const u16 load = sid.getLoadAddress();
+        disassembler.generateAsmFile(asmFile.string(), address,
+            static_cast<u16>(address + (sid.getInitAddress() - load)),
+            static_cast<u16>(address + (sid.getPlayAddress() - load)));
+
+        std::ifstream in(asmFile, std::ios::binary);
+        return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+
+    int targets(const fs::path& sidFile, const fs::path& goldenFile, const std::vector<u16>& addresses,
+        const std::string& kickAss, const fs::path& tempDir) {
+        const std::string name = sidFile.filename().string();
+
+        // Every address written from one analysis must match its own analysis
+        Tune shared;
+        std::unique_ptr<Disassembler> sharedDisassembler;
+        if (const int status = emulateTune(sidFile, TargetFrames, shared, &sharedDisassembler); status != 0) {
+            return status;
+        }
+        for (const u16 address : addresses) {
+            const std::string hex = util::wordToHex(address);
+            const std::string sharedAsm = writeAsm(*sharedDisassembler, *shared.sid, tempDir / ("shared-" + hex + ".asm"), address);
+
+            Tune single;
+            std::unique_ptr<Disassembler> singleDisassembler;
+            if (emulateTune(sidFile, TargetFrames, single, &singleDisassembler) != 0) {
+                return 1;
+            }
+            const std::string singleAsm = writeAsm(*singleDisassembler, *single.sid, tempDir / ("single-" + hex + ".asm"), address);
+            if (sharedAsm.empty() || sharedAsm != singleAsm) {
+                std::cerr << name << ": assembly for $" << hex << " differs when the analysis is shared" << std::endl;
+                return 1;
+            }
+        }
+        std::cout << name << ": one analysis writes the same assembly for " << addresses.size() << " addresses" << std::endl;
+
+        if (kickAss.empty()) {
+            std::cout << "Java/KickAss not available, skipping the relocation of all targets" << std::endl;
+            return SkipTest;
+        }
+
+        std::vector<util::RelocationTarget> relocationTargets;
+        for (const u16 address : addresses) {
+            relocationTargets.push_back({ address, tempDir / (sidFile.stem().string() + "-" + util::wordToHex(address) + ".sid") });
+        }
+        util::RelocationParams params;
+        params.inputFile = sidFile;
+        params.tempDir = tempDir;
+        params.kickAssPath = kickAss;
+
+        Tune tune;
+        tune.sid->setCPU(tune.cpu.get());
+        tune.cpu->reset();
+        const auto results = util::relocateSIDToTargets(tune.cpu.get(), tune.sid.get(), params, relocationTargets, true);
+
+        bool passed = true;
+        for (size_t i = 0; i < relocationTargets.size(); ++i) {
+            const std::string what = name + " at $" + util::wordToHex(relocationTargets[i].address);
+            if (!results[i].success || !results[i].verified || !results[i].outputsMatch) {
+                std::cerr << what << ": " << results[i].message << std::endl;
+                passed = false;
+                continue;
+            }
+            std::vector<u32> digests;
+            passed = digestSid(relocationTargets[i].outputFile, GoldenFrames, digests) &&
+                matchesGolden(digests, goldenFile, what) && passed;
+        }
+        return passed ? 0 : 1;
+    }
+
+    int compact(const fs::path& sidFile, const fs::path& goldenFile, const std::string& kickAss, const fs::path& tempDir) {
+        const std::string name = sidFile.filename().string();
+
+        // Only bytes the emulation never touched may be left out
+        Tune tune;
+        std::unique_ptr<Disassembler> disassembler;
+        if (const int status = emulateTune(sidFile, TargetFrames, tune, &disassembler); status != 0) {
+            return status;
+        }
+        disassembler->setCompaction(true);
+        disassembler->analyze();
+
+        const auto access = tune.cpu->getMemoryAccess();
+        int removed = 0;
+        for (const auto& [start, end] : disassembler->getRemovedRanges()) {
+            for (u32 addr = start; addr <= end; ++addr) {
+                if (access[addr] != 0) {
+                    std::cerr << name << ": removed byte $" << util::wordToHex(static_cast<u16>(addr))
+                        << " was used by the emulation" << std::endl;
+                    return 1;
+                }
+            }
+            removed += end - start + 1;
+        }
+        if (removed == 0) {
+            std::cerr << name << ": no unused bytes removed" << std::endl;
+            return 1;
+        }
+        const std::string text = writeAsm(*disassembler, *tune.sid, tempDir / "compact.asm", tune.sid->getLoadAddress());
+        if (text.find("//; " + std::to_string(removed) + " unused bytes removed") == std::string::npos) {
+            std::cerr << name << ": assembly does not report the " << removed << " removed bytes" << std::endl;
+            return 1;
+        }
+
+        // Only the line that ends the tune may be repeated (with an empty range); a line
+        // repeated before a removed run would move everything after it
+        const u32 tuneEnd = tune.sid->getLoadAddress() + tune.sid->getDataSize();
+        std::istringstream lines(text);
+        std::string line;
+        while (std::getline(lines, line)) {
+            const size_t range = line.find("//; $");
+            if (range == std::string::npos || line.size() < range + 16 || line.compare(range + 9, 3, " - ") != 0) {
+                continue;
+            }
+            const u32 first = std::stoul(line.substr(range + 5, 4), nullptr, 16);
+            const u32 last = std::stoul(line.substr(range + 12, 4), nullptr, 16);
+            if (last < first && first != tuneEnd) {
+                std::cerr << name << ": line repeated inside the tune: " << line << std::endl;
+                return 1;
+            }
+        }
+        std::cout << name << ": " << removed << " unused bytes removed, none of them used" << std::endl;
+
+        if (kickAss.empty()) {
+            std::cout << "Java/KickAss not available, skipping the compacted relocation" << std::endl;
+            return SkipTest;
+        }
+
+        const fs::path outputFile = tempDir / (sidFile.stem().string() + "-compact.sid");
+        util::RelocationParams params;
+        params.inputFile = sidFile;
+        params.outputFile = outputFile;
+        params.tempDir = tempDir;
+        params.relocationAddress = tune.sid->getLoadAddress();
+        params.kickAssPath = kickAss;
+        params.compact = true;
+
+        Tune relocated;
+        relocated.sid->setCPU(relocated.cpu.get());
+        relocated.cpu->reset();
+        const util::RelocationResult result = util::relocateSID(relocated.cpu.get(), relocated.sid.get(), params);
+        if (!result.success) {
+            std::cerr << name << ": compacted relocation failed: " << result.message << std::endl;
+            return 1;
+        }
+        if (result.bytesSaved <= 0 || result.memoryMap.size() < 2) {
+            std::cerr << name << ": compacted relocation saved " << result.bytesSaved << " bytes in "
+                << result.memoryMap.size() << " blocks" << std::endl;
+            return 1;
+        }
+
+        std::vector<u32> digests;
+        if (!digestSid(outputFile, GoldenFrames, digests)) {
+            return 1;
+        }
+        return matchesGolden(digests, goldenFile, name + " compacted") ? 0 : 1;
+    }
+
+    int scatter(const fs::path& sidFile, const fs::path& goldenFile, const std::vector<std::pair<u16, u16>>& windows,
+        const std::string& kickAss, const fs::path& tempDir) {
+        const std::string name = sidFile.filename().string();
+
+        Tune tune;
+        std::unique_ptr<Disassembler> disassembler;
+        if (const int status = emulateTune(sidFile, TargetFrames, tune, &disassembler); status != 0) {
+            return status;
+        }
+        disassembler->setScatterWindows(windows);
+        disassembler->analyze();
+
+        // The segments follow on from each other and cover the whole tune
+        const std::vector<MemorySegment>& segments = disassembler->getSegments();
+        if (segments.size() < 2) {
+            std::cerr << name << ": scattered into " << segments.size() << " segments" << std::endl;
+            return 1;
+        }
+        u32 expectedStart = tune.sid->getLoadAddress();
+        for (const MemorySegment& segment : segments) {
+            if (segment.originalStart != expectedStart || segment.originalEnd < segment.originalStart) {
+                std::cerr << name << ": segment $" << util::wordToHex(segment.originalStart) << "-$"
+                    << util::wordToHex(segment.originalEnd) << " does not follow on from $"
+                    << util::wordToHex(static_cast<u16>(expectedStart)) << std::endl;
+                return 1;
+            }
+            expectedStart = segment.originalEnd + 1u;
+        }
+        if (expectedStart != tune.sid->getLoadAddress() + tune.sid->getDataSize()) {
+            std::cerr << name << ": segments end at $" << util::wordToHex(static_cast<u16>(expectedStart - 1))
+                << " instead of the end of the tune" << std::endl;
+            return 1;
+        }
+
+        // Each segment lies inside a window, and none of them overlap
+        std::vector<u8> placed(0x10000, 0);
+        for (const MemorySegment& segment : segments) {
+            const u32 newEnd = segment.newStart + (segment.originalEnd - segment.originalStart);
+            const bool inWindow = std::any_of(windows.begin(), windows.end(), [&](const auto& window) {
+                return segment.newStart >= window.first && newEnd <= window.second;
+                });
+            if (!inWindow) {
+                std::cerr << name << ": segment at $" << util::wordToHex(segment.newStart)
+                    << " is not inside a window" << std::endl;
+                return 1;
+            }
+            for (u32 addr = segment.newStart; addr <= newEnd; ++addr) {
+                if (placed[addr]++) {
+                    std::cerr << name << ": segments overlap at $" << util::wordToHex(static_cast<u16>(addr)) << std::endl;
+                    return 1;
+                }
+            }
+        }
+
+        const std::string text = writeAsm(*disassembler, *tune.sid, tempDir / "scatter.asm", tune.sid->getLoadAddress());
+        for (const MemorySegment& segment : segments) {
+            if (text.find("* = $" + util::wordToHex(segment.newStart)) == std::string::npos) {
+                std::cerr << name << ": assembly has no origin for the segment at $"
+                    << util::wordToHex(segment.newStart) << std::endl;
+                return 1;
+            }
+        }
+        std::cout << name << ": scattered into " << segments.size() << " segments inside "
+            << windows.size() << " windows" << std::endl;
+
+        if (kickAss.empty()) {
+            std::cout << "Java/KickAss not available, skipping the scattered relocation" << std::endl;
+            return SkipTest;
+        }
+
+        const fs::path outputFile = tempDir / (sidFile.stem().string() + "-scatter.sid");
+        util::RelocationParams params;
+        params.inputFile = sidFile;
+        params.outputFile = outputFile;
+        params.tempDir = tempDir;
+        params.kickAssPath = kickAss;
+        params.windows = windows;
+
+        Tune relocated;
+        relocated.sid->setCPU(relocated.cpu.get());
+        relocated.cpu->reset();
+        const util::RelocationResult result = util::relocateSID(relocated.cpu.get(), relocated.sid.get(), params);
+        if (!result.success) {
+            std::cerr << name << ": scattered relocation failed: " << result.message << std::endl;
+            return 1;
+        }
+        if (result.memoryMap.size() < 2) {
+            std::cerr << name << ": scattered relocation wrote " << result.memoryMap.size() << " blocks" << std::endl;
+            return 1;
+        }
+
+        std::vector<u32> digests;
+        if (!digestSid(outputFile, GoldenFrames, digests)) {
+            return 1;
+        }
+        return matchesGolden(digests, goldenFile, name + " scattered") ? 0 : 1;
+    }
+
+    void printUsage(const char* programName) {
+        std::cerr << "Usage:\n"
+            << "  " << programName << " record <sid> <golden>\n"
+            << "  " << programName << " check <sid> <golden>\n"
+            << "  " << programName << " relocate <sid> <golden> <address> <kickass> <tempdir>\n"
+            << "  " << programName << " fixture <prg> <sid> <golden> <address>\n"
+            << "  " << programName << " allocations <sid-dir>\n"
+            << "  " << programName << " stream <sid> <tempdir>\n"
+            << "  " << programName << " throughput <sid-dir> <baseline> <max-drop-%>\n"
+            << "  " << programName << " recordthroughput <sid-dir> <baseline>\n"
+            << "  " << programName << " serve\n"
+            << "  " << programName << " watch <sid>\n"
+            << "  " << programName << " taint\n"
+            << "  " << programName << " staticcode\n"
+            << "  " << programName << " coverage <sid>\n"
+            << "  " << programName << " targets <sid> <golden> <addresses> <kickass> <tempdir>\n"
+            << "  " << programName << " compact <sid> <golden> <kickass> <tempdir>\n"
+            << "  " << programName << " scatter <sid> <golden> <windows> <kickass> <tempdir>\n";
+    }
+
+} // namespace
+
+/**
+ * @brief Test driver entry point
+ *
+ * @param argc Number of command line arguments
+ * @param argv Array of command line argument strings
+ * @return 0 on pass, 1 on failure, 77 if the test was skipped
+ */
+int main(int argc, char** argv) {
+    const std::vector<std::string> args(argv + 1, argv + argc);
+    if (args.empty()) {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    // Only errors from the code under test are of interest here
+    util::Logger::setLogLevel(util::Logger::Level::Error);
+
+    try {
+        const std::string& mode = args[0];
+        if (mode == "record" && args.size() == 3) {
+            return record(args[1], args[2]);
+        }
+        if (mode == "check" && args.size() == 3) {
+            return check(args[1], args[2]);
+        }
+        if (mode == "relocate" && args.size() == 6) {
+            if (args[4].empty()) {
+                std::cout << "Java/KickAss not available, skipping relocation check" << std::endl;
+                return SkipTest;
+            }
+            const fs::path tempDir = args[5];
+            fs::create_directories(tempDir);
+            return relocate(args[1], args[2], parseAddress(args[3]), args[4], tempDir);
+        }
+        if (mode == "fixture" && args.size() == 5) {
+            return fixture(args[1], args[2], args[3], parseAddress(args[4]));
+        }
+        if (mode == "allocations" && args.size() == 2) {
+            return allocations(args[1]);
+        }
+        if (mode == "stream" && args.size() == 3) {
+            const fs::path tempDir = args[2];
+            fs::create_directories(tempDir);
+            return stream(args[1], tempDir);
+        }
+        if (mode == "serve" && args.size() == 1) {
+            return serve();
+        }
+        if (mode == "watch" && args.size() == 2) {
+            return watch(args[1]);
+        }
+        if (mode == "coverage" && args.size() == 2) {
+            return coverage(args[1]);
+        }
+        if (mode == "targets" && args.size() == 6) {
+            const auto addresses = util::parseHexList(args[3]);
+            if (!addresses) {
+                std::cerr << "Invalid address list " << args[3] << std::endl;
+                return 1;
+            }
+            const fs::path tempDir = args[5];
+            fs::create_directories(tempDir);
+            return targets(args[1], args[2], *addresses, args[4], tempDir);
+        }
+        if (mode == "compact" && args.size() == 5) {
+            const fs::path tempDir = args[4];
+            fs::create_directories(tempDir);
+            return compact(args[1], args[2], args[3], tempDir);
+        }
+        if (mode == "scatter" && args.size() == 6) {
+            const auto windows = util::parseHexRangeList(args[3]);
+            if (!windows) {
+                std::cerr << "Invalid window list " << args[3] << std::endl;
+                return 1;
+            }
+            const fs::path tempDir = args[5];
+            fs::create_directories(tempDir);
+            return scatter(args[1], args[2], *windows, args[4], tempDir);
+        }
+        if (mode == "taint" && args.size() == 1) {
+            return taint();
+        }
+        if (mode == "staticcode" && args.size() == 1) {
+            return staticCode();
+        }
+        if (mode == "throughput" && args.size() == 4) {
+            return throughput(args[1], args[2], std::stod(args[3]));
+        }
+        if (mode == "recordthroughput" && args.size() == 3) {
+            return recordThroughput(args[1], args[2]);
+        }
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+
+    printUsage(argv[0]);
+    return 1;
+}